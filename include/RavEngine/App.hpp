@@ -191,21 +191,11 @@ struct AudioPlayer;
 			return renderWorld;
 		}
 		
-        inline void SwapCurrrentAudioSnapshot(){
-            audiomtx1.lock();
-            std::swap(acurrent,ainactive);
-            audiomtx1.unlock();
-        }
-        inline void SwapRenderAudioSnapshot(){
-            audiomtx2.lock();
-            std::swap(ainactive,arender);
-            audiomtx2.unlock();
-        }
-        inline AudioSnapshot* GetCurrentAudioSnapshot(){
-            return acurrent;
-        }
-        inline AudioSnapshot* GetRenderAudioSnapshot(){
-            return arender;
+        /**
+         @return the audio scene that the current world updates each tick and the audio thread renders
+         */
+        inline AudioSnapshotPublisher& GetAudioSnapshotPublisher(){
+            return audioSnapshots;
         }
 
 	private:
@@ -220,8 +210,7 @@ struct AudioPlayer;
 		
 		locked_hashset<Ref<World>,SpinLock> loadedWorlds;
         
-        AudioSnapshot a1, a2, a3, *acurrent = &a1, *ainactive = &a2, *arender = &a3;
-        SpinLock audiomtx1, audiomtx2;
+        AudioSnapshotPublisher audioSnapshots;
 	protected:
 		virtual AppConfig OnConfigure(int argc, char** argv) { return AppConfig{}; }
 		
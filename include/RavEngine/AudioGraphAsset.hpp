@@ -1,11 +1,14 @@
 #pragma once
 #include "AudioTypes.hpp"
+#include "AudioMixing.hpp"
 #include "DataStructures.hpp"
+#include "SpinLock.hpp"
 
 namespace RavEngine{
 
 struct AudioFilterLayer {
     virtual void process(const PlanarSampleBufferInlineView&, PlanarSampleBufferInlineView&) = 0;
+    virtual ~AudioFilterLayer(){}
 };
 
 /**
@@ -16,24 +19,126 @@ struct AudioGainFilterLayer : public AudioFilterLayer {
     void process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out) final {
         for (int c = 0; c < in.GetNChannels(); c++) {
             auto channel = in[c];
-#pragma omp simd
-            for (int i = 0; i < channel.size(); i++) {
-                out[c][i] = channel[i] * gain;
-            }
+            AudioMixing::CopyWithGain(out[c].data(), channel.data(), channel.size(), gain);
         }
     }
     AudioGainFilterLayer() {}
     AudioGainFilterLayer(float gain) : gain(gain) {}
 };
 
+/**
+ A second-order low-pass or high-pass filter, from the Audio EQ Cookbook. Parameters may be changed between buffers.
+ process() keeps its own state, so do not call it for two sources at once. An AudioGraphAsset keeps the state per voice instead.
+ */
+struct AudioBiquadFilterLayer : public AudioFilterLayer {
+    enum class Mode : uint8_t {
+        LowPass,
+        HighPass
+    } mode = Mode::LowPass;
+    float cutoff = 1000;            // in Hz
+    float q = 0.70710678f;          // resonance. 1/sqrt(2) is maximally flat.
+    uint32_t sampleRate = 0;        // 0 uses the AudioPlayer's rate
+    
+    struct Coefficients{
+        float b0, b1, b2, a1, a2;   // normalized so that a0 is 1
+    };
+    
+    AudioBiquadFilterLayer(Mode mode, float cutoff, float q = 0.70710678f, uint32_t sampleRate = 0) : mode(mode), cutoff(cutoff), q(q), sampleRate(sampleRate){}
+    
+    /**
+     @return the filter coefficients for the current parameters
+     */
+    Coefficients GetCoefficients() const;
+    
+    void process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out) final;
+    
+private:
+    Vector<float> history;          // z1 and z2 per channel, used by process()
+};
+
+/**
+ A feed-forward compressor with a peak envelope follower. Gain is reduced by ratio:1, in decibels, above threshold.
+ process() keeps its own state, so do not call it for two sources at once. An AudioGraphAsset keeps the state per voice instead.
+ */
+struct AudioCompressorFilterLayer : public AudioFilterLayer {
+    float threshold = 0.5f;         // linear amplitude above which the gain is reduced
+    float ratio = 4;                // decibels in above the threshold per decibel out
+    float attackSeconds = 0.005f;   // time for the envelope to rise
+    float releaseSeconds = 0.1f;    // time for the envelope to fall
+    float makeupGain = 1;           // linear gain applied after compression
+    uint32_t sampleRate = 0;        // 0 uses the AudioPlayer's rate
+    
+    AudioCompressorFilterLayer(float threshold = 0.5f, float ratio = 4, float makeupGain = 1) : threshold(threshold), ratio(ratio), makeupGain(makeupGain){}
+    
+    void process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out) final;
+    
+private:
+    Vector<float> envelope;         // per channel, used by process()
+};
+
+/**
+ A feedback delay (echo). Output is dry * input + wet * the line delayed by delaySeconds, and the line is fed with input + feedback * its delayed output.
+ process() keeps its own state, so do not call it for two sources at once. An AudioGraphAsset keeps the state per voice instead.
+ */
+struct AudioDelayFilterLayer : public AudioFilterLayer {
+    float delaySeconds = 0.25f;     // clamped to [1 sample, maxDelaySeconds]
+    float feedback = 0.3f;
+    float wet = 0.5f;
+    float dry = 1;
+    float maxDelaySeconds = 1;      // sizes the delay line. Read when the line is allocated, so changes have no effect after the first buffer.
+    uint32_t sampleRate = 0;        // 0 uses the AudioPlayer's rate
+    
+    AudioDelayFilterLayer(float delaySeconds = 0.25f, float feedback = 0.3f, float wet = 0.5f) : delaySeconds(delaySeconds), feedback(feedback), wet(wet){}
+    
+    void process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out) final;
+    
+private:
+    Vector<float> line;             // one ring of lineLength samples per channel, used by process()
+    size_t lineLength = 0;
+    size_t position = 0;
+};
+
 /**
 * Represents an audio effect graph processor. For a list of 
 * nodes, see https://developer.mozilla.org/en-US/docs/Web/API/Web_Audio_API
+* On first render, and whenever the list of filters changes, the list is compiled into a flat program:
+* built-in filters run without virtual dispatch, in place, with their state in one contiguous block owned
+* by the voice that renders the graph (an AudioGraphState), and consecutive gain layers are fused into a single
+* multiply. Other AudioFilterLayers are called through process() as before, so they must be safe to call for
+* several voices at once if the graph is shared.
+* The compiled program is never modified once published, so a graph may be rendered from several threads.
 */
 class AudioGraphAsset{
    
     uint8_t nchannels = 0;
     
+    struct CompiledNode{
+        enum class Kind : uint8_t{
+            Gain,
+            Biquad,
+            Compressor,
+            Delay,
+            Custom
+        } kind;
+        uint32_t firstLayer;        // index into layers
+        uint32_t nlayers;           // more than 1 for a fused gain chain
+        size_t stateOffset;         // index into AudioGraphState::values
+        size_t lineLength = 0;      // delay line length per channel
+    };
+    struct Program{
+        Vector<CompiledNode> nodes;
+        Vector<std::shared_ptr<AudioFilterLayer>> layers;
+        size_t stateSize = 0;
+        uint32_t sampleRate = 0;
+    };
+    std::shared_ptr<const Program> program;
+    SpinLock programLock;           // guards replacing program
+    AudioGraphState ownState;       // used by the Render overload that takes no state
+    
+    bool NeedsCompile(uint32_t sampleRate) const;
+    std::shared_ptr<const Program> Compile(uint32_t sampleRate) const;
+    std::shared_ptr<const Program> GetProgram(uint32_t sampleRate);
+    
 public:
 
     LinkedList<std::shared_ptr<AudioFilterLayer>> filters;
@@ -46,13 +151,25 @@ public:
     AudioGraphAsset(uint8_t nchannels);
     
     /**
-     Render the graph given input samples
-     @param inout input samples
-     @param scratch buffer
+     Render the graph given input samples. Safe to call from several threads at once with different states.
+     @param inout input samples, which are replaced with the output
+     @param scratchBuffer scratch space of the same size, used by filters that do not run in place
      @param nchannels the number of channels in the buffers
-     @post inout will be swapped with scratchBuffer. This is why they are passed by reference.
+     @param state the filter state of the voice being rendered. It is reset when the graph is recompiled.
+     */
+    void Render(PlanarSampleBufferInlineView& inout, PlanarSampleBufferInlineView& scratchBuffer, uint8_t nchannels, AudioGraphState& state);
+    
+    /**
+     Render the graph with a state owned by the graph. Only one thread may use this overload at a time.
+     */
+    void Render(PlanarSampleBufferInlineView& inout, PlanarSampleBufferInlineView& scratchBuffer, uint8_t nchannels){
+        Render(inout, scratchBuffer, nchannels, ownState);
+    }
+    
+    /**
+     Discard the graph's own state (delay lines, envelopes, filter history), as if the graph were new
      */
-    void Render(PlanarSampleBufferInlineView& inout, PlanarSampleBufferInlineView& scratchBuffer, uint8_t nchannels);
+    void Reset();
     
 };
 
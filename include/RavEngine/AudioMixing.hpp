@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace RavEngine{
+
+/**
+ Vectorized kernels for the inner loops of the audio mixer. SSE2 is used on x86, NEON on ARM,
+ and the Scalar versions everywhere else. Every kernel performs the same single floating-point
+ operation per sample as its Scalar counterpart, so the results are bit-identical across paths.
+ Buffers do not need to be aligned.
+ */
+namespace AudioMixing{
+
+    /**
+     dst[i] += src[i]
+     @param dst the buffer to accumulate into
+     @param src the samples to add
+     @param count the number of samples
+     */
+    void AdditiveBlend(float* dst, const float* src, size_t count);
+
+    /**
+     data[i] *= gain
+     @param data the samples to scale in place
+     @param count the number of samples
+     @param gain the multiplier
+     */
+    void ApplyGain(float* data, size_t count, float gain);
+
+    /**
+     dst[i] = src[i] * gain. dst and src may be the same buffer.
+     @param dst the destination
+     @param src the samples to scale
+     @param count the number of samples
+     @param gain the multiplier
+     */
+    void CopyWithGain(float* dst, const float* src, size_t count, float gain);
+
+    /**
+     Convert planar samples (LLLL...RRRR...) to interleaved (LRLR...), overwriting dst
+     @param dst the interleaved destination, of at least nframes * nchannels samples
+     @param planar the first channel of the planar source
+     @param channelStride the distance, in samples, between the start of each channel in planar
+     @param nframes the number of samples in each channel to convert
+     @param nchannels the number of channels
+     */
+    void PlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels);
+
+    /**
+     Convert planar samples to interleaved and add them to dst. Parameters are the same as PlanarToInterleaved.
+     */
+    void BlendPlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels);
+
+    /**
+     Convert interleaved samples (LRLR...) to planar (LLLL...RRRR...), overwriting the destination. The buffers must not overlap.
+     @param planar the first channel of the planar destination
+     @param channelStride the distance, in samples, between the start of each channel in planar
+     @param src the interleaved source, of at least nframes * nchannels samples
+     @param nframes the number of frames to convert
+     @param nchannels the number of channels
+     */
+    void InterleavedToPlanar(float* planar, size_t channelStride, const float* src, size_t nframes, uint8_t nchannels);
+
+    /**
+     Clamp samples in place. Matches std::clamp, including passing NaN through unchanged.
+     @param data the samples to clamp
+     @param count the number of samples
+     @param lo the lower bound
+     @param hi the upper bound
+     */
+    void Clamp(float* data, size_t count, float lo = -1.0f, float hi = 1.0f);
+
+    /**
+     @return the name of the instruction set the kernels were compiled for
+     */
+    const char* GetKernelName();
+
+    /**
+     Reference implementations. These are used on platforms without a vector path, and are
+     exposed so that the vector kernels can be verified against them.
+     */
+    namespace Scalar{
+        void AdditiveBlend(float* dst, const float* src, size_t count);
+        void ApplyGain(float* data, size_t count, float gain);
+        void CopyWithGain(float* dst, const float* src, size_t count, float gain);
+        void PlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels);
+        void BlendPlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels);
+        void InterleavedToPlanar(float* planar, size_t channelStride, const float* src, size_t nframes, uint8_t nchannels);
+        void Clamp(float* data, size_t count, float lo = -1.0f, float hi = 1.0f);
+    }
+}
+
+}
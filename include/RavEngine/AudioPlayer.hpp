@@ -5,6 +5,10 @@
 #include <taskflow/taskflow.hpp>
 #include <taskflow/core/worker.hpp>
 #include "DataStructures.hpp"
+#include "AudioVoiceManager.hpp"
+#include "AudioRoomRenderer.hpp"
+#include "AudioTypes.hpp"
+#include "Atomic.hpp"
 
 namespace RavEngine{
 
@@ -16,7 +20,7 @@ struct AudioDataProvider;
  Is responsible for making the buffers generated in the Audio Engine class come out your speakers
  */
 class AudioPlayer{
-	SDL_AudioDeviceID device;
+	SDL_AudioDeviceID device = 0;
 	WeakRef<World> worldToRender;
     uint64_t currentProcessingID = 0;
     
@@ -34,11 +38,20 @@ class AudioPlayer{
     tf::Executor audioExecutor;
     tf::Taskflow audioTaskflow;
     
-    AudioSnapshot* SnapshotToRender = nullptr;
+    const AudioSnapshot* SnapshotToRender = nullptr;
     ConcurrentQueue<tf::Future<void>> theFutures;
     
     void EnqueueAudioTasks();
-    UnorderedSet<Ref<AudioDataProvider>> alreadyTicked;
+    
+    AudioVoiceManager voiceManager;
+    LockFreeAtomic<AudioVoiceOptions> voiceOptions;
+    LockFreeAtomic<AudioVoiceManager::Statistics> voiceStatistics;
+    
+    AudioRoomRenderer roomRenderer;
+    std::atomic<uint32_t> roomWorkerCount = 2;
+    LockFreeAtomic<AudioRoomRenderer::Statistics> roomStatistics;
+    
+    AudioGraphState listenerGraphState;     // the listener graph is rendered only by Tick
     
 public:
     AudioPlayer();
@@ -76,6 +89,43 @@ public:
         return config_nbuffers;
     }
     
+    /**
+     Change the voice budget and fade settings. Takes effect on the next buffer.
+     @param options the new settings
+     */
+    inline void SetVoiceOptions(const AudioVoiceOptions& options){
+        voiceOptions.store(options);
+    }
+    
+    inline AudioVoiceOptions GetVoiceOptions() const{
+        return voiceOptions.load();
+    }
+    
+    /**
+     @return how many sources were real and virtual in the most recently rendered buffer
+     */
+    inline AudioVoiceManager::Statistics GetVoiceStatistics() const{
+        return voiceStatistics.load();
+    }
+    
+    /**
+     Set the number of threads that rooms are simulated on. Rooms are independent, so scenes with many rooms render faster with more workers. Takes effect on the next buffer.
+     The workers are started and stopped on the calling thread, while the audio callback waits, never on the callback itself.
+     @param nworkers the number of threads. 0 simulates every room on the audio callback thread.
+     */
+    void SetRoomWorkerCount(uint32_t nworkers);
+    
+    inline uint32_t GetRoomWorkerCount() const{
+        return roomWorkerCount;
+    }
+    
+    /**
+     @return timings of the room simulation in the most recently rendered buffer. The time of each room is available from AudioRoom::GetProcessingMicroseconds.
+     */
+    inline AudioRoomRenderer::Statistics GetRoomStatistics() const{
+        return roomStatistics.load();
+    }
+    
 	/**
 	 Tick function, used internally
 	 */
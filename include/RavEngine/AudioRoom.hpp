@@ -8,6 +8,7 @@
 #include "AudioSource.hpp"
 #include "Types.hpp"
 #include "DebugDrawer.hpp"
+#include <atomic>
 
 namespace RavEngine{
 
@@ -47,9 +48,14 @@ public:
 
         float reflection_scalar = 1, reverb_gain = 1, reverb_time = 1.0, reverb_brightness = 0;
         
+        uint16_t bufferSize = 0;
+        
+        // time spent adding emitters to and simulating this room in the most recent audio buffer
+        std::atomic<float> lastProcessingMicroseconds = 0;
+        
         /**
          Add an emitter for this simulation from arbitrary data
-         @param data the data buffer to pass. Must be AudioRoom::NFRAMES in length and represent MONO audio
+         @param data the data buffer to pass. Must be bufferSize in length and represent MONO audio
          @param pos location to play at
          @param rot rotation of the emitter
          @param roompos the worldspace location of the room
@@ -81,7 +87,18 @@ public:
          */
         void Simulate(PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratchBuffer);
         
+        /**
+         Create a room that renders at the AudioPlayer's format
+         */
         RoomData();
+        
+        /**
+         Create a room for an arbitrary format, such as for offline rendering
+         @param nchannels the number of output channels
+         @param bufferSize the number of frames in each buffer
+         @param sampleRate the sample rate
+         */
+        RoomData(uint8_t nchannels, uint16_t bufferSize, uint32_t sampleRate);
         ~RoomData(){
             delete audioEngine;
         }
@@ -101,6 +118,11 @@ public:
 	 */
     inline decltype(RoomData::roomDimensions) GetRoomDimensions() const {return data->roomDimensions; }
 	
+	/**
+	 @return the time, in microseconds, that the audio thread spent rendering this room in the most recent buffer
+	 */
+    inline float GetProcessingMicroseconds() const { return data->lastProcessingMicroseconds.load(); }
+	
 	/**
 	 @return a writable reference to the wall materials
 	 */
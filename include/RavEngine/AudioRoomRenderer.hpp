@@ -0,0 +1,83 @@
+#pragma once
+#include "AudioTypes.hpp"
+#include "DataStructures.hpp"
+#include "Function.hpp"
+#include <memory>
+
+namespace tf{
+class Executor;
+}
+
+namespace RavEngine{
+
+/**
+ Renders the rooms of a snapshot in parallel. Each room renders into its own planar buffer on a
+ worker thread, then the buffers are blended into the output on the calling thread in room order.
+ Because the reduction order does not depend on which worker finishes first, the output is
+ bit-identical to rendering the rooms one after another, for any worker count.
+ Not thread-safe. AudioPlayer owns one and uses it from the audio thread.
+ */
+class AudioRoomRenderer{
+public:
+    struct Statistics{
+        uint32_t nRooms = 0;
+        uint32_t nWorkers = 0;
+        float wallMicroseconds = 0;         // time spent in the last Render, including the reduction
+        float totalRoomMicroseconds = 0;    // the sum of every room's processing time, the cost of rendering serially
+        float maxRoomMicroseconds = 0;      // the slowest room, the lower bound on wallMicroseconds
+    };
+
+    /**
+     Render one room
+     @param room the index of the room
+     @param buffer the room's output. Zero-filled.
+     @param scratch scratch for the room's effect graph. Zero-filled.
+     */
+    using RenderRoomFn = Function<void(size_t room, PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratch)>;
+
+    /**
+     @param nworkers threads to render rooms on. 0 renders every room on the calling thread.
+     */
+    AudioRoomRenderer(uint32_t nworkers = 2);
+    ~AudioRoomRenderer();
+
+    /**
+     Change the number of worker threads. Waits for the current workers to exit.
+     @param nworkers threads to render rooms on. 0 renders every room on the calling thread.
+     */
+    void SetWorkerCount(uint32_t nworkers);
+
+    inline uint32_t GetWorkerCount() const{
+        return nworkers;
+    }
+
+    /**
+     Render every room and blend the results into an interleaved buffer
+     @param nrooms the number of rooms
+     @param renderRoom renders one room. Called concurrently for different rooms.
+     @param output the interleaved destination. The rooms are added to its contents.
+     @param nchannels the number of channels in output
+     */
+    void Render(size_t nrooms, const RenderRoomFn& renderRoom, InterleavedSampleBufferView output, uint8_t nchannels);
+
+    /**
+     @return the processing time of each room in the last Render, in microseconds, in room order
+     */
+    inline const Vector<float>& GetRoomMicroseconds() const{
+        return roomMicroseconds;
+    }
+
+    inline const Statistics& GetStatistics() const{
+        return statistics;
+    }
+
+private:
+    void RenderOne(size_t room, const RenderRoomFn& renderRoom, size_t nframes, uint8_t nchannels);
+
+    std::unique_ptr<tf::Executor> executor;
+    uint32_t nworkers = 0;
+    Vector<float> roomBuffers, scratchBuffers, roomMicroseconds;
+    Statistics statistics;
+};
+
+}
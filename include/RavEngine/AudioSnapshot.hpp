@@ -2,6 +2,9 @@
 #include "DataStructures.hpp"
 #include "AudioSource.hpp"
 #include "AudioRoom.hpp"
+#include "SpinLock.hpp"
+#include <array>
+#include <limits>
 
 namespace RavEngine{
 struct AudioGraphAsset;
@@ -11,43 +14,156 @@ struct AudioSnapshot{
         vector3 worldpos;
         quaternion worldrot;
     };
-    
+
     struct PointSource : public PointSourceBase{
         Ref<AudioDataProvider> data;
+        PointSource() = default;
         PointSource(const decltype(data)& data, const decltype(worldpos)& wp, const decltype(worldrot)& wr): data(data), PointSourceBase{wp, wr} {}
         bool operator==(const PointSource& other) const{
             return data == other.data && worldpos == other.worldpos && worldrot == other.worldrot;
         }
     };
-    
+
     struct Room{
         Ref<AudioRoom::RoomData> room;
         vector3 worldpos;
         quaternion worldrot;
+        Room() = default;
         Room(const decltype(room)& room,const decltype(worldpos)& wp, const decltype(worldrot)& wr): room(room), worldpos(wp), worldrot(wr){}
     };
-    
-    UnorderedSet<PointSource> sources;
-    UnorderedSet<Ref<AudioDataProvider>> ambientSources;
-    
+
+    Vector<PointSource> sources;
+    Vector<Ref<AudioDataProvider>> ambientSources;
+
     Vector<Room> rooms;
     vector3 listenerPos;
     quaternion listenerRot;
     Ref<AudioGraphAsset> listenerGraph;
-    
+
+    uint64_t generation = 0;    // the AudioSnapshotPublisher update this snapshot reflects
+
     void Clear(){
         sources.clear();
         ambientSources.clear();
         rooms.clear();
     }
 };
-}
 
-namespace std{
-    template<>
-    struct hash<RavEngine::AudioSnapshot::PointSource>{
-        inline size_t operator()(const RavEngine::AudioSnapshot::PointSource& obj){
-            return reinterpret_cast<size_t>(obj.data.get());
-        }
+/**
+ Keeps the audio scene between ticks and publishes it to the audio thread. Each tick, the world calls
+ BeginUpdate, reports every listener, source and room, then calls EndUpdate. Only entries that were
+ added, moved or removed are written, and anything not reported since BeginUpdate is removed.
+ Snapshots are triple-buffered: EndUpdate brings the spare snapshot up to date by copying only the
+ entries that changed since it was last published, then swaps it in with a pointer swap.
+ The update functions must be called from one thread at a time, except that UpdateSource,
+ UpdateAmbientSource and UpdateRoom may run concurrently with each other. AcquireLatest may be called
+ from any one other thread.
+ */
+class AudioSnapshotPublisher{
+public:
+    struct Statistics{
+        uint32_t nSources = 0;
+        uint32_t nAmbientSources = 0;
+        uint32_t nRooms = 0;
+        uint32_t nChanged = 0;      // entries added or moved in the last update
+        uint32_t nRemoved = 0;      // entries removed in the last update
+        uint32_t nCopied = 0;       // entries copied into the snapshot published by the last update
+    };
+
+    AudioSnapshotPublisher();
+
+    /**
+     Begin describing the scene for this tick
+     */
+    void BeginUpdate();
+
+    /**
+     @param worldpos the position of the listener
+     @param worldrot the rotation of the listener
+     @param graph the effect graph to apply to the final mix, if any
+     */
+    void SetListener(const vector3& worldpos, const quaternion& worldrot, const Ref<AudioGraphAsset>& graph);
+
+    /**
+     Report a point source. A source reported more than once keeps the last position.
+     @param provider the source's player, which identifies it between ticks
+     @param worldpos the position of the source
+     @param worldrot the rotation of the source
+     */
+    void UpdateSource(const Ref<AudioDataProvider>& provider, const vector3& worldpos, const quaternion& worldrot);
+
+    /**
+     Report an ambient source
+     @param provider the source's player, which identifies it between ticks
+     */
+    void UpdateAmbientSource(const Ref<AudioDataProvider>& provider);
+
+    /**
+     Report a room
+     @param room the room's data, which identifies it between ticks
+     @param worldpos the position of the room
+     @param worldrot the rotation of the room
+     */
+    void UpdateRoom(const Ref<AudioRoom::RoomData>& room, const vector3& worldpos, const quaternion& worldrot);
+
+    /**
+     Remove everything that was not reported since BeginUpdate, then publish the scene to the audio thread
+     */
+    void EndUpdate();
+
+    /**
+     Called by the audio thread to get the most recently published snapshot. The snapshot is valid until the next call.
+     @return the snapshot to render. Empty before the first EndUpdate.
+     */
+    const AudioSnapshot* AcquireLatest();
+
+    /**
+     @return counts from the most recent update. Call from the updating thread.
+     */
+    inline const Statistics& GetStatistics() const{
+        return statistics;
+    }
+
+private:
+    // a dense array that remembers which indices changed in which update, so that a copy made at an older update can be caught up
+    template<typename T>
+    struct TrackedArray{
+        Vector<T> values;
+        Vector<const void*> keys;
+        Vector<uint64_t> lastSeen;
+        UnorderedMap<const void*, uint32_t> indices;
+        Vector<std::pair<uint64_t, uint32_t>> changes;     // (generation, index), in generation order
+        uint64_t fullCopyBelow = 0;     // copies older than this generation predate the change log
+        uint32_t nChanged = 0, nRemoved = 0;
+
+        static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+        /**
+         Mark an entry as present this update
+         @return its index, or npos if it is new
+         */
+        uint32_t Touch(const void* key, uint64_t generation);
+        void Add(const void* key, T&& value, uint64_t generation);
+        void Set(uint32_t index, T&& value, uint64_t generation);
+        void RemoveUnseen(uint64_t generation);
+        uint32_t CopyTo(Vector<T>& copy, uint64_t copyGeneration) const;
+        void Prune(uint64_t oldestCopy, uint64_t generation);
     };
+
+    TrackedArray<AudioSnapshot::PointSource> sources;
+    TrackedArray<Ref<AudioDataProvider>> ambientSources;
+    TrackedArray<AudioSnapshot::Room> rooms;
+    vector3 listenerPos{0, 0, 0};
+    quaternion listenerRot{1, 0, 0, 0};
+    Ref<AudioGraphAsset> listenerGraph;
+    uint64_t generation = 0;
+    Statistics statistics;
+
+    std::array<AudioSnapshot, 3> snapshots;
+    AudioSnapshot* writing = &snapshots[0];
+    AudioSnapshot* latest = &snapshots[1];
+    AudioSnapshot* reading = &snapshots[2];
+    bool fresh = false;
+    SpinLock mtx;
+};
 }
@@ -7,6 +7,8 @@
 
 namespace RavEngine{
 
+class DiskCache;
+
 class AudioAsset{
 	friend class AudioEngine;
 	friend class AudioSyncSystem;
@@ -23,6 +25,15 @@ public:
 	 @param desired_channels the number of channels the file should have after loading
 	 */
 	AudioAsset(const std::string& name, decltype(nchannels) desired_channels = 1);
+
+	/**
+	 Construct an AudioAsset from an encoded file that is already in memory.
+	 @param encodedData the contents of the file
+	 @param extension the file extension, without the dot, which selects the decoder
+	 @param desired_channels the number of channels the file should have after loading
+	 @param sampleRate the rate to resample to
+	 */
+	AudioAsset(const std::vector<uint8_t>& encodedData, const std::string& extension, decltype(nchannels) desired_channels, uint32_t sampleRate);
 	
 	/**
 	 Use for generated audio. The AudioAsset assumes ownership of the data and will free it on destruction.
@@ -32,12 +43,26 @@ public:
 	 */
 	AudioAsset(InterleavedSampleBufferView interleavedData, decltype(nchannels) nchannels) : nchannels(nchannels){
 		audiodata = interleavedData.data();
-		data = PlanarSampleBufferInlineView{const_cast<float*>(audiodata),interleavedData.size(),nchannels };
+		data = PlanarSampleBufferInlineView{const_cast<float*>(audiodata),interleavedData.size(),interleavedData.size() / nchannels };
 		data.ImportInterleavedData(interleavedData, nchannels);
+		MemoryTracker::Allocated(MemoryTag::Audio, data.size() * sizeof(float));
     }
 	
 	~AudioAsset();
 	
+	/**
+	 Decoded and resampled samples are kept on disk, keyed by the contents of the encoded file, its format,
+	 the channel count and the sample rate, so that loading the same file again skips decoding and resampling.
+	 The cache lives in the temporary directory by default and is limited to 256 MiB. Use this to move, resize or
+	 disable it (by setting an empty directory).
+	 @return the cache used by the constructors that decode
+	 */
+	static DiskCache& GetDecodeCache();
+	
+private:
+	void Decode(const std::vector<uint8_t>& encodedData, const std::string& extension, decltype(nchannels) desired_channels, uint32_t sampleRate, const std::string& nameForErrors);
+public:
+	
 	inline double GetLength() const {return lengthSeconds;}
 	inline decltype(nchannels) GetNChanels() const {
 		return nchannels;
@@ -62,8 +87,9 @@ struct AudioRenderBuffer{
         float* scratch_impl = nullptr;
         uint8_t nchannels = 0;
         SingleRenderBuffer(uint16_t nsamples, uint8_t nchannels) : nchannels(nchannels){
-            data_impl = new float[nsamples * nchannels]{0};
-            scratch_impl = new float[nsamples * nchannels]{0};
+            // value-initialized rather than {0}, which throws for a size of 0 (when there is no audio device)
+            data_impl = new float[nsamples * nchannels]();
+            scratch_impl = new float[nsamples * nchannels]();
         }
         ~SingleRenderBuffer(){
             if (data_impl){
@@ -98,6 +124,7 @@ struct AudioDataProvider{
     
     AudioRenderBuffer renderData;
     float volume = 1;
+    float priority = 1;
     bool loops : 1 = false;
     bool isPlaying : 1 = false;
     
@@ -117,9 +144,25 @@ struct AudioDataProvider{
     
     virtual void Restart() = 0;
     
+    /**
+     Move the playhead forward as ProvideBufferData would, without producing any samples. Called instead of
+     ProvideBufferData while the source is virtualised by the AudioVoiceManager. Providers without a playhead
+     (such as generators) do not need to override this.
+     @param nframes the number of frames to skip
+     */
+    virtual void Advance(size_t nframes){}
     
     inline float GetVolume() const { return volume; }
     
+    inline float GetPriority() const { return priority; }
+    
+    /**
+     Change how important this source is when there are more sources than voices. Sources are ranked by
+     volume * priority * distance attenuation, and the lowest ranked are virtualised. See AudioVoiceOptions.
+     @param p the new priority. The default is 1.
+     */
+    inline void SetPriority(float p){ priority = p; }
+    
     /**
      Change the volume for this source
      @param vol new volume for this source.
@@ -177,6 +220,8 @@ struct SampledAudioDataProvider : public AudioGraphComposed, public AudioDataPro
      @param buffer output destination
      */
     void ProvideBufferData(PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratchSpace) final;
+    
+    void Advance(size_t nframes) final;
 };
 
 /**
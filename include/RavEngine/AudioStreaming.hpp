@@ -0,0 +1,165 @@
+#pragma once
+#include "AudioSource.hpp"
+#include "AudioTypes.hpp"
+#include "DataStructures.hpp"
+#include "Filesystem.hpp"
+#include <atomic>
+#include <memory>
+
+namespace RavEngine{
+
+class AudioStreamWorker;
+
+/**
+ A lock-free single-producer, single-consumer ring of planar audio frames. One thread may write
+ while another reads without locking. Capacity is rounded up to a power of two.
+ */
+class AudioRingBuffer{
+public:
+    /**
+     @param nchannels the number of channels in each frame
+     @param capacityFrames the minimum number of frames the ring can hold
+     */
+    AudioRingBuffer(uint8_t nchannels, size_t capacityFrames);
+
+    /**
+     Producer: copy frames into the ring
+     @param planar the first channel of the source
+     @param channelStride the distance, in samples, between channels in planar
+     @param nframes the number of frames to write
+     @return the number of frames written, which is less than nframes if the ring is full
+     */
+    size_t Write(const float* planar, size_t channelStride, size_t nframes);
+
+    /**
+     Consumer: copy frames out of the ring, scaling them by gain
+     @param dest the destination. Frames are written to each of its first GetNChannels() channels.
+     @param offset the frame in dest to begin writing at
+     @param nframes the number of frames to read
+     @param gain multiplier to apply
+     @return the number of frames read, which is less than nframes if the ring ran dry
+     */
+    size_t Read(PlanarSampleBufferInlineView& dest, size_t offset, size_t nframes, float gain = 1);
+
+    /**
+     Consumer: drop frames without copying them
+     @param nframes the number of frames to drop
+     @return the number of frames dropped, which is less than nframes if the ring ran dry
+     */
+    size_t Skip(size_t nframes);
+
+    /**
+     Consumer: drop every frame before a write position
+     @param position a value previously returned by GetWritePosition
+     */
+    void DiscardUntil(uint64_t position);
+
+    /**
+     @return the number of frames that can be read
+     */
+    inline size_t AvailableToRead() const{
+        return static_cast<size_t>(writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_acquire));
+    }
+
+    /**
+     @return the number of frames that can be written
+     */
+    inline size_t AvailableToWrite() const{
+        return capacity - AvailableToRead();
+    }
+
+    /**
+     @return the total number of frames ever written
+     */
+    inline uint64_t GetWritePosition() const{
+        return writePos.load(std::memory_order_acquire);
+    }
+
+    inline size_t GetCapacity() const{
+        return capacity;
+    }
+
+    inline uint8_t GetNChannels() const{
+        return nchannels;
+    }
+
+private:
+    TrackedVector<float, MemoryTag::Audio> storage;    // one run of `capacity` samples per channel
+    size_t capacity = 0;
+    size_t mask = 0;
+    uint8_t nchannels = 0;
+    alignas(64) std::atomic<uint64_t> writePos = 0;
+    alignas(64) std::atomic<uint64_t> readPos = 0;
+};
+
+struct StreamingAudioOptions{
+    size_t bufferFrames = 32768;    // decoded frames kept ahead of the playhead, about 0.7s at 44.1 kHz
+    size_t chunkFrames = 4096;      // source frames decoded per step
+    uint32_t sampleRate = 0;        // the rate to resample to. 0 uses the AudioPlayer's rate.
+};
+
+/**
+ Plays a long audio file without decoding it all up front. A shared background worker decodes and
+ resamples the file in chunks into a ring buffer, which ProvideBufferData consumes. Memory use is
+ bounded by the ring size regardless of the length of the file.
+ Supports uncompressed WAV (8, 16, 24 and 32-bit integer, 32 and 64-bit float). Use AudioAsset for other formats.
+ */
+struct StreamingAudioDataProvider : public AudioGraphComposed, public AudioDataProvider{
+    /**
+     @param path the file to stream. Files shipped as streaming assets are under VirtualFilesystem::GetStreamingAssetFullRootPath().
+     @param nchannels the number of channels to output. Mono and stereo files are converted as AudioAsset does.
+     @param options buffer sizes and output rate
+     */
+    StreamingAudioDataProvider(const Filesystem::Path& path, uint8_t nchannels = 1, const StreamingAudioOptions& options = {});
+    ~StreamingAudioDataProvider();
+
+    void ProvideBufferData(PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratchSpace) final;
+
+    /**
+     Consume frames from the buffer without copying them. Underruns are counted as in ProvideBufferData.
+     */
+    void Advance(size_t nframes) final;
+
+    /**
+     Seek to the beginning of the file. Output is silent until the worker has refilled the buffer. This does not trigger it to begin playing.
+     */
+    void Restart() final;
+
+    /**
+     @return the number of times ProvideBufferData found fewer decoded frames than it needed
+     */
+    size_t GetUnderrunCount() const;
+
+    /**
+     @return the total number of frames of silence output due to underruns
+     */
+    size_t GetUnderrunFrames() const;
+
+    /**
+     @return the number of decoded frames waiting to be played
+     */
+    size_t GetBufferedFrames() const;
+
+    /**
+     @return true once a non-looping stream has decoded all of its frames. Buffered frames may remain.
+     */
+    bool IsFullyDecoded() const;
+
+    /**
+     @return the length of the stream at the output rate, in frames
+     */
+    size_t GetNumFrames() const;
+
+    inline uint8_t GetNChannels() const{
+        return nchannels;
+    }
+
+private:
+    friend class AudioStreamWorker;
+    struct StreamState;
+    size_t Consume(PlanarSampleBufferInlineView* buffer, size_t nframes);
+    std::shared_ptr<StreamState> state;
+    uint8_t nchannels;
+};
+
+}
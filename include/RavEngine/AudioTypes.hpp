@@ -2,6 +2,9 @@
 #include <span>
 #include "Ref.hpp"
 #include "DataStructures.hpp"
+#include "AudioMixing.hpp"
+#include <algorithm>
+#include <vector>
 
 namespace RavEngine{
     class AudioAsset;
@@ -64,42 +67,62 @@ namespace RavEngine{
         }
 
         /**
-        * Copy interleaved data into a planar representation
-        * @param interleaved the source buffer
+        * Copy interleaved data into a planar representation. The view must have room for every sample in interleaved.
+        * @param interleaved the source buffer. May be this view's own storage, which is then converted in place.
+        * @param nchannels the number of channels in interleaved
         */
         void ImportInterleavedData(InterleavedSampleBufferView interleaved, uint8_t nchannels) {
             sizeOfOneChannelInFrames = interleaved.size() / nchannels;
-#pragma omp simd
-            for (size_t i = 0; i < interleaved.size(); i++) {
-				auto view = (*this)[i % nchannels];
-                view[i % sizeOfOneChannelInFrames] = interleaved[i];
+            auto dst = combined_buffers.data();
+            const auto src = interleaved.data();
+            if (src == dst && nchannels == 1){
+                return;     // mono is already planar
+            }
+            // the transpose reads ahead of where it writes, so overlapping input needs a copy
+            if (src < dst + combined_buffers.size() && dst < src + interleaved.size()){
+                std::vector<float> copy(interleaved.begin(), interleaved.end());
+                AudioMixing::InterleavedToPlanar(dst, sizeOfOneChannelInFrames, copy.data(), sizeOfOneChannelInFrames, nchannels);
+            }
+            else{
+                AudioMixing::InterleavedToPlanar(dst, sizeOfOneChannelInFrames, src, sizeOfOneChannelInFrames, nchannels);
             }
         }
     };
 
     inline void AdditiveBlendSamples(InterleavedSampleBufferView A, const InterleavedSampleBufferView B){
-        auto bounds = std::min(A.size(),A.size());
-#pragma omp simd
-        for(decltype(bounds) i = 0; i < bounds; i++){
-            A[i] += B[i];
-        }
+        AudioMixing::AdditiveBlend(A.data(), B.data(), std::min(A.size(),B.size()));
     }
     inline void AdditiveBlendSamples(PlanarSampleBufferInlineView A, const PlanarSampleBufferInlineView B){
-#pragma omp simd
+        const auto nframes = std::min(A.sizeOneChannel(),B.sizeOneChannel());
         for(uint8_t c = 0; c < std::min(A.GetNChannels(),B.GetNChannels()); c++){
-#pragma omp simd
-            for(size_t i = 0; i < A.sizeOneChannel();i++){
-                A[c][i] += B[c][i];
-            }
+            AudioMixing::AdditiveBlend(A[c].data(), B[c].data(), nframes);
         }
     }
 
     class AudioGraphAsset;
+
+    /**
+     The filter state of one voice rendering an AudioGraphAsset: delay lines, envelopes and filter history.
+     A graph may be rendered by several voices at once as long as each passes its own state.
+     */
+    struct AudioGraphState{
+        /**
+         Discard the state of every built-in filter, as if the voice had just started
+         */
+        void Reset();
+    private:
+        friend class AudioGraphAsset;
+        std::shared_ptr<const void> program;    // the compiled program the state is laid out for
+        Vector<float> values;
+        Vector<size_t> positions;               // delay line write position, per compiled node
+    };
+
     struct AudioGraphComposed{
         using effect_graph_ptr_t = Ref<AudioGraphAsset>;
     private:
         void renderImpl(PlanarSampleBufferInlineView& inputBuffer, PlanarSampleBufferInlineView& scratchBuffer, uint8_t nchannels);
         effect_graph_ptr_t effectGraph;
+        AudioGraphState graphState;
     public:
         
         void SetGraph(decltype(effectGraph) inGraph){
@@ -0,0 +1,130 @@
+#pragma once
+#include "AudioTypes.hpp"
+#include "DataStructures.hpp"
+#include "Ref.hpp"
+#include "mathtypes.hpp"
+
+namespace RavEngine{
+
+struct AudioDataProvider;
+struct AudioSnapshot;
+
+struct AudioVoiceOptions{
+    uint32_t maxVoices = 64;        // sources rendered and mixed per buffer. The rest are virtualised.
+    uint32_t fadeFrames = 256;      // length of the fade when a voice becomes real or virtual. Clamped to the buffer size.
+    float referenceDistance = 1;    // sources closer than this to the listener are ranked as unattenuated
+    float hysteresis = 1.25f;       // real voices' scores are multiplied by this when ranking, so that sources near the cutoff do not trade places every buffer
+};
+
+/**
+ Limits the number of sources that are rendered each buffer. Every source is scored by
+ volume * priority * distance attenuation, and only the highest scoring maxVoices are rendered.
+ The rest are virtual: their playheads keep advancing, but no samples are produced or mixed, so
+ that they resume at the correct position when they become real again. Voices that change state
+ fade in or out over fadeFrames to avoid clicks. A demoted voice is rendered for one more buffer
+ while it fades out, so the number of rendered voices can briefly exceed the budget.
+ Not thread-safe. AudioPlayer owns one and uses it from the audio thread.
+ */
+class AudioVoiceManager{
+public:
+    enum class Fade : uint8_t{
+        None,
+        In,
+        Out
+    };
+
+    struct Voice{
+        Ref<AudioDataProvider> provider;
+        float score = 0;
+        Fade fade = Fade::None;
+    };
+
+    struct Statistics{
+        uint32_t nSources = 0;      // distinct sources considered in the last Update
+        uint32_t nReal = 0;         // voices rendered, including those fading out
+        uint32_t nVirtual = 0;
+        uint32_t nPromoted = 0;     // virtual voices that became real in the last Update
+        uint32_t nDemoted = 0;      // real voices that began fading out in the last Update
+    };
+
+    AudioVoiceManager(const AudioVoiceOptions& options = {}) : options(options){}
+
+    inline void SetOptions(const AudioVoiceOptions& newOptions){
+        options = newOptions;
+    }
+
+    inline const AudioVoiceOptions& GetOptions() const{
+        return options;
+    }
+
+    /**
+     Rank every source in a snapshot and decide which voices are rendered this buffer.
+     Ambient sources are not attenuated by distance. A provider that appears more than once is only considered once.
+     @param snapshot the sources and listener to rank
+     */
+    void Update(const AudioSnapshot& snapshot);
+
+    /**
+     Rank an arbitrary set of sources: call SetListener, then AddPointSource and AddAmbientSource for each source, then Update().
+     */
+    void SetListener(const vector3& listenerPos);
+    void AddPointSource(const Ref<AudioDataProvider>& provider, const vector3& worldpos);
+    void AddAmbientSource(const Ref<AudioDataProvider>& provider);
+    void Update();
+
+    /**
+     @return the voices to render this buffer, highest score first
+     */
+    inline const Vector<Voice>& GetRealVoices() const{
+        return realVoices;
+    }
+
+    /**
+     @return the voices to advance without rendering this buffer
+     */
+    inline const Vector<Voice>& GetVirtualVoices() const{
+        return virtualVoices;
+    }
+
+    inline const Statistics& GetStatistics() const{
+        return statistics;
+    }
+
+    /**
+     Render a real voice into a buffer, applying its fade
+     @param voice a voice from GetRealVoices()
+     @param buffer the destination
+     @param scratchSpace scratch for the provider's effect graph
+     */
+    void Render(const Voice& voice, PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratchSpace) const;
+
+    /**
+     Advance every virtual voice's playhead by one buffer
+     @param nframes the length of the buffer
+     */
+    void AdvanceVirtualVoices(size_t nframes) const;
+
+private:
+    struct Candidate{
+        Ref<AudioDataProvider> provider;
+        float score;
+        bool wasReal;
+        bool isNew;
+    };
+    struct TrackedVoice{
+        uint64_t lastSeen = 0;
+        bool real = false;
+    };
+
+    void AddCandidate(const Ref<AudioDataProvider>& provider, float attenuation);
+
+    AudioVoiceOptions options;
+    Statistics statistics;
+    UnorderedMap<AudioDataProvider*, TrackedVoice> tracked;
+    Vector<Candidate> candidates;
+    Vector<Voice> realVoices, virtualVoices;
+    vector3 listenerPosForRanking{0, 0, 0};
+    uint64_t generation = 1;
+};
+
+}
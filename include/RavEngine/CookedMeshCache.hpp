@@ -0,0 +1,56 @@
+#pragma once
+#include "PhysXDefines.h"
+#include "Ref.hpp"
+#include <cstddef>
+
+namespace physx{
+    class PxTriangleMesh;
+    class PxConvexMesh;
+}
+
+namespace RavEngine{
+class MeshAsset;
+class DiskCache;
+
+/**
+ Cooks the meshes of MeshCollider and ConvexMeshCollider. A cooked mesh is keyed by a hash of the positions and indices it
+ was cooked from, and is shared by every collider in every PhysicsSolver that uses the same data. Cooked meshes are also
+ written to a DiskCache in PhysX's binary cooked format, so that a later run loads them instead of cooking again.
+ All functions are thread-safe.
+ */
+class CookedMeshCache{
+public:
+    struct Statistics{
+        size_t memoryHits = 0;      // meshes already cooked in this process
+        size_t diskHits = 0;        // meshes loaded from the disk cache
+        size_t cooked = 0;          // meshes cooked from scratch
+    };
+
+    /**
+     @param mesh the mesh, which must have a system memory copy
+     @return the cooked triangle mesh. The caller owns one reference, and must release it.
+     */
+    static physx::PxTriangleMesh* GetTriangleMesh(MeshAsset& mesh);
+
+    /**
+     @param mesh the mesh, which must have a system memory copy. Its convex hull is cooked.
+     @return the cooked convex mesh. The caller owns one reference, and must release it.
+     */
+    static physx::PxConvexMesh* GetConvexMesh(MeshAsset& mesh);
+
+    /**
+     The cooked meshes live in the temporary directory by default, limited to 512 MiB. Use this to move, resize or
+     disable the cache (by setting an empty directory).
+     @return the cache that cooked meshes are written to
+     */
+    static DiskCache& GetDiskCache();
+
+    /**
+     Drop this process's references to the cooked meshes. Meshes still used by colliders stay alive until those are destroyed.
+     */
+    static void ReleaseAll();
+
+    static Statistics GetStatistics();
+};
+
+}
@@ -10,6 +10,8 @@
 #include <plf_list.h>
 #include <plf_colony.h>
 #include "unordered_vector.hpp"
+#include "FrameAllocator.hpp"
+#include "MemoryTracker.hpp"
 #include <queue>
 
 namespace RavEngine{
@@ -64,9 +66,29 @@ namespace RavEngine{
     template<typename T>
     using Queue = std::queue<T>; 
 
+    // Versions of the containers above that charge their storage to a MemoryTag. See MemoryTracker.hpp
+    template<typename T, MemoryTag tag = MemoryTag::Containers>
+    using TrackedVector = boost::container::vector<T, TrackedAllocator<T, tag>>;
+
+    template<typename T, typename U, MemoryTag tag = MemoryTag::Containers>
+    using TrackedUnorderedMap = phmap::flat_hash_map<T, U, phmap::priv::hash_default_hash<T>, phmap::priv::hash_default_eq<T>, TrackedAllocator<std::pair<const T, U>, tag>>;
+
+    template<typename T, typename U, MemoryTag tag = MemoryTag::Containers>
+    using TrackedUnorderedNodeMap = phmap::node_hash_map<T, U, phmap::priv::hash_default_hash<T>, phmap::priv::hash_default_eq<T>, TrackedAllocator<std::pair<const T, U>, tag>>;
+
+    template<typename T, MemoryTag tag = MemoryTag::Containers>
+    using TrackedUnorderedSet = phmap::flat_hash_set<T, phmap::priv::hash_default_hash<T>, phmap::priv::hash_default_eq<T>, TrackedAllocator<T, tag>>;
+
+    template<typename T, typename U, MemoryTag tag = MemoryTag::Containers, typename lock = std::mutex>
+    using TrackedLockedHashmap = phmap::parallel_flat_hash_map<T, U, phmap::priv::hash_default_hash<T>, phmap::priv::hash_default_eq<T>, TrackedAllocator<std::pair<const T, U>, tag>, 4, lock>;
+
+    template<typename T, MemoryTag tag = MemoryTag::Containers, typename lock = std::mutex>
+    using TrackedLockedHashset = phmap::parallel_flat_hash_set<T, phmap::priv::hash_default_hash<T>, phmap::priv::hash_default_eq<T>, TrackedAllocator<T, tag>, 4, lock>;
+
 // The stackarray creates a stack-resident array using a runtime-known size.
 // There are no safety checks for overflowing the stack, and overflowing results in undefined behavior.
-// Only use for small sizes. For larger sizes, use the maybestackarray instead
+// Only use for small sizes. For larger sizes, use the maybestackarray instead, or the framearray (see FrameAllocator.hpp)
+// if the data does not need to outlive the current World tick
 #if defined __APPLE__ || __STDC_VERSION__ >= 199901L    //check for C99
 #define stackarray(name, type, size) type name[size]    //prefer C VLA on supported systems
 #else
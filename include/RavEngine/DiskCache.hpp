@@ -0,0 +1,101 @@
+#pragma once
+#include "Filesystem.hpp"
+#include "Function.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace RavEngine{
+
+/**
+ A directory of derived data, such as decoded audio, that is expensive to compute and can be
+ reused across sessions. Each entry is one file named by a caller-provided key. The total size of
+ the entries is bounded: when a store exceeds the limit, the least recently used entries are
+ deleted. Entries are written to a temporary file and renamed into place, so a crash or a second
+ process never observes a partial entry. All functions are thread-safe.
+ */
+class DiskCache{
+public:
+    struct Statistics{
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t stores = 0;
+        size_t evictions = 0;       // entries deleted to stay under the size limit
+        size_t totalBytes = 0;      // the size of every entry currently in the directory
+    };
+
+    /**
+     @param directory where to keep entries. It is created on first use. An empty path disables the cache.
+     @param maxBytes the total size the entries may occupy
+     */
+    DiskCache(const Filesystem::Path& directory, size_t maxBytes);
+
+    /**
+     Move the cache. Entries in the old directory are left in place.
+     @param directory the new directory. An empty path disables the cache.
+     */
+    void SetDirectory(const Filesystem::Path& directory);
+    Filesystem::Path GetDirectory() const;
+
+    /**
+     Change the size limit, evicting entries if the cache is now over it
+     @param maxBytes the new limit
+     */
+    void SetMaxBytes(size_t maxBytes);
+    size_t GetMaxBytes() const;
+
+    inline bool IsEnabled() const{
+        return !GetDirectory().empty();
+    }
+
+    /**
+     Read an entry. The payload is read with a single call directly into the memory returned by allocate, without an intermediate copy.
+     @param key the name of the entry. Must be a valid file name.
+     @param allocate called with the size of the payload, returns where to write it. Return nullptr to abandon the load.
+     @return true if the entry was found and read in full. If this returns false after calling allocate, the caller still owns the memory.
+     */
+    bool Load(const std::string& key, const Function<void*(size_t)>& allocate);
+
+    /**
+     Write or replace an entry, then evict old entries if the cache is over its size limit
+     @param key the name of the entry. Must be a valid file name.
+     @param data the payload
+     @param size the size of the payload in bytes
+     */
+    void Store(const std::string& key, const void* data, size_t size);
+
+    /**
+     Delete every entry
+     */
+    void Clear();
+
+    Statistics GetStatistics() const;
+
+    /**
+     A fast, non-cryptographic 64-bit hash, suitable for keying entries on the contents of a source file
+     @param data the bytes to hash
+     @param size the number of bytes
+     @param seed combine with another hash by passing it here
+     */
+    static uint64_t Hash(const void* data, size_t size, uint64_t seed = 0);
+
+    /**
+     @param name the name of the subdirectory
+     @return a directory for a cache inside the system's temporary directory, or an empty path if there is none
+     */
+    static Filesystem::Path TemporaryDirectory(const std::string& name);
+
+private:
+    void ScanIfNeeded();
+    void EvictToFit(size_t maxBytes);
+    Filesystem::Path PathFor(const std::string& key) const;
+
+    mutable std::mutex mtx;
+    Filesystem::Path directory;
+    size_t maxBytes;
+    Statistics statistics;
+    bool scanned = false;
+};
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <new>
+
+namespace RavEngine{
+
+/**
+ A thread-local bump allocator for transient data that lives no longer than the current World tick.
+ Allocation is a pointer increment. Memory is never freed individually, instead the whole arena
+ is recycled the first time the owning thread allocates after World::TickECS completes.
+ If the arena is full, allocations fall back to the heap and are released on the next reset.
+ @note Only use from inside a World tick (Systems, scripts and other tasks the World runs). On any other thread,
+ such as the audio callback, a tick can end between two allocations, and the second one then frees the first.
+ */
+class FrameArena{
+public:
+    struct Statistics{
+        size_t capacity = 0;            // size of the bump region, in bytes
+        size_t used = 0;                // bytes handed out from the bump region this frame
+        size_t overflowBytes = 0;       // bytes that did not fit and went to the heap this frame
+        size_t overflowCount = 0;       // number of heap fallback allocations this frame
+        size_t highWaterMark = 0;       // largest used + overflowBytes seen by this arena
+    };
+
+    /**
+     Allocate uninitialized memory valid until the end of the current frame
+     @param size number of bytes
+     @param alignment required alignment, must be a power of two
+     @return pointer to the memory. Never nullptr.
+     */
+    inline void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)){
+        if (generation != currentGeneration.load(std::memory_order_relaxed)){
+            Reset();
+        }
+        const auto base = reinterpret_cast<uintptr_t>(block.get());
+        const auto aligned = ((base + offset + (alignment - 1)) & ~(alignment - 1)) - base;
+        if (aligned + size <= capacity){
+            lastOffset = offset;
+            offset = aligned + size;
+            return block.get() + aligned;
+        }
+        return AllocateOverflow(size, alignment);
+    }
+
+    /**
+     Allocate uninitialized storage for an array of T
+     @param count the number of elements
+     */
+    template<typename T>
+    inline T* Allocate(size_t count){
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /**
+     Return memory to the arena. This only has an effect if ptr was the most recent allocation,
+     so a temporary freed right after it was taken gives its space back. Otherwise the memory is reclaimed on reset.
+     A growing FrameVector does not reuse its old space, because std::vector allocates the new block before
+     freeing the old one. Reserve the final size up front instead.
+     @param ptr the pointer returned from Allocate
+     @param size the size passed to Allocate
+     */
+    inline void Deallocate(void* ptr, size_t size){
+        auto bytes = static_cast<std::byte*>(ptr);
+        if (bytes >= block.get() && bytes + size == block.get() + offset){
+            offset = lastOffset;
+        }
+    }
+
+    /**
+     Recycle all memory in this arena. Invalidates all outstanding allocations.
+     */
+    void Reset();
+
+    /**
+     @return the allocation statistics for this arena
+     */
+    Statistics GetStatistics() const;
+
+    /**
+     @return true if ptr lies in this arena's bump region
+     */
+    inline bool Owns(const void* ptr) const{
+        auto bytes = static_cast<const std::byte*>(ptr);
+        return bytes >= block.get() && bytes < block.get() + capacity;
+    }
+
+    /**
+     @return the arena belonging to the calling thread
+     */
+    static FrameArena& GetThreadArena();
+
+    /**
+     Mark the end of a frame. All thread arenas reset lazily on their next allocation.
+     Called automatically at the end of World::TickECS.
+     */
+    static void EndFrame(){
+        currentGeneration.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     @return the largest amount of memory any single thread arena has needed in one frame
+     */
+    static size_t GetGlobalHighWaterMark(){
+        return globalHighWaterMark.load(std::memory_order_relaxed);
+    }
+
+    /**
+     Set the bump region size for arenas created after this call.
+     @param bytes the size, in bytes
+     */
+    static void SetDefaultCapacity(size_t bytes){
+        defaultCapacity = bytes;
+    }
+
+    FrameArena(size_t capacity);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    void operator=(const FrameArena&) = delete;
+
+private:
+    void* AllocateOverflow(size_t size, size_t alignment);
+
+    std::unique_ptr<std::byte[]> block;
+    size_t capacity = 0, offset = 0, lastOffset = 0;
+    uint64_t generation = 0;
+    std::vector<void*> overflowAllocations;
+    size_t overflowBytes = 0;
+    size_t highWaterMark = 0;
+
+    static std::atomic<uint64_t> currentGeneration;
+    static std::atomic<size_t> globalHighWaterMark;
+    static size_t defaultCapacity;
+};
+
+/**
+ STL-compatible allocator that draws from the calling thread's FrameArena.
+ Containers using this allocator must not outlive the current frame, and must not be grown from another thread.
+ */
+template<typename T>
+struct FrameAllocator{
+    using value_type = T;
+
+    FrameArena* arena;
+
+    FrameAllocator() : arena(&FrameArena::GetThreadArena()){}
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena){}
+
+    inline T* allocate(size_t n){
+        return arena->Allocate<T>(n);
+    }
+
+    inline void deallocate(T* ptr, size_t n){
+        arena->Deallocate(ptr, n * sizeof(T));
+    }
+
+    template<typename U>
+    inline bool operator==(const FrameAllocator<U>& other) const{
+        return arena == other.arena;
+    }
+
+    template<typename U>
+    inline bool operator!=(const FrameAllocator<U>& other) const{
+        return arena != other.arena;
+    }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+}
+
+// The framearray creates an uninitialized array in the calling thread's FrameArena using a runtime-known size.
+// Unlike the stackarray, it cannot overflow the stack. The memory is valid until the end of the current World tick.
+// Only use with trivially-constructible types.
+#define framearray(name, type, size) type* name = RavEngine::FrameArena::GetThreadArena().Allocate<type>(size)
@@ -0,0 +1,172 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Function.hpp"
+
+namespace RavEngine{
+
+/**
+ Categories for memory accounting. Each tag has its own counters and budget.
+ */
+enum class MemoryTag : uint8_t{
+    General,
+    Containers,     // Tracked* containers that do not specify a tag
+    Meshes,         // vertex and index data in system memory
+    Audio,          // decoded audio samples
+    Physics,        // allocations made by PhysX
+    GPUBuffers,     // GPU buffers, including mesh vertex and index buffers
+    Textures,       // GPU textures and render targets
+    Count
+};
+
+/**
+ Process-wide, tagged allocation accounting. Subsystems report their allocations here,
+ and the tracker keeps per-tag current and peak usage. Each tag may have a soft budget,
+ which invokes a callback when usage crosses above it but never fails an allocation.
+ All functions are thread-safe.
+ */
+class MemoryTracker{
+public:
+    using budget_callback_t = Function<void(MemoryTag tag, size_t currentBytes, size_t budgetBytes)>;
+
+    struct TagStatistics{
+        size_t currentBytes = 0;
+        size_t peakBytes = 0;
+        size_t allocations = 0;         // total number of Allocated calls
+        size_t deallocations = 0;       // total number of Deallocated calls
+        size_t budgetBytes = 0;         // 0 if no budget is set
+    };
+
+    /**
+     Record an allocation
+     @param tag the category to charge
+     @param bytes the size of the allocation
+     */
+    static inline void Allocated(MemoryTag tag, size_t bytes){
+        auto& counters = tags[size_t(tag)];
+        const auto current = counters.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        auto peak = counters.peak.load(std::memory_order_relaxed);
+        while (peak < current && !counters.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+
+        const auto budget = counters.budget.load(std::memory_order_relaxed);
+        if (budget != 0 && current > budget && current - bytes <= budget){
+            BudgetExceeded(tag, current, budget);
+        }
+    }
+
+    /**
+     Record a deallocation
+     @param tag the category that was charged in Allocated
+     @param bytes the size passed to Allocated
+     */
+    static inline void Deallocated(MemoryTag tag, size_t bytes){
+        auto& counters = tags[size_t(tag)];
+        counters.current.fetch_sub(bytes, std::memory_order_relaxed);
+        counters.deallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     @return the counters for a tag
+     */
+    static TagStatistics GetStatistics(MemoryTag tag);
+
+    /**
+     Set a soft budget for a tag. The callback runs on the allocating thread each time usage goes from at-or-below the budget to above it.
+     @param tag the tag to budget
+     @param bytes the budget. Pass 0 to remove the budget.
+     @param callback the function to invoke when the budget is exceeded
+     */
+    static void SetBudget(MemoryTag tag, size_t bytes, const budget_callback_t& callback);
+
+    /**
+     Reset the peak of every tag to its current usage
+     */
+    static void ResetPeaks();
+
+    /**
+     @return a human-readable table of the usage of every tag
+     */
+    static std::string Report();
+
+    /**
+     @return the display name of a tag
+     */
+    static const char* TagName(MemoryTag tag);
+
+    /**
+     Wrap a reference-counted resource, such as a GPU buffer, so that it remains charged to a tag until its last reference is released.
+     @param resource the resource to track
+     @param bytes the size to charge
+     @param tag the category to charge
+     @return a pointer to the same object that owns the original reference
+     */
+    template<typename T>
+    static inline std::shared_ptr<T> TrackSharedResource(std::shared_ptr<T> resource, size_t bytes, MemoryTag tag){
+        if (!resource){
+            return resource;
+        }
+        Allocated(tag, bytes);
+        auto raw = resource.get();
+        return std::shared_ptr<T>(raw, [resource, bytes, tag](T*) mutable{
+            MemoryTracker::Deallocated(tag, bytes);
+            resource.reset();
+        });
+    }
+
+private:
+    struct TagCounters{
+        std::atomic<size_t> current = 0;
+        std::atomic<size_t> peak = 0;
+        std::atomic<size_t> allocations = 0;
+        std::atomic<size_t> deallocations = 0;
+        std::atomic<size_t> budget = 0;
+    };
+    static std::array<TagCounters, size_t(MemoryTag::Count)> tags;
+
+    static void BudgetExceeded(MemoryTag tag, size_t current, size_t budget);
+};
+
+/**
+ STL-compatible allocator that charges its allocations to a MemoryTag. See the Tracked* containers in DataStructures.hpp.
+ */
+template<typename T, MemoryTag tag = MemoryTag::Containers>
+struct TrackedAllocator{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind{
+        using other = TrackedAllocator<U, tag>;
+    };
+
+    TrackedAllocator() = default;
+
+    template<typename U>
+    TrackedAllocator(const TrackedAllocator<U, tag>&){}
+
+    inline T* allocate(size_t n){
+        MemoryTracker::Allocated(tag, n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    inline void deallocate(T* ptr, size_t n){
+        MemoryTracker::Deallocated(tag, n * sizeof(T));
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template<typename U>
+    inline bool operator==(const TrackedAllocator<U, tag>&) const{
+        return true;
+    }
+
+    template<typename U>
+    inline bool operator!=(const TrackedAllocator<U, tag>&) const{
+        return false;
+    }
+};
+
+}
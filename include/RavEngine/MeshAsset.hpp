@@ -36,7 +36,9 @@ public:
         T<uint32_t> indices;
         T<vertex_t> vertices;
     };
-	struct MeshPart : public MeshPartBase<RavEngine::Vector>{};
+    template<typename T>
+    using MeshVector = TrackedVector<T, MemoryTag::Meshes>;
+	struct MeshPart : public MeshPartBase<MeshVector>{};
     
     template<typename T>
     struct basic_immutable_span : public std::span<const T,std::dynamic_extent>{
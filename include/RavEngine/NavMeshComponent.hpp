@@ -56,6 +56,7 @@ namespace RavEngine{
          @param start the start location of the path, in local coordinates to the owning entity
          @param end the end location of the path, in local coordinates to the owning entity
          @return list of coordinates composing the path
+         @note must be called from inside a World tick (for example from a System or script), because its scratch buffers come from the FrameArena
          */
         RavEngine::Vector<vector3> CalculatePath(const vector3& start, const vector3& end, uint16_t maxPoints = std::numeric_limits<uint16_t>::max());
         
@@ -26,7 +26,8 @@ public:
 
 	void SendMessageToServer(const std::string_view& msg, Reliability mode) const;
 
-	void OnRPC(const std::string_view& cmd);
+	// takes ownership of the message, which is released once the RPC has run (or immediately, if it cannot be delivered)
+	void OnRPC(SteamNetworkingMessage_t* msg);
 
 	void SendSyncWorldRequest(Ref<World> world);
 
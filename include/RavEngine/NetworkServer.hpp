@@ -8,6 +8,8 @@
 #include "Function.hpp"
 #include "ComponentHandle.hpp"
 #include <string_view>
+#include <atomic>
+#include <chrono>
 
 namespace RavEngine {
 	struct Entity;
@@ -51,9 +53,32 @@ public:
     std::string CreateSpawnCommand(const uuids::uuid& id, ctti_t type, std::string_view& worldID);
 
     std::string CreateDestroyCommand(const uuids::uuid& id);
+
+	// the most messages the worker takes from the networking library per call. Set before calling Start.
+	int maxMessagesPerReceive = 256;
+
+	// how long the worker sleeps when no messages arrived. May be changed while the server runs. 0 polls continuously,
+	// which keeps latency lowest but occupies a core even when idle.
+	std::atomic<std::chrono::microseconds> idlePollInterval = std::chrono::microseconds(1000);
+
+	struct Statistics {
+		uint64_t messagesReceived = 0;
+		uint64_t bytesReceived = 0;
+		uint64_t receiveCalls = 0;				// calls to the networking library that returned messages
+		uint64_t idleWaits = 0;					// times the worker slept because nothing arrived
+		int64_t totalLatencyMicroseconds = 0;	// summed time from each message arriving to the server handling it
+		int64_t maxLatencyMicroseconds = 0;
+	};
+
+	/**
+	* @return the worker's counters since Start. Divide messagesReceived by elapsed time for throughput,
+	* and totalLatencyMicroseconds by messagesReceived for the mean latency.
+	*/
+	Statistics GetStatistics() const;
 	
 protected:
-	void OnRPC(const std::string_view& cmd, HSteamNetConnection);
+	// takes ownership of the message, which is released once the RPC has run (or immediately, if it cannot be delivered)
+	void OnRPC(SteamNetworkingMessage_t* msg, HSteamNetConnection);
 
 	ISteamNetworkingSockets *net_interface = nullptr;
 	HSteamListenSocket listenSocket = k_HSteamListenSocket_Invalid;
@@ -74,6 +99,15 @@ protected:
 	
 	void ServerTick();
 
+	// handle one received message, taking ownership of it
+	void HandleMessage(SteamNetworkingMessage_t* msg);
+
+	// written only by the worker
+	struct {
+		std::atomic<uint64_t> messagesReceived = 0, bytesReceived = 0, receiveCalls = 0, idleWaits = 0;
+		std::atomic<int64_t> totalLatencyMicroseconds = 0, maxLatencyMicroseconds = 0;
+	} counters;
+
 	//invoked when clients request to have their worlds synchronized
 	void SynchronizeWorldToClient(HSteamNetConnection connection, const std::string_view& in_message);
 
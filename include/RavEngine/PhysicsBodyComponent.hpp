@@ -9,6 +9,7 @@
 #include "ComponentWithOwner.hpp"
 #include <boost/poly_collection/base_collection.hpp>
 #include "PhysicsCollider.hpp"
+#include <span>
 
 namespace physx {
 	class PxRigidActor;
@@ -121,6 +122,22 @@ namespace RavEngine {
 		*/
         void setDynamicsWorldPose(const vector3& worldpos, const quaternion& worldrot) const;
 
+		/**
+		A new world-space pose for one body, see SetDynamicsWorldPoses
+		*/
+		struct PoseWrite{
+			PhysicsBodyComponent* body;
+			vector3 position;
+			quaternion rotation;
+		};
+
+		/**
+		Set the world space dynamics transform of many bodies (via teleport). Each scene's write lock is taken once for a run of bodies in it, instead of once per body.
+		@param writes the bodies and their new world-space poses
+		@note thread-safe (Locks internally).
+		*/
+		static void SetDynamicsWorldPoses(std::span<const PoseWrite> writes);
+
 		void SetGravityEnabled(bool);
 
 		/**
@@ -188,8 +205,13 @@ namespace RavEngine {
 		wantsContactData controls if the simulation calculates and extracts contact point information on collisions.
 		Set to true to get contact point data. If set to false, OnCollider functions will have a dangling contactPoints pointer and numContactPoints will be 0.
 		*/
-		inline void SetWantsContactData(bool state) {
-			wantsContactData = state;
+		void SetWantsContactData(bool state);
+
+		/**
+		@return true if any receivers are registered for collision events
+		*/
+		inline bool HasReceivers() const {
+			return !receivers.empty();
 		}
 		
 		void DebugDraw(RavEngine::DebugDrawer& dbg, const RavEngine::Transform& tr) const {
@@ -202,11 +224,20 @@ namespace RavEngine {
 	protected:
 		bool wantsContactData = false;
 
+		/**
+		New bodies join the scene at the solver's next FlushActorChanges. PhysX calls that need the body in a scene call this first, which flushes early if needed.
+		If a step is in flight, it waits for the step first.
+		*/
+		void EnsureInScene();
+
+		// take the scene's lock through its solver, which waits for a step in flight
+		static void LockScene(physx::PxScene* scene, bool write);
+
 		template<typename T>
-		inline void LockWrite(const T& func){
+		inline void LockWrite(const T& func) const{
 			auto scene = rigidActor->getScene();
             if (scene){
-                scene->lockWrite();
+                LockScene(scene, true);
                 func();
 				scene->unlockWrite();
             }
@@ -219,7 +250,7 @@ namespace RavEngine {
         inline void LockRead(const T& func) const{
 			auto scene = rigidActor->getScene();
             if(scene){
-                scene->lockRead();
+                LockScene(scene, false);
                 func();
 				scene->unlockRead();
             }
@@ -254,6 +285,27 @@ namespace RavEngine {
         void SetKinematicTarget(const vector3& targetPos, const quaternion& targetRot);
         std::pair<vector3, quaternion> GetKinematicTarget() const;
 
+		/**
+		Set the kinematic targets of many bodies, locking each scene once like SetDynamicsWorldPoses.
+		@param writes the bodies, which must be kinematic RigidBodyDynamicComponents, and their targets
+		@note thread-safe (Locks internally).
+		*/
+		static void SetKinematicTargets(std::span<const PoseWrite> writes);
+
+		/**
+		Make the body kinematic. A kinematic body follows its Transform, which the World sets as its kinematic target before each step,
+		and pushes dynamic bodies without being pushed by them.
+		@param state true to make the body kinematic
+		*/
+		void SetKinematic(bool state);
+
+		/**
+		@return true if the body is kinematic
+		*/
+		inline bool IsKinematic() const {
+			return kinematic;
+		}
+
 		/**
 		Wake the body
 		*/
@@ -333,6 +385,8 @@ namespace RavEngine {
 		void Destroy() {
 			PhysicsBodyComponent::Destroy();
 		}
+	private:
+		bool kinematic = false;
 	};
 
 	struct RigidBodyStaticComponent : public PhysicsBodyComponent, public QueryableDelta<PhysicsBodyComponent,RigidBodyStaticComponent> {
@@ -6,32 +6,27 @@
 //  Copyright © 2020 Ravbug.
 //
 
-#include "CTTI.hpp"
-
-namespace phsyx{
-    class PxScene;
-}
+#include "DataStructures.hpp"
+#include "PhysicsBodyComponent.hpp"
 
 namespace RavEngine {
-	struct RigidBodyStaticComponent;
-	struct RigidBodyDynamicComponent;
-	struct Transform;
-
-	/**
-	 This System copies the Entity's transform to the physics simulation transform.
-	 It must run after any transform modifications in other systems, ideally at the end of the pipeline.
-	 */
-	class PhysicsLinkSystemWrite : public AutoCTTI{
-	public:		
-		void operator()(const RigidBodyStaticComponent&, const Transform&) const;
-	};
+	class World;
 
 	/**
-	 This System copies the state of the physics simulation transform to the Entity's transform.
-	 It must run before any transform modifications in other systems, ideally at the beginning of the pipeline.
+	 This copies the Entity's transform to the physics simulation transform, for static and kinematic bodies.
+	 The World runs it once per tick, after the Systems that move things and before the physics step.
+	 Only bodies whose Transforms changed since the last write are collected, and they are all written under one scene lock:
+	 statics are teleported, kinematic bodies get their Transform as their kinematic target.
+	 It is not a System, because the writes cannot run in parallel. The other direction is not one either: the World copies
+	 the poses of the bodies that moved back to their Transforms after each physics tick, see PhysicsSolver::SyncActiveActors.
 	 */
-	class PhysicsLinkSystemRead : public AutoCTTI {
+	class PhysicsLinkSystemWrite{
+		Vector<PhysicsBodyComponent::PoseWrite> moved, targets;
 	public:
-		void operator()(const RigidBodyDynamicComponent&, Transform&) const;
+		/**
+		 @param world the world to write the bodies of
+		 @return the number of bodies written
+		 */
+		uint32_t operator()(World& world);
 	};
 }
@@ -11,11 +11,16 @@
 #include <PxQueryReport.h>
 #include "Ref.hpp"
 #include "PhysicsCollider.hpp"
+#include "PhysicsBodyComponent.hpp"
 #include "PhysicsTaskDispatcher.hpp"
 #include <PxPhysicsAPI.h>
 #include <PxFiltering.h>
 #include <cstdint>
 #include "Types.hpp"
+#include "DataStructures.hpp"
+#include "SpinLock.hpp"
+#include <span>
+#include <atomic>
 
 struct FilterLayers {
     enum Enum {
@@ -29,20 +34,52 @@ struct FilterLayers {
 namespace RavEngine {
     struct Entity;
     struct PhysicsBodyComponent;
+
+    // what a batched scene query may hit. A body is hit if its filter group shares a bit with layers.
+    struct PhysicsQueryFilter {
+        physx::PxU32 layers = ~physx::PxU32(0);
+        bool statics = true;
+        bool dynamics = true;
+    };
+
     class PhysicsSolver : public physx::PxSimulationEventCallback {
         friend class World;
         PhysicsTaskDispatcher taskDispatcher;
     protected:
+        // forwards PhysX allocations to the heap and charges them to MemoryTag::Physics
+        struct TrackingAllocator : public physx::PxAllocatorCallback{
+            void* allocate(size_t size, const char* typeName, const char* filename, int line) override;
+            void deallocate(void* ptr) override;
+        };
+        
         //static members must exist only once in the application
         static physx::PxDefaultErrorCallback gDefaultErrorCallback;
-        static physx::PxDefaultAllocator gDefaultAllocatorCallback;
+        static TrackingAllocator gDefaultAllocatorCallback;
         static physx::PxFoundation* foundation;
+        static physx::PxCooking* cooking;
     public:
         static physx::PxPhysics* phys;
         static physx::PxPvd* pvd;
-		static physx::PxCooking* cooking;
         physx::PxScene* scene;
 
+        /**
+         Process-wide PhysX settings, read when the first PhysicsSolver is created. Change them before creating any World.
+         */
+        struct Config{
+            // connect to the PhysX Visual Debugger. Off by default, so that headless servers and tests never open a socket.
+            bool connectPVD = false;
+            const char* pvdHost = "127.0.0.1";
+            int pvdPort = 5425;
+            unsigned int pvdTimeoutMilliseconds = 10;
+        };
+        static Config config;
+
+        /**
+         The cooking library is shared by every solver, and created the first time a mesh is cooked.
+         @return the process's cooking instance
+         */
+        static physx::PxCooking* GetCooking();
+
         void DeallocatePhysx();
     protected:
 
@@ -56,8 +93,91 @@ namespace RavEngine {
         virtual void onTrigger(physx::PxTriggerPair* pairs, physx::PxU32 count) override;
         virtual void onAdvance(const physx::PxRigidBody* const* bodyBuffer, const physx::PxTransform* poseBuffer, const physx::PxU32 count) override {}
 
+    public:
+        /**
+         A contact or trigger event, recorded while PhysX fetches a step and delivered to the bodies' receivers by DispatchEvents.
+         */
+        struct ContactEvent{
+            enum Flags : uint8_t{
+                Begin = 1 << 0,
+                Persist = 1 << 1,
+                End = 1 << 2,
+                Trigger = 1 << 3,       // a is the trigger and b is the body that entered or left it
+            };
+            entity_t a = INVALID_ENTITY, b = INVALID_ENTITY;
+            vector3 point{0, 0, 0};     // the first contact point, if the pair reported any
+            vector3 normal{0, 0, 0};
+            vector3 impulse{0, 0, 0};   // summed over all of the pair's contact points
+            uint32_t firstPoint = 0;    // the pair's contact points in GetEventPoints, if either body wants contact data
+            uint32_t nPoints = 0;
+            uint16_t step = 0;          // the substep of the Tick the event happened in
+            uint8_t flags = 0;
+        };
+    protected:
+
         // If deltatime > this value, the system will substep
         constexpr static float max_step_time = 1.f/30;
+
+        // With a fixed step, a long frame can owe many steps. Past this many, the rest of the time is dropped rather than letting physics fall further behind.
+        constexpr static int max_fixed_steps = 8;
+
+        // The solver's bookkeeping is charged to MemoryTag::Containers, to tell it apart from PhysX's own allocations
+        // (which include per-step temporaries in the broadphase). It stops allocating once it has grown to the scene.
+
+        // poses of the actors PhysX reported as active in each substep of the last Tick, in step order
+        struct ActivePose{
+            entity_t owner;
+            physx::PxTransform pose;
+        };
+        TrackedVector<ActivePose> activePoses;
+
+        // the last two poses of every body that has moved, for interpolation. step is the last step the body moved in.
+        struct StepPoses{
+            physx::PxTransform previous, current;
+            uint64_t step = 0;
+        };
+        TrackedUnorderedMap<entity_t, StepPoses> stepPoses;
+        TrackedVector<entity_t> movedLastStep, movedThisStep;
+        uint64_t stepCount = 0;
+
+        // the substeps of the tick started by BeginTick that FinishTick still has to run
+        int pendingSteps = 0;
+        float pendingStepTime = 0;
+        
+        float fixedStep = 0;
+        float accumulator = 0;      // simulated time owed, less than one fixed step after a tick
+
+        // contact and trigger events from the substeps of the last Tick, in step order, waiting for DispatchEvents
+        TrackedVector<ContactEvent> events;
+        TrackedVector<ContactPairPoint> eventPoints;
+        TrackedVector<physx::PxContactPairPoint> extractedPoints;
+        uint16_t eventStep = 0;
+
+        // one delivery of an event to one of its bodies, so that deliveries can be grouped by receiver
+        struct EventDelivery{
+            entity_t receiver, other;
+            uint32_t event;
+        };
+        TrackedVector<EventDelivery> deliveries;
+
+        // bodies destroyed since the last step started. Events that name them are dropped.
+        TrackedUnorderedSet<entity_t> destroyedSinceFetch;
+        std::atomic<uint64_t> bodyGeneration = 0;      // counts Spawn and Destroy calls, which can move bodies in memory
+        SpinLock bodyLock;                              // guards stepPoses and destroyedSinceFetch, which Destroy changes from any thread
+
+        // true from the simulate in BeginTick until FinishTick fetches the last substep. Changed under the scene write lock.
+        std::atomic<bool> stepping = false;
+
+        // actors spawned or destroyed since the last FlushActorChanges. Destroyed actors are released once they leave the scene.
+        TrackedVector<physx::PxActor*> pendingAdds, pendingRemovals;
+        std::atomic<uint32_t> nPendingRemovals = 0;
+        SpinLock pendingLock;
+
+        // fetch the results of the running substep and collect its active poses. The caller holds the write lock.
+        void FetchStep();
+
+        // FlushActorChanges, for a caller that holds the scene write lock with no step in flight
+        uint32_t ApplyActorChanges();
         
         friend class PhysicsBodyComponent;
 
@@ -67,17 +187,123 @@ namespace RavEngine {
 			DeallocatePhysx();
 		}
 
+        /**
+         Queue a body to join the scene at the next FlushActorChanges.
+         */
         void Spawn( PhysicsBodyComponent&);
+
+        /**
+         Queue a body to leave the scene at the next FlushActorChanges, which also releases its actor. Until then queries skip it.
+         A body that never joined the scene is released right away.
+         */
         void Destroy( PhysicsBodyComponent&);
 
+        /**
+         Add the bodies spawned and remove the bodies destroyed since the last call, each with a single PhysX call under one lock.
+         BeginTick calls this before simulating, so new bodies are not hit by queries until the next tick unless this is called sooner.
+         Removals are applied before additions, and additions keep their spawn order. While a step is in flight, PhysX would
+         ignore the changes, so nothing is flushed and the bodies stay queued for the next call.
+         @return the number of bodies added or removed
+         */
+        uint32_t FlushActorChanges();
+
+        /**
+         Simulate one tick and wait for it to finish. Equivalent to BeginTick followed by FinishTick.
+         @param deltaTime the frame rate scale factor
+         */
         void Tick(float deltaTime);
 
+        /**
+         Start simulating one tick and return without waiting. PhysX runs on the App's executor.
+         Until FinishTick returns, reading or writing a body waits for it, so do not touch bodies on the thread that
+         will call FinishTick. Scene queries do not wait.
+         @param deltaTime the frame rate scale factor
+         */
+        void BeginTick(float deltaTime);
+
+        /**
+         Wait for the simulation started by BeginTick, then run any remaining substeps. When called from a worker of
+         the App's executor, the worker runs other tasks (including PhysX's own) while it waits instead of blocking.
+         */
+        void FinishTick();
+
+        /**
+         Lock the scene for reading or writing bodies, once no step is in flight. PhysX ignores body writes and reports
+         stale poses while it simulates, so body calls made during a step wait for FinishTick this way. A worker of the
+         App's executor runs other tasks while it waits. Release with the scene's unlockRead or unlockWrite.
+         @param write true for the write lock, false for the read lock
+         */
+        void LockBodies(bool write);
+
+        /**
+         Simulate in steps of a fixed length instead of once per tick. Time left over at the end of a tick carries
+         into the next one, and GetInterpolatedPose blends each body between its last two steps by that remainder,
+         so that rendering stays smooth when the render rate is higher than the physics rate.
+         @param seconds the length of a step, or 0 to simulate the whole tick every tick, in substeps no longer than max_step_time (the default)
+         */
+        void SetFixedStep(float seconds);
+
+        inline float GetFixedStep() const{
+            return fixedStep;
+        }
+
+        /**
+         @return how far the World is from the previous physics step to the current one, in [0, 1). Always 1 without a fixed step.
+         */
+        float GetInterpolationFactor() const;
+
+        /**
+         Get a body's pose blended between its last two physics steps. The Transform holds the latest step; use this for rendering only.
+         @param owner the entity that owns the body
+         @param pos receives the interpolated position
+         @param rot receives the interpolated rotation
+         @return false if the body has never moved in the simulation, in which case its Transform is already exact
+         */
+        bool GetInterpolatedPose(entity_t owner, vector3& pos, quaternion& rot) const;
+
+        /**
+         @return the bodies that moved in the latest physics step, and those that stopped in it. Every other body's interpolated pose is its current pose.
+         */
+        inline const TrackedVector<entity_t>& GetInterpolatingBodies() const{
+            return movedLastStep;
+        }
+
+        /**
+         Deliver the contact and trigger events of the last Tick to the bodies' receivers, then clear them.
+         Each body's events are delivered together, in the order they happened. Call from the thread that owns the World, after FinishTick.
+         @return the number of events
+         */
+        uint32_t DispatchEvents();
+
+        /**
+         @return the contact and trigger events of the last Tick, until DispatchEvents
+         */
+        inline const TrackedVector<ContactEvent>& GetEvents() const{
+            return events;
+        }
+
+        /**
+         @return the contact points of events whose bodies want contact data, indexed by ContactEvent::firstPoint
+         */
+        inline const TrackedVector<ContactPairPoint>& GetEventPoints() const{
+            return eventPoints;
+        }
+
+        /**
+         Copy the poses of the bodies that moved in the last Tick to their Entities' Transforms.
+         Sleeping bodies are not visited, so this costs nothing for a settled scene.
+         @return the number of poses written
+         */
+        uint32_t SyncActiveActors();
+
         static void ReleaseStatics();
 
         //scene query methods
         struct RaycastHit {
             RaycastHit() {}
             RaycastHit(const physx::PxRaycastBuffer& hit);
+            RaycastHit(const physx::PxRaycastHit& hit);
+            RaycastHit(const physx::PxSweepHit& hit);
             
             bool hasBlocking{};
             vector3 hitPosition{};
@@ -85,6 +311,7 @@ namespace RavEngine {
             decimalType hitDistance{};
             Entity getEntity() const;
         private:
+            RaycastHit(const physx::PxLocationHit& hit, const physx::PxRigidActor* actor);
             entity_t hitObject = INVALID_ENTITY;
         };
 
@@ -101,9 +328,13 @@ namespace RavEngine {
 
         struct OverlapHit {
             OverlapHit() {}
-            //TODO: FIX
-            OverlapHit(const physx::PxOverlapBuffer& hit)/* : overlapObject( ((PhysicsBodyComponent*)hit.block.actor->userData)->GetOwner())*/{}
-            Ref<Entity> overlapObject;
+            OverlapHit(const physx::PxOverlapBuffer& hit);
+            OverlapHit(const physx::PxOverlapHit& hit);
+
+            bool hasBlocking{};
+            Entity getEntity() const;
+        private:
+            entity_t overlapObject = INVALID_ENTITY;
         };
 
         /**
@@ -135,6 +366,72 @@ namespace RavEngine {
         */
         bool CapsuleOverlap(const vector3& origin, const quaternion& rotation, decimalType radius, decimalType halfheight, OverlapHit& out_hit);
 
+        using QueryFilter = PhysicsQueryFilter;
+
+        struct RayQuery {
+            vector3 origin;
+            vector3 direction;      // must be normalized
+            decimalType maxDistance;
+        };
+
+        // a shape to sweep or test for overlaps
+        struct QueryShape {
+            enum class Type : uint8_t { Box, Sphere, Capsule } type = Type::Sphere;
+            vector3 origin{0, 0, 0};
+            quaternion rotation{1, 0, 0, 0};
+            vector3 size{0, 0, 0};      // half extents of a box, radius of a sphere in x, radius and half height of a capsule in x and y
+
+            static QueryShape Box(const vector3& origin, const quaternion& rotation, const vector3& half_ext);
+            static QueryShape Sphere(const vector3& origin, decimalType radius);
+            static QueryShape Capsule(const vector3& origin, const quaternion& rotation, decimalType radius, decimalType halfheight);
+        };
+
+        struct SweepQuery {
+            QueryShape shape;
+            vector3 direction;      // must be normalized
+            decimalType maxDistance;
+        };
+
+        struct BatchResult {
+            uint32_t nHits = 0;         // hits written to this query's part of the hit buffer
+            bool overflowed = false;    // the query found more hits than its part could hold. Raycasts and sweeps keep the nearest.
+        };
+
+        /**
+        Cast many rays at once. The rays are split into chunks that run in parallel on the App's executor,
+        each under the scene read lock. Ray i writes its hits, nearest first, starting at hits[i * maxHitsPerQuery].
+        @param rays the rays to cast
+        @param hits receives the hits. Must hold rays.size() * maxHitsPerQuery entries.
+        @param results receives the hit count of each ray. Must hold rays.size() entries.
+        @param maxHitsPerQuery the most hits to report per ray. With 1, only the nearest hit is searched for, which is fastest.
+        @param filter what the rays may hit
+        @return the total number of hits
+        */
+        uint32_t RaycastBatch(std::span<const RayQuery> rays, std::span<RaycastHit> hits, std::span<BatchResult> results, uint32_t maxHitsPerQuery = 1, const QueryFilter& filter = {});
+
+        /**
+        Sweep many shapes at once. Works like RaycastBatch. A shape that starts out overlapping a body hits it at distance 0.
+        @param sweeps the shapes to sweep
+        @param hits receives the hits. Must hold sweeps.size() * maxHitsPerQuery entries.
+        @param results receives the hit count of each sweep. Must hold sweeps.size() entries.
+        @param maxHitsPerQuery the most hits to report per sweep
+        @param filter what the sweeps may hit
+        @return the total number of hits
+        */
+        uint32_t SweepBatch(std::span<const SweepQuery> sweeps, std::span<RaycastHit> hits, std::span<BatchResult> results, uint32_t maxHitsPerQuery = 1, const QueryFilter& filter = {});
+
+        /**
+        Test many shapes for overlaps at once. Works like RaycastBatch, except that overlaps have no order, so a query
+        that overflows keeps an arbitrary subset.
+        @param shapes the shapes to test
+        @param hits receives the overlapping bodies. Must hold shapes.size() * maxHitsPerQuery entries.
+        @param results receives the hit count of each shape. Must hold shapes.size() entries.
+        @param maxHitsPerQuery the most hits to report per shape
+        @param filter what the shapes may overlap
+        @return the total number of hits
+        */
+        uint32_t OverlapBatch(std::span<const QueryShape> shapes, std::span<OverlapHit> hits, std::span<BatchResult> results, uint32_t maxHitsPerQuery = 1, const QueryFilter& filter = {});
+
 
     protected:
         struct PhysicsTransform {
@@ -150,5 +447,12 @@ namespace RavEngine {
         @param out_hit the destination to write the results
         */
         bool generic_overlap(const PhysicsTransform& transform, const physx::PxGeometry& geo, OverlapHit& out_hit);
+
+        // add the pre-filter that skips bodies waiting to be removed, while there are any
+        physx::PxQueryFilterData SkipRemoved(physx::PxQueryFilterData data) const;
+
+        // run func(begin, end) over [0, count) in chunks on the App's executor, each holding the scene read lock, and return when all have finished
+        template<typename T>
+        void ParallelChunks(uint32_t count, const T& func);
     };
 }
@@ -49,8 +49,9 @@ namespace RavEngine {
 
 		typedef locked_node_hashmap<uint16_t, rpc_entry, phmap::NullMutex> rpc_store;
 
+        // a received RPC, left in the buffer the networking library received it into until it has been processed
         struct enqueued_rpc {
-			std::string msg;
+			SteamNetworkingMessage_t* msg = nullptr;
 			bool isOwner;
 			HSteamNetConnection origin;
 		};
@@ -63,6 +64,16 @@ namespace RavEngine {
             
             rpc_store ClientRPCs, ServerRPCs;
 
+            ~Data(){
+                // RPCs that arrived after the last RPCSystem tick are dropped
+                for (auto queue : {&C_buffer_A, &C_buffer_B, &S_buffer_A, &S_buffer_B}) {
+                    enqueued_rpc cmd;
+                    while (queue->try_dequeue(cmd)) {
+                        cmd.msg->Release();
+                    }
+                }
+            }
+
             void Swap(){
                 queue_t* reading = readingptr_c.load(), * writing = writingptr_c.load();
                 std::swap(reading, writing);
@@ -134,22 +145,28 @@ namespace RavEngine {
 		*/
         inline void ProcessRPCs_impl(const std::atomic<queue_t*>& ptr, const rpc_store& table) {
 			auto reading = ptr.load();
-			enqueued_rpc cmd;
-			while (reading->try_dequeue(cmd)) {
-				//read out of the header which RPC to invoke
-				uint16_t RPC;
-				std::memcpy(&RPC, cmd.msg.data() + RPCMsgUnpacker::code_offset, sizeof(RPC));
+			enqueued_rpc cmds[64];
+			while (auto count = reading->try_dequeue_bulk(cmds, std::size(cmds))) {
+				for (size_t i = 0; i < count; i++) {
+					auto& cmd = cmds[i];
+					const std::string_view msg(static_cast<const char*>(cmd.msg->m_pData), cmd.msg->m_cbSize);
+
+					//read out of the header which RPC to invoke
+					uint16_t RPC;
+					std::memcpy(&RPC, msg.data() + RPCMsgUnpacker::code_offset, sizeof(RPC));
 
-				//invoke that RPC
-				if (table.if_contains(RPC, [&](const rpc_entry& func) {
-					if (cmd.isOwner || func.mode == Directionality::Bidirectional) {
-                        RPCMsgUnpacker packer{cmd.msg};
-						func.func(packer, cmd.origin);
+					//invoke that RPC
+					if (table.if_contains(RPC, [&](const rpc_entry& func) {
+						if (cmd.isOwner || func.mode == Directionality::Bidirectional) {
+							RPCMsgUnpacker packer{msg};
+							func.func(packer, cmd.origin);
+						}
+						})) {
 					}
-					})) {
-				}
-				else {
-					Debug::Warning("No cmd code with ID {}", RPC);
+					else {
+						Debug::Warning("No cmd code with ID {}", RPC);
+					}
+					cmd.msg->Release();
 				}
 			}
 		}
@@ -234,16 +251,18 @@ namespace RavEngine {
 
 		/**
 		Invoked automatically. For internal use only.
+		@param msg the received RPC. The component takes ownership, and releases it once the RPC has run.
 		*/
-        inline void CacheClientRPC(const std::string_view& cmd, bool isOwner, HSteamNetConnection origin) {
-			data->writingptr_c.load()->enqueue({ std::string(cmd.data(),cmd.size()), isOwner, origin });
+        inline void CacheClientRPC(SteamNetworkingMessage_t* msg, bool isOwner, HSteamNetConnection origin) {
+			data->writingptr_c.load()->enqueue({ msg, isOwner, origin });
 		}
 
 		/**
 		Invoked automatically. For internal use only.
+		@param msg the received RPC. The component takes ownership, and releases it once the RPC has run.
 		*/
-        inline void CacheServerRPC(const std::string_view& cmd, bool isOwner, HSteamNetConnection origin) {
-			data->writingptr_s.load()->enqueue({ std::string(cmd.data(),cmd.size()), isOwner, origin });
+        inline void CacheServerRPC(SteamNetworkingMessage_t* msg, bool isOwner, HSteamNetConnection origin) {
+			data->writingptr_s.load()->enqueue({ msg, isOwner, origin });
 		}
 
 		/**
@@ -1,11 +1,11 @@
 #pragma once
-#include <string>
+#include <string_view>
 #include <optional>
 #include <cstring>
 
 namespace RavEngine {
 	class RPCMsgUnpacker {
-		std::string message;
+		std::string_view message;
 		uint32_t offset = header_size;   //advance past the RPC message header
         
         template<typename T>
@@ -19,7 +19,10 @@ namespace RavEngine {
         static constexpr size_t code_offset = 16 + 1;
         static constexpr size_t header_size = code_offset + sizeof(uint16_t);    //uuid, command code, method ID
         
-		RPCMsgUnpacker(const std::string& msg) : message(msg) {}
+        /**
+        @param msg the serialized RPC. The unpacker reads it in place, so it must outlive the unpacker.
+        */
+		RPCMsgUnpacker(std::string_view msg) : message(msg) {}
 
 		template<typename T>
         constexpr inline std::optional<T> Get() {
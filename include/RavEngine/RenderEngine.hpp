@@ -16,6 +16,8 @@
 #include <RGL/Types.hpp>
 #include <RGL/TextureFormat.hpp>
 #include <RGL/Buffer.hpp>
+#include <RGL/Texture.hpp>
+#include "MemoryTracker.hpp"
 #include <span>
 #include "SpinLock.hpp"
 #include "MeshAllocation.hpp"
@@ -262,6 +264,54 @@ namespace RavEngine {
 		auto GetDevice() {
 			return device;
 		}
+
+		/**
+		 Create a buffer on the device. The buffer's size is charged to the MemoryTracker until its last reference is released.
+		 @param config the buffer description
+		 @param tag the category to charge
+		 */
+		RGLBufferPtr CreateBuffer(const RGL::BufferConfig& config, MemoryTag tag = MemoryTag::GPUBuffers);
+
+		/**
+		 Create a texture on the device. The texture's estimated size is charged to the MemoryTracker until its last reference is released.
+		 @param config the texture description
+		 @param tag the category to charge
+		 */
+		RGLTexturePtr CreateTexture(const RGL::TextureConfig& config, MemoryTag tag = MemoryTag::Textures);
+
+		/**
+		 Create a texture on the device with initial contents. See CreateTexture.
+		 */
+		RGLTexturePtr CreateTextureWithData(const RGL::TextureConfig& config, RGL::untyped_span data, MemoryTag tag = MemoryTag::Textures);
+
+		/**
+		 Create a buffer on a given device and charge its size to tag. The member overloads call this with the engine's device.
+		 */
+		template<typename device_t>
+		static auto CreateBuffer(device_t& device, const RGL::BufferConfig& config, MemoryTag tag){
+			return MemoryTracker::TrackSharedResource(device.CreateBuffer(config), size_t(config.nElements) * config.stride, tag);
+		}
+
+		/**
+		 Create a texture on a given device and charge its estimated size to tag. See CreateBuffer.
+		 */
+		template<typename device_t>
+		static auto CreateTexture(device_t& device, const RGL::TextureConfig& config, MemoryTag tag){
+			return MemoryTracker::TrackSharedResource(device.CreateTexture(config), EstimateTextureSize(config), tag);
+		}
+
+		/**
+		 Create a texture with initial contents on a given device and charge its estimated size to tag. See CreateBuffer.
+		 */
+		template<typename device_t>
+		static auto CreateTextureWithData(device_t& device, const RGL::TextureConfig& config, RGL::untyped_span data, MemoryTag tag){
+			return MemoryTracker::TrackSharedResource(device.CreateTextureWithData(config, data), EstimateTextureSize(config), tag);
+		}
+
+		/**
+		 @return the number of bytes a texture with this description occupies, including mips and layers
+		 */
+		static size_t EstimateTextureSize(const RGL::TextureConfig& config);
         
 		ConcurrentQueue<RGLBufferPtr> gcBuffers;
 		ConcurrentQueue<RGLTexturePtr> gcTextures;
@@ -1,36 +1,179 @@
 #pragma once
 #include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace RavEngine{
 
 /**
-  A spinlock implemented using std::atomic_flag, which uses test-and-set instead of kernel calls.
+ Hint to the CPU that the caller is in a spin-wait loop. Reduces power use and
+ frees pipeline resources for a hyperthread sibling that may be holding the lock.
+ */
+static inline void cpu_pause(){
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	_mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+	_mm_pause();
+#elif defined(_MSC_VER) && (defined(_M_ARM) || defined(_M_ARM64))
+	__yield();
+#elif defined(__arm__) || defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+/**
+ Contention counters for an InstrumentedSpinLock. Values are approximate when read while the lock is in use.
+ */
+struct SpinLockStatistics{
+	std::atomic<uint64_t> acquisitions = 0;			// total successful lock() / try_lock() calls
+	std::atomic<uint64_t> contendedAcquisitions = 0;	// acquisitions that did not succeed on the first attempt
+	std::atomic<uint64_t> spins = 0;				// backoff rounds spent waiting
+	std::atomic<uint64_t> sleeps = 0;				// times a waiter gave up spinning and blocked
+	std::atomic<uint64_t> maxWaitNanoseconds = 0;	// longest time a single lock() call waited
+
+	void Reset(){
+		acquisitions = 0;
+		contendedAcquisitions = 0;
+		spins = 0;
+		sleeps = 0;
+		maxWaitNanoseconds = 0;
+	}
+};
+
+/**
+ A lock that spins in user space with exponential backoff before blocking in the kernel.
+ Uncontended lock / unlock are a single atomic operation each. Under contention, waiters
+ pause with increasing intervals, and after a fixed spin budget, sleep on the lock word
+ (futex / WaitOnAddress / ulock where available, otherwise yield) so that an oversubscribed
+ system does not starve the holder.
+ @tparam collectStatistics if true, the lock records contention counters. See InstrumentedSpinLock.
  */
-class SpinLock{
-	std::atomic_flag flag
-#ifndef _WIN32
-		ATOMIC_FLAG_INIT
+template<bool collectStatistics>
+class BasicSpinLock{
+	// 0 = unlocked, 1 = locked, 2 = locked and there may be sleeping waiters
+	std::atomic<uint32_t> state = 0;
+
+	struct empty_t{};
+	[[no_unique_address]] std::conditional_t<collectStatistics, SpinLockStatistics, empty_t> stats;
+
+	constexpr static uint32_t max_backoff = 64;		// pauses per round at the end of the backoff
+	constexpr static uint32_t spin_budget = 16;		// backoff rounds before a waiter sleeps
+
+	inline bool try_acquire(){
+		uint32_t expected = 0;
+		return state.compare_exchange_weak(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	// phase 1: spin with exponential backoff, reading only (no cache line ping-pong)
+	inline bool spin_acquire(){
+		uint32_t backoff = 1;
+		for(uint32_t round = 0; round < spin_budget; round++){
+			for(uint32_t i = 0; i < backoff; i++){
+				cpu_pause();
+			}
+			if constexpr (collectStatistics){
+				stats.spins.fetch_add(1, std::memory_order_relaxed);
+			}
+			if (state.load(std::memory_order_relaxed) == 0 && try_acquire()){
+				return true;
+			}
+			backoff = backoff < max_backoff ? backoff * 2 : max_backoff;
+		}
+		return false;
+	}
+
+	void lock_contended(){
+		std::chrono::steady_clock::time_point begin;
+		if constexpr (collectStatistics){
+			begin = std::chrono::steady_clock::now();
+			stats.contendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (!spin_acquire()){
+			// phase 2: announce that we are sleeping, then block until woken
+			while (state.exchange(2, std::memory_order_acquire) != 0){
+				if constexpr (collectStatistics){
+					stats.sleeps.fetch_add(1, std::memory_order_relaxed);
+				}
+#if defined(__cpp_lib_atomic_wait)
+				state.wait(2, std::memory_order_relaxed);
+#else
+				std::this_thread::yield();
 #endif
-		;
+			}
+		}
+
+		if constexpr (collectStatistics){
+			uint64_t waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+			auto prev = stats.maxWaitNanoseconds.load(std::memory_order_relaxed);
+			while (prev < waited && !stats.maxWaitNanoseconds.compare_exchange_weak(prev, waited, std::memory_order_relaxed));
+		}
+	}
+
 public:
-    inline void lock(){
-		while(flag.test_and_set());
-	}
-	
-    inline void unlock(){
-		flag.clear();
-	}
-    
-    // constructors and operators
-    SpinLock(){};
-    //SpinLock(SpinLock&& other){}
-    
-    // copy-assign or copy-construct a lock does NOT
-    // copy its state. These exist as conveniences for other things. 
-    SpinLock(const SpinLock& other){}
-    inline void operator=(const SpinLock& other){}
+	inline void lock(){
+		if (!try_acquire()){
+			lock_contended();
+		}
+		if constexpr (collectStatistics){
+			stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	inline bool try_lock(){
+		uint32_t expected = 0;
+		bool result = state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+		if constexpr (collectStatistics){
+			if (result){
+				stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		return result;
+	}
+
+	inline void unlock(){
+		// only pay for a wake if someone may be sleeping
+		if (state.exchange(0, std::memory_order_release) == 2){
+#if defined(__cpp_lib_atomic_wait)
+			state.notify_one();
+#endif
+		}
+	}
+
+	/**
+	 @return the contention counters for this lock
+	 */
+	template<bool enabled = collectStatistics, typename = std::enable_if_t<enabled>>
+	inline SpinLockStatistics& GetStatistics(){
+		return stats;
+	}
+
+	// constructors and operators
+	BasicSpinLock(){};
+
+	// copy-assign or copy-construct a lock does NOT
+	// copy its state. These exist as conveniences for other things.
+	BasicSpinLock(const BasicSpinLock& other){}
+	inline void operator=(const BasicSpinLock& other){}
 };
 
+/**
+ The general-purpose engine lock. Use for short critical sections.
+ */
+using SpinLock = BasicSpinLock<false>;
+
+/**
+ A SpinLock that also records contention counters. Substitute it for a SpinLock to profile a hot lock.
+ */
+using InstrumentedSpinLock = BasicSpinLock<true>;
+
 // do not dynamic allocate
 template<typename T>
 struct RAIILock {
@@ -0,0 +1,107 @@
+#pragma once
+#include "DataStructures.hpp"
+#include "Function.hpp"
+#include <array>
+#include <cstdint>
+
+namespace RavEngine{
+
+/**
+ A hierarchical timing wheel for delayed callbacks. Scheduling and cancelling are O(1),
+ and advancing time only touches timers that have expired, plus an occasional cascade of
+ far-future timers into a nearer level. Time is quantized into ticks of a fixed resolution.
+ Timers live in a slab and are addressed by generation-checked handles, so cancelling a timer
+ that has already fired or been cancelled is safe.
+ @note This class is not thread-safe. World guards its instance with a lock.
+ */
+class TimerWheel{
+public:
+    using callback_t = Function<void(void)>;
+
+    /**
+     Identifies a scheduled timer. Handles are invalidated when the timer fires or is cancelled.
+     */
+    struct Handle{
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        inline bool IsValid() const{
+            return index != UINT32_MAX;
+        }
+    };
+
+    /**
+     @param resolutionSeconds the length of one tick. Timers fire on the first Advance at or after their tick.
+     */
+    TimerWheel(double resolutionSeconds = 0.001);
+
+    /**
+     Schedule a callback
+     @param time the absolute time, in seconds, at which the callback becomes due. Times in the past fire on the next Advance.
+     @param func the function to run
+     @return a handle that can be passed to Cancel
+     */
+    Handle Schedule(double time, const callback_t& func);
+
+    /**
+     Cancel a pending timer
+     @param handle the handle returned from Schedule
+     @return true if the timer was pending and is now cancelled, false if it already fired or was cancelled
+     */
+    bool Cancel(Handle handle);
+
+    /**
+     @return true if the timer has neither fired nor been cancelled
+     */
+    bool IsPending(Handle handle) const;
+
+    /**
+     Advance the wheel and collect every timer that is due. The timers are released before this function returns.
+     @param time the current absolute time, in seconds
+     @param expired destination for the callbacks of the due timers, which are appended in no particular order
+     */
+    void Advance(double time, Vector<callback_t>& expired);
+
+    /**
+     @return the number of pending timers
+     */
+    inline size_t size() const{
+        return pendingCount;
+    }
+
+    inline double GetResolution() const{
+        return resolution;
+    }
+
+private:
+    constexpr static uint32_t slot_bits = 8;
+    constexpr static uint32_t slots_per_level = 1 << slot_bits;
+    constexpr static uint32_t slot_mask = slots_per_level - 1;
+    constexpr static uint32_t n_levels = 4;
+    constexpr static uint32_t npos = UINT32_MAX;
+
+    struct Node{
+        callback_t func;
+        uint64_t expiry = 0;            // in ticks
+        uint32_t next = npos, prev = npos;
+        uint32_t generation = 0;
+        uint32_t slot = npos;           // level * slots_per_level + index, or npos if free
+    };
+
+    Vector<Node> nodes;
+    uint32_t freeHead = npos;
+    std::array<uint32_t, n_levels * slots_per_level> slotHeads;
+    std::array<uint32_t, n_levels> levelCounts{};
+
+    double resolution;
+    uint64_t nextTick = 0;              // the next tick that Advance will process
+    size_t pendingCount = 0;
+
+    uint32_t AllocateNode();
+    void FreeNode(uint32_t index);
+    void Place(uint32_t index);
+    void Unlink(uint32_t index);
+    void Cascade(uint32_t level);
+};
+
+}
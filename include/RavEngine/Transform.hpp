@@ -27,10 +27,15 @@ namespace RavEngine {
 
 		friend class World;
 		mutable bool isTickDirty = false;	// used for when this transform has been updated in the current tick and needs updating in the world's render data
+
+		friend class PhysicsLinkSystemWrite;
+		friend class PhysicsSolver;
+		mutable bool isPhysicsDirty = false;	// used for when this transform has been updated since its pose was last written to, or read from, the physics simulation
         
         inline void MarkAsDirty(Transform* root) const{
             root->isDirty = true;
 			root->isTickDirty = true;
+			root->isPhysicsDirty = true;
             
             for(auto& t : root->children){
                 MarkAsDirty(t.get());
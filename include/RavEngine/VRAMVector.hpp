@@ -3,6 +3,7 @@
 #include <RGL/Buffer.hpp>
 #include <RGL/Device.hpp>
 #include <cassert>
+#include "MemoryTracker.hpp"
 
 namespace RavEngine {
 
@@ -105,7 +106,7 @@ namespace RavEngine {
 			auto oldbuffer = buffer;
 			
 			settings.nElements = newSize;
-			buffer = owningDevice->CreateBuffer(settings);
+			buffer = MemoryTracker::TrackSharedResource(owningDevice->CreateBuffer(settings), size_t(settings.nElements) * settings.stride, MemoryTag::GPUBuffers);
 			buffer->MapMemory();
 			if (oldbuffer) {
 				// copy over old data
@@ -19,6 +19,8 @@
 #include "BuiltinMaterials.hpp"
 #include "Light.hpp"
 #include "Utilities.hpp"
+#include "TimerWheel.hpp"
+#include <algorithm>
 
 namespace RavEngine {
 	struct Entity;
@@ -910,8 +912,6 @@ namespace RavEngine {
                     
                     // use `A...` here
                     
-                    auto ptr = &ecsRangeSizes[CTTI<T>()];
-                    
                     FuncModeCopy<T,polymorphic> fm{T(args...)};
                     
                     auto fd = GenFilterData<A...>(fm);
@@ -920,21 +920,37 @@ namespace RavEngine {
                     
                     auto setptr = fd.getMainFilter();
                     
-                    // value update
-                    auto range_update = ECSTasks.emplace([this,ptr,setptr](){
-                        *ptr = static_cast<pos_t>(setptr->DenseSize());
-                    }).name(StrFormat("{} range update",type_name<T>()));
+                    auto& record = systemRecords[CTTI<T>()];
+                    record.getCount = [setptr](){
+                        return static_cast<pos_t>(setptr->DenseSize());
+                    };
+                    record.runRange = [this,fom](pos_t begin, pos_t end) mutable{
+                        for(pos_t i = begin; i < end; i++){
+                            FilterOne<A...>(fom,i);
+                        }
+                    };
+                    auto recordptr = &record;
                     
-                    auto do_task = ECSTasks.for_each_index(pos_t(0),std::ref(*ptr),pos_t(1),[this,fom](auto i) mutable{
-                        FilterOne<A...>(fom,i);
-                    }).name(StrFormat("{}",type_name<T>().data()));
-                    range_update.precede(do_task);
+                    // entry point for timed conditions and other external predecessors
+                    record.prepare = ECSTasks.emplace([](){}).name(StrFormat("{} prepare",type_name<T>()));
                     
-                    auto pair = std::make_pair(range_update,do_task);
+                    // decides per tick how to run the system, see RunSystem
+                    record.execute = ECSTasks.emplace([this,recordptr](tf::Subflow& subflow){
+                        if (recordptr->runByBatchLeader){
+                            return;
+                        }
+                        RunSystem(*recordptr, &subflow);
+                        for(auto member : recordptr->fusedBatch){
+                            RunSystem(*member, nullptr);
+                        }
+                    }).name(StrFormat("{}",type_name<T>().data()));
+                    record.prepare.precede(record.execute);
                     
-                    typeToSystem[CTTI<T>()] = pair;
+                    if (std::find(systemOrder.begin(), systemOrder.end(), CTTI<T>()) == systemOrder.end()){
+                        systemOrder.push_back(CTTI<T>());
+                    }
                     
-                    return pair;
+                    return std::make_pair(record.prepare,record.execute);
                     
                 }(std::type_identity<argtypes_noref>{},args...);
             }(std::type_identity<argtypes>{},args...);
@@ -962,10 +978,10 @@ namespace RavEngine {
         template<typename T, typename U>
         inline void CreateDependency(){
             // T depends on (runs after) U
-            auto& tPair = typeToSystem.at(CTTI<T>());
-            auto& uPair = typeToSystem.at(CTTI<U>());
+            auto& tRecord = systemRecords.at(CTTI<T>());
+            auto& uRecord = systemRecords.at(CTTI<U>());
             
-            tPair.second.succeed(uPair.second);
+            tRecord.execute.succeed(uRecord.execute);
         }
         
         template<typename T, typename ... Args>
@@ -975,10 +991,11 @@ namespace RavEngine {
 
         template<typename T>
         inline void RemoveSystem() {
-            auto& tpair = typeToSystem.at(CTTI<T>());
-            ECSTasks.erase(tpair.first);
-            ECSTasks.erase(tpair.second);
-            typeToSystem.erase(CTTI<T>());
+            auto& record = systemRecords.at(CTTI<T>());
+            ECSTasks.erase(record.prepare);
+            ECSTasks.erase(record.execute);
+            systemRecords.erase(CTTI<T>());
+            systemOrder.erase(std::remove(systemOrder.begin(), systemOrder.end(), CTTI<T>()), systemOrder.end());
         }
         
         template<typename T, typename interval_t, typename ... Args>
@@ -996,6 +1013,37 @@ namespace RavEngine {
             EmplaceTimedSystemGeneric<true,T>(interval,args...);
         }
         
+        /**
+         Tuning for the System scheduler. Each tick, every System is run either serially or split
+         into parallel chunks, based on moving averages of its cost in previous ticks.
+         Independent Systems that are consistently tiny are batched into a single task.
+         */
+        struct SystemSchedulingConfig{
+            double serialThresholdMicros = 50;     // Systems estimated to cost less than this run on one thread
+            double targetChunkMicros = 20;         // desired amount of work per parallel chunk
+            double fuseThresholdMicros = 5;        // independent Systems cheaper than this may be batched together
+            uint32_t maxChunksPerWorker = 4;       // upper bound on chunks per System, relative to the number of workers
+            double smoothing = 0.1;                // weight of the newest sample in the moving averages
+            bool adaptive = true;                  // if false, every entity is a separate parallel work item (no cost model)
+        } systemSchedulingConfig;
+        
+        struct SystemStatistics{
+            double avgMicros = 0;                  // moving average of the total work time per tick, summed across threads
+            double avgEntityCount = 0;             // moving average of the number of entities processed per tick
+            double avgNanosPerEntity = 0;          // moving average of the per-entity cost
+            pos_t lastEntityCount = 0;             // entities processed in the most recent tick
+            pos_t lastChunkCount = 0;              // parallel chunks used in the most recent tick, 1 = serial
+            bool lastFused = false;                // true if the System ran inside another System's batch in the most recent tick
+        };
+        
+        /**
+         @return the scheduler statistics for a System
+         */
+        template<typename T>
+        inline const SystemStatistics& GetSystemStatistics() const{
+            return systemRecords.at(CTTI<T>()).stats;
+        }
+        
 	private:
 		std::atomic<bool> isRendering = false;
         char worldIDbuf [id_size]{0};
@@ -1006,6 +1054,8 @@ namespace RavEngine {
         tf::Task renderTaskModule;
         tf::Task ECSTaskModule;
         tf::Task audioTaskModule;
+        tf::Task physicsSyncTask;
+        tf::Task physicsWriteTask;
         
         struct TypeErasureIterator{
             constexpr static auto size = sizeof(EntitySparseSet<size_t>::const_iterator);
@@ -1026,28 +1076,36 @@ namespace RavEngine {
              std::chrono::time_point<e_clock_t> last_timestamp = e_clock_t::now();
         };
         UnorderedNodeMap<ctti_t, TimedSystemEntry> timedSystemRecords;
-        UnorderedNodeMap<ctti_t, pos_t> ecsRangeSizes;
-        UnorderedMap<ctti_t, std::pair<tf::Task,tf::Task>> typeToSystem;
+        
+        struct SystemRecord{
+            Function<pos_t()> getCount;
+            Function<void(pos_t,pos_t)> runRange;  // process dense indices [begin, end)
+            SystemStatistics stats;
+            bool hasCostHistory = false;           // true once avgNanosPerEntity has a sample
+            bool sampled = false;                  // true once the System has run at least once
+            
+            // batching, rebuilt by PlanSystemSchedule before each tick
+            Vector<SystemRecord*> fusedBatch;      // on a batch leader, the Systems it runs on their behalf
+            bool runByBatchLeader = false;
+            
+            tf::Task prepare, execute;
+        };
+        UnorderedNodeMap<ctti_t, SystemRecord> systemRecords;
+        Vector<ctti_t> systemOrder;                // in order of emplacement
+        
+        void PlanSystemSchedule();
+        void RunSystem(SystemRecord& record, tf::Subflow* subflow);
         				
 		void SetupTaskGraph();
 		
 		std::chrono::time_point<e_clock_t> time_now = e_clock_t::now();
 		float currentFPSScale = 0.01f;
 		
-		//Entity list
-        struct dispatched_func{
-            double runAtTime = 0;
-            Function<void(void)> func;
-            dispatched_func(const decltype(runAtTime) rt,const decltype(func)& func) : func(func), runAtTime(rt){}
-            dispatched_func(const dispatched_func& other){
-                runAtTime = other.runAtTime;
-                func = other.func;
-            }
-            dispatched_func(){}
-        };
-        UnorderedContiguousSet<std::shared_ptr<dispatched_func>> async_tasks;
-        decltype(async_tasks)::iterator async_begin, async_end;
-        RavEngine::Vector<size_t> ranFunctions;
+		// delayed functions from DispatchAsync
+        TimerWheel asyncTimers;
+        SpinLock asyncTimersLock;
+        Vector<TimerWheel::callback_t> expiredAsync;
+        decltype(expiredAsync)::iterator async_begin, async_end;
 	protected:
         
 		//physics system
@@ -1153,9 +1211,17 @@ namespace RavEngine {
          Dispatch a function to run in a given number of seconds in the future
          @param func the function to run
          @param delaySeconds the delay in the future to run
+         @return a handle that can be passed to CancelAsync
          @note You must ensure data your function references is kept loaded when this function runs. For example, to keep an entity loaded, capture by value an owning pointer to it. In addition, do not make assumptions about what thread your dispatched function runs on.
          */
-        void DispatchAsync(const Function<void(void)>& func, double delaySeconds);
+        TimerWheel::Handle DispatchAsync(const Function<void(void)>& func, double delaySeconds);
+        
+        /**
+         Cancel a function dispatched with DispatchAsync
+         @param handle the handle returned from DispatchAsync
+         @return true if the function had not yet run and will now never run
+         */
+        bool CancelAsync(TimerWheel::Handle handle);
         
         template<typename T>
         inline auto GetAllComponentsOfType(){
@@ -1,30 +1,328 @@
 #include "AudioGraphAsset.hpp"
 #include "AudioPlayer.hpp"
+#include <algorithm>
+#include <cmath>
 
 using namespace RavEngine;
 
+namespace{
+
+inline uint32_t ResolveRate(uint32_t layerRate, uint32_t playerRate){
+    if (layerRate != 0){
+        return layerRate;
+    }
+    return playerRate != 0 ? playerRate : 44'100;   // the player's rate is unknown before the device opens
+}
+
+// one pole smoothing coefficient for an envelope that moves about 63% of the way in `seconds`
+inline float SmoothingCoefficient(float seconds, uint32_t rate){
+    return seconds > 0 ? std::exp(-1.0f / (seconds * rate)) : 0.0f;
+}
+
+inline size_t DelayLineLength(const AudioDelayFilterLayer& layer, uint32_t rate){
+    return static_cast<size_t>(std::ceil(std::max(layer.maxDelaySeconds, 0.0f) * rate)) + 2;
+}
+
+inline size_t DelayInSamples(const AudioDelayFilterLayer& layer, uint32_t rate, size_t lineLength){
+    return std::clamp<size_t>(static_cast<size_t>(std::lround(std::max(layer.delaySeconds, 0.0f) * rate)), 1, lineLength - 1);
+}
+
+// transposed direct form II. The state stays in registers for the whole run.
+void BiquadKernel(float* data, size_t nframes, const AudioBiquadFilterLayer::Coefficients& k, float& z1, float& z2){
+    float s1 = z1, s2 = z2;
+    for(size_t i = 0; i < nframes; i++){
+        const float x = data[i];
+        const float y = k.b0 * x + s1;
+        s1 = k.b1 * x - k.a1 * y + s2;
+        s2 = k.b2 * x - k.a2 * y;
+        data[i] = y;
+    }
+    z1 = s1;
+    z2 = s2;
+}
+
+struct CompressorParams{
+    float attack, release, threshold, invThreshold, exponent, makeup;
+    CompressorParams(const AudioCompressorFilterLayer& layer, uint32_t rate) :
+        attack(SmoothingCoefficient(layer.attackSeconds, rate)),
+        release(SmoothingCoefficient(layer.releaseSeconds, rate)),
+        threshold(layer.threshold),
+        invThreshold(1.0f / layer.threshold),
+        exponent(1.0f / std::max(layer.ratio, 1.0f) - 1.0f),
+        makeup(layer.makeupGain){}
+
+    inline float Step(float x, float& env) const{
+        const float level = std::fabs(x);
+        env = level + (level > env ? attack : release) * (env - level);
+        const float gain = env > threshold ? std::pow(env * invThreshold, exponent) : 1.0f;
+        return x * (gain * makeup);
+    }
+};
+
+void CompressorKernel(float* data, size_t nframes, const CompressorParams& params, float& envelope){
+    float env = envelope;
+    for(size_t i = 0; i < nframes; i++){
+        data[i] = params.Step(data[i], env);
+    }
+    envelope = env;
+}
+
+// processes runs that wrap neither the read nor the write position and are no longer than the delay,
+// so that each run reads only samples written before it and the loop body has no dependencies
+void DelayKernel(float* data, size_t nframes, float* line, size_t lineLength, size_t delay, size_t position, float feedback, float wet, float dry){
+    size_t read = (position + lineLength - delay) % lineLength;
+    size_t write = position;
+    size_t i = 0;
+    while (i < nframes){
+        const size_t run = std::min({nframes - i, delay, lineLength - read, lineLength - write});
+        float* x = data + i;
+        const float* delayed = line + read;
+        float* fed = line + write;
+#pragma omp simd
+        for(size_t j = 0; j < run; j++){
+            const float in = x[j];
+            const float d = delayed[j];
+            x[j] = dry * in + wet * d;
+            fed[j] = in + feedback * d;
+        }
+        i += run;
+        read = (read + run) % lineLength;
+        write = (write + run) % lineLength;
+    }
+}
+
+}
+
+AudioBiquadFilterLayer::Coefficients AudioBiquadFilterLayer::GetCoefficients() const{
+    const double rate = ResolveRate(sampleRate, AudioPlayer::GetSamplesPerSec());
+    const double f = std::clamp<double>(cutoff, 1, rate * 0.499);
+    const double w0 = 2 * 3.14159265358979323846 * f / rate;
+    const double cosw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2 * std::max<double>(q, 1e-3));
+    const double a0 = 1 + alpha;
+    double b0, b1;
+    if (mode == Mode::LowPass){
+        b0 = (1 - cosw) / 2;
+        b1 = 1 - cosw;
+    }
+    else{
+        b0 = (1 + cosw) / 2;
+        b1 = -(1 + cosw);
+    }
+    return {float(b0 / a0), float(b1 / a0), float(b0 / a0), float(-2 * cosw / a0), float((1 - alpha) / a0)};
+}
+
+void AudioBiquadFilterLayer::process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out){
+    const auto k = GetCoefficients();
+    const auto nchannels = in.GetNChannels();
+    if (history.size() < nchannels * 2){
+        history.resize(nchannels * 2, 0);
+    }
+    for(uint8_t c = 0; c < nchannels; c++){
+        auto input = in[c];
+        auto output = out[c];
+        float& z1 = history[c * 2];
+        float& z2 = history[c * 2 + 1];
+        for(size_t i = 0; i < input.size(); i++){
+            const float x = input[i];
+            const float y = k.b0 * x + z1;
+            z1 = k.b1 * x - k.a1 * y + z2;
+            z2 = k.b2 * x - k.a2 * y;
+            output[i] = y;
+        }
+    }
+}
+
+void AudioCompressorFilterLayer::process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out){
+    const CompressorParams params(*this, ResolveRate(sampleRate, AudioPlayer::GetSamplesPerSec()));
+    const auto nchannels = in.GetNChannels();
+    if (envelope.size() < nchannels){
+        envelope.resize(nchannels, 0);
+    }
+    for(uint8_t c = 0; c < nchannels; c++){
+        auto input = in[c];
+        auto output = out[c];
+        for(size_t i = 0; i < input.size(); i++){
+            output[i] = params.Step(input[i], envelope[c]);
+        }
+    }
+}
+
+void AudioDelayFilterLayer::process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out){
+    const auto rate = ResolveRate(sampleRate, AudioPlayer::GetSamplesPerSec());
+    const auto nchannels = in.GetNChannels();
+    if (lineLength == 0){
+        lineLength = DelayLineLength(*this, rate);
+    }
+    if (line.size() < lineLength * nchannels){
+        line.resize(lineLength * nchannels, 0);
+    }
+    const auto delay = DelayInSamples(*this, rate, lineLength);
+    const auto nframes = in.sizeOneChannel();
+    for(uint8_t c = 0; c < nchannels; c++){
+        auto input = in[c];
+        auto output = out[c];
+        float* ring = line.data() + c * lineLength;
+        for(size_t i = 0; i < nframes; i++){
+            const size_t write = (position + i) % lineLength;
+            const float x = input[i];
+            const float d = ring[(write + lineLength - delay) % lineLength];
+            output[i] = dry * x + wet * d;
+            ring[write] = x + feedback * d;
+        }
+    }
+    position = (position + nframes) % lineLength;
+}
+
 AudioGraphAsset::AudioGraphAsset(uint8_t nchannels) :
     nchannels(nchannels)
 {
-   
+
+}
+
+bool AudioGraphAsset::NeedsCompile(uint32_t sampleRate) const{
+    if (!program || sampleRate != program->sampleRate || filters.size() != program->layers.size()){
+        return true;
+    }
+    size_t i = 0;
+    for(const auto& filter : filters){
+        if (filter != program->layers[i++]){
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<const AudioGraphAsset::Program> AudioGraphAsset::Compile(uint32_t sampleRate) const{
+    auto compiled = std::make_shared<Program>();
+    auto& nodes = compiled->nodes;
+    auto& stateSize = compiled->stateSize;
+    for(const auto& filter : filters){
+        const auto index = static_cast<uint32_t>(compiled->layers.size());
+        auto layer = filter.get();
+        compiled->layers.push_back(filter);
+
+        if (dynamic_cast<AudioGainFilterLayer*>(layer)){
+            // extend the chain if the previous layer was also a gain
+            if (!nodes.empty() && nodes.back().kind == CompiledNode::Kind::Gain){
+                nodes.back().nlayers++;
+            }
+            else{
+                nodes.push_back({CompiledNode::Kind::Gain, index, 1, 0});
+            }
+        }
+        else if (dynamic_cast<AudioBiquadFilterLayer*>(layer)){
+            nodes.push_back({CompiledNode::Kind::Biquad, index, 1, stateSize});
+            stateSize += nchannels * 2;
+        }
+        else if (dynamic_cast<AudioCompressorFilterLayer*>(layer)){
+            nodes.push_back({CompiledNode::Kind::Compressor, index, 1, stateSize});
+            stateSize += nchannels;
+        }
+        else if (auto delay = dynamic_cast<AudioDelayFilterLayer*>(layer)){
+            const auto lineLength = DelayLineLength(*delay, ResolveRate(delay->sampleRate, sampleRate));
+            nodes.push_back({CompiledNode::Kind::Delay, index, 1, stateSize, lineLength});
+            stateSize += nchannels * lineLength;
+        }
+        else{
+            nodes.push_back({CompiledNode::Kind::Custom, index, 1, 0});
+        }
+    }
+    compiled->sampleRate = sampleRate;
+    return compiled;
+}
+
+std::shared_ptr<const AudioGraphAsset::Program> AudioGraphAsset::GetProgram(uint32_t sampleRate){
+    // a replaced program, and the layers it points to, stay alive until the last voice rendering it lets go
+    std::lock_guard lock(programLock);
+    if (NeedsCompile(sampleRate)){
+        program = Compile(sampleRate);
+    }
+    return program;
+}
+
+void AudioGraphState::Reset(){
+    std::fill(values.begin(), values.end(), 0.0f);
+    std::fill(positions.begin(), positions.end(), 0);
+}
+
+void AudioGraphAsset::Reset(){
+    ownState.Reset();
 }
 
-void AudioGraphAsset::Render(PlanarSampleBufferInlineView& inout, PlanarSampleBufferInlineView& scratchBuffer, uint8_t nchannels){
+void AudioGraphAsset::Render(PlanarSampleBufferInlineView& inout, PlanarSampleBufferInlineView& scratchBuffer, uint8_t nchannels, AudioGraphState& state){
     assert(this->nchannels == nchannels);
-    
-    // iterate the stack
-    for (auto& filter : filters) {
-        // call filter
-        filter->process(inout, scratchBuffer);
-        
-        //inout will now have the results of processing
-        std::swap(inout, scratchBuffer);
+
+    const auto playerRate = AudioPlayer::GetSamplesPerSec();
+    const auto program = GetProgram(playerRate);
+    if (state.program != program){
+        // a new voice, or the graph changed since this voice last rendered: start its filters over
+        state.values.assign(program->stateSize, 0.0f);
+        state.positions.assign(program->nodes.size(), 0);
+        state.program = program;
+    }
+    const auto& compiledLayers = program->layers;
+
+    // built-in nodes work in place on `current`. Custom layers write to the other buffer, so the two swap.
+    PlanarSampleBufferInlineView current = inout, other = scratchBuffer;
+    bool inScratch = false;
+    const auto nframes = inout.sizeOneChannel();
+
+    for (size_t n = 0; n < program->nodes.size(); n++) {
+        const auto& node = program->nodes[n];
+        auto layer = compiledLayers[node.firstLayer].get();
+        auto nodeState = state.values.data() + node.stateOffset;
+        switch(node.kind){
+            case CompiledNode::Kind::Gain:{
+                float gain = 1;
+                for(uint32_t i = 0; i < node.nlayers; i++){
+                    gain *= static_cast<AudioGainFilterLayer*>(compiledLayers[node.firstLayer + i].get())->gain;
+                }
+                // planar channels are contiguous, so the chain is one pass over every channel
+                AudioMixing::ApplyGain(current.data(), nframes * nchannels, gain);
+            }
+                break;
+            case CompiledNode::Kind::Biquad:{
+                const auto k = static_cast<AudioBiquadFilterLayer*>(layer)->GetCoefficients();
+                for(uint8_t c = 0; c < nchannels; c++){
+                    BiquadKernel(current[c].data(), nframes, k, nodeState[c * 2], nodeState[c * 2 + 1]);
+                }
+            }
+                break;
+            case CompiledNode::Kind::Compressor:{
+                auto compressor = static_cast<AudioCompressorFilterLayer*>(layer);
+                const CompressorParams params(*compressor, ResolveRate(compressor->sampleRate, playerRate));
+                for(uint8_t c = 0; c < nchannels; c++){
+                    CompressorKernel(current[c].data(), nframes, params, nodeState[c]);
+                }
+            }
+                break;
+            case CompiledNode::Kind::Delay:{
+                auto delay = static_cast<AudioDelayFilterLayer*>(layer);
+                const auto delayFrames = DelayInSamples(*delay, ResolveRate(delay->sampleRate, playerRate), node.lineLength);
+                auto& position = state.positions[n];
+                for(uint8_t c = 0; c < nchannels; c++){
+                    DelayKernel(current[c].data(), nframes, nodeState + c * node.lineLength, node.lineLength, delayFrames, position, delay->feedback, delay->wet, delay->dry);
+                }
+                position = (position + nframes) % node.lineLength;
+            }
+                break;
+            case CompiledNode::Kind::Custom:
+                layer->process(current, other);
+                std::swap(current, other);
+                inScratch = !inScratch;
+                break;
+        }
+    }
+
+    if (inScratch){
+        std::copy(current.data(), current.data() + nframes * nchannels, inout.data());
     }
 }
 
 
 void AudioGraphComposed::renderImpl(PlanarSampleBufferInlineView& inputSamples, PlanarSampleBufferInlineView& intermediateBuffer, uint8_t nchannels){
     if (effectGraph){
-        effectGraph->Render(inputSamples, intermediateBuffer, nchannels);
+        effectGraph->Render(inputSamples, intermediateBuffer, nchannels, graphState);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,366 @@
+#include "AudioMixing.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RVE_MIX_SSE 1
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define RVE_MIX_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace RavEngine;
+
+void AudioMixing::Scalar::AdditiveBlend(float* dst, const float* src, size_t count){
+#pragma omp simd
+    for(size_t i = 0; i < count; i++){
+        dst[i] += src[i];
+    }
+}
+
+void AudioMixing::Scalar::ApplyGain(float* data, size_t count, float gain){
+    CopyWithGain(data, data, count, gain);
+}
+
+void AudioMixing::Scalar::CopyWithGain(float* dst, const float* src, size_t count, float gain){
+#pragma omp simd
+    for(size_t i = 0; i < count; i++){
+        dst[i] = src[i] * gain;
+    }
+}
+
+void AudioMixing::Scalar::PlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels){
+    for(size_t f = 0; f < nframes; f++){
+        for(uint8_t c = 0; c < nchannels; c++){
+            dst[f * nchannels + c] = planar[c * channelStride + f];
+        }
+    }
+}
+
+void AudioMixing::Scalar::BlendPlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels){
+    for(size_t f = 0; f < nframes; f++){
+        for(uint8_t c = 0; c < nchannels; c++){
+            dst[f * nchannels + c] += planar[c * channelStride + f];
+        }
+    }
+}
+
+void AudioMixing::Scalar::InterleavedToPlanar(float* planar, size_t channelStride, const float* src, size_t nframes, uint8_t nchannels){
+    // one strided pass per channel, so the destination is written sequentially
+    for(uint8_t c = 0; c < nchannels; c++){
+        float* out = planar + c * channelStride;
+        const float* in = src + c;
+        for(size_t f = 0; f < nframes; f++){
+            out[f] = in[f * nchannels];
+        }
+    }
+}
+
+void AudioMixing::Scalar::Clamp(float* data, size_t count, float lo, float hi){
+#pragma omp simd
+    for(size_t i = 0; i < count; i++){
+        data[i] = std::clamp(data[i], lo, hi);
+    }
+}
+
+#if RVE_MIX_SSE || RVE_MIX_NEON
+
+namespace{
+
+// thin wrappers so that each kernel is written once for both instruction sets
+#if RVE_MIX_SSE
+using vec4 = __m128;
+
+inline vec4 Load(const float* p){ return _mm_loadu_ps(p); }
+inline void Store(float* p, vec4 v){ _mm_storeu_ps(p, v); }
+inline vec4 Add(vec4 a, vec4 b){ return _mm_add_ps(a, b); }
+inline vec4 Mul(vec4 a, vec4 b){ return _mm_mul_ps(a, b); }
+inline vec4 Splat(float f){ return _mm_set1_ps(f); }
+
+// maxps and minps return their second operand when the comparison is false, which is exactly std::clamp
+inline vec4 ClampVec(vec4 v, vec4 lo, vec4 hi){ return _mm_min_ps(hi, _mm_max_ps(lo, v)); }
+
+inline void Transpose(vec4& r0, vec4& r1, vec4& r2, vec4& r3){
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+// a b -> a0 b0 a1 b1, a2 b2 a3 b3
+inline void Zip(vec4 a, vec4 b, vec4& lo, vec4& hi){
+    lo = _mm_unpacklo_ps(a, b);
+    hi = _mm_unpackhi_ps(a, b);
+}
+
+inline vec4 HighHalf(vec4 v){ return _mm_movehl_ps(v, v); }
+
+// a0 b0 a1 b1, a2 b2 a3 b3 -> a, b
+inline void Unzip(vec4 lo, vec4 hi, vec4& a, vec4& b){
+    a = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// write the low two lanes
+template<bool blend>
+inline void Put2(float* p, vec4 v){
+    if constexpr (blend){
+        v = _mm_add_ps(v, _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)));
+    }
+    _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+}
+
+constexpr const char* kernelName = "SSE2";
+#elif RVE_MIX_NEON
+using vec4 = float32x4_t;
+
+inline vec4 Load(const float* p){ return vld1q_f32(p); }
+inline void Store(float* p, vec4 v){ vst1q_f32(p, v); }
+inline vec4 Add(vec4 a, vec4 b){ return vaddq_f32(a, b); }
+inline vec4 Mul(vec4 a, vec4 b){ return vmulq_f32(a, b); }
+inline vec4 Splat(float f){ return vdupq_n_f32(f); }
+
+// vmin/vmax differ from std::clamp for NaN, so select explicitly
+inline vec4 ClampVec(vec4 v, vec4 lo, vec4 hi){
+    v = vbslq_f32(vcltq_f32(v, lo), lo, v);
+    return vbslq_f32(vcltq_f32(hi, v), hi, v);
+}
+
+inline void Transpose(vec4& r0, vec4& r1, vec4& r2, vec4& r3){
+    auto t01 = vtrnq_f32(r0, r1);
+    auto t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+inline void Zip(vec4 a, vec4 b, vec4& lo, vec4& hi){
+    auto z = vzipq_f32(a, b);
+    lo = z.val[0];
+    hi = z.val[1];
+}
+
+inline vec4 HighHalf(vec4 v){ return vcombine_f32(vget_high_f32(v), vget_high_f32(v)); }
+
+inline void Unzip(vec4 lo, vec4 hi, vec4& a, vec4& b){
+    auto u = vuzpq_f32(lo, hi);
+    a = u.val[0];
+    b = u.val[1];
+}
+
+template<bool blend>
+inline void Put2(float* p, vec4 v){
+    auto half = vget_low_f32(v);
+    if constexpr (blend){
+        half = vadd_f32(half, vld1_f32(p));
+    }
+    vst1_f32(p, half);
+}
+
+constexpr const char* kernelName = "NEON";
+#endif
+
+template<bool blend>
+inline void Put4(float* p, vec4 v){
+    if constexpr (blend){
+        v = Add(Load(p), v);
+    }
+    Store(p, v);
+}
+
+template<bool blend>
+void InterleaveImpl(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels){
+    const size_t nframesVec = nframes & ~size_t(3);
+    for(size_t f = 0; f < nframesVec; f += 4){
+        float* out = dst + f * nchannels;
+        uint8_t c = 0;
+
+        // groups of 4 channels: a 4x4 transpose turns 4 frames of 4 channels into 4 interleaved runs
+        for(; c + 4 <= nchannels; c += 4){
+            auto r0 = Load(planar + (c + 0) * channelStride + f);
+            auto r1 = Load(planar + (c + 1) * channelStride + f);
+            auto r2 = Load(planar + (c + 2) * channelStride + f);
+            auto r3 = Load(planar + (c + 3) * channelStride + f);
+            Transpose(r0, r1, r2, r3);
+            Put4<blend>(out + 0 * nchannels + c, r0);
+            Put4<blend>(out + 1 * nchannels + c, r1);
+            Put4<blend>(out + 2 * nchannels + c, r2);
+            Put4<blend>(out + 3 * nchannels + c, r3);
+        }
+
+        // a pair of channels: zip, then write 2 samples per frame
+        if (nchannels - c >= 2){
+            vec4 lo, hi;
+            Zip(Load(planar + c * channelStride + f), Load(planar + (c + 1) * channelStride + f), lo, hi);
+            if (nchannels == 2){
+                Put4<blend>(out, lo);
+                Put4<blend>(out + 4, hi);
+            }
+            else{
+                Put2<blend>(out + 0 * nchannels + c, lo);
+                Put2<blend>(out + 1 * nchannels + c, HighHalf(lo));
+                Put2<blend>(out + 2 * nchannels + c, hi);
+                Put2<blend>(out + 3 * nchannels + c, HighHalf(hi));
+            }
+            c += 2;
+        }
+
+        // odd channel out
+        if (c < nchannels){
+            const float* in = planar + c * channelStride + f;
+            for(uint8_t i = 0; i < 4; i++){
+                if constexpr (blend){
+                    out[i * nchannels + c] += in[i];
+                }
+                else{
+                    out[i * nchannels + c] = in[i];
+                }
+            }
+        }
+    }
+
+    // remaining frames
+    if constexpr (blend){
+        AudioMixing::Scalar::BlendPlanarToInterleaved(dst + nframesVec * nchannels, planar + nframesVec, channelStride, nframes - nframesVec, nchannels);
+    }
+    else{
+        AudioMixing::Scalar::PlanarToInterleaved(dst + nframesVec * nchannels, planar + nframesVec, channelStride, nframes - nframesVec, nchannels);
+    }
+}
+
+void DeinterleaveImpl(float* planar, size_t channelStride, const float* src, size_t nframes, uint8_t nchannels){
+    const size_t nframesVec = nframes & ~size_t(3);
+    for(size_t f = 0; f < nframesVec; f += 4){
+        const float* in = src + f * nchannels;
+        uint8_t c = 0;
+
+        // groups of 4 channels: the inverse of the transpose in InterleaveImpl
+        for(; c + 4 <= nchannels; c += 4){
+            auto r0 = Load(in + 0 * nchannels + c);
+            auto r1 = Load(in + 1 * nchannels + c);
+            auto r2 = Load(in + 2 * nchannels + c);
+            auto r3 = Load(in + 3 * nchannels + c);
+            Transpose(r0, r1, r2, r3);
+            Store(planar + (c + 0) * channelStride + f, r0);
+            Store(planar + (c + 1) * channelStride + f, r1);
+            Store(planar + (c + 2) * channelStride + f, r2);
+            Store(planar + (c + 3) * channelStride + f, r3);
+        }
+
+        // stereo: 4 frames are two vectors, split into even and odd samples
+        if (nchannels == 2){
+            vec4 left, right;
+            Unzip(Load(in), Load(in + 4), left, right);
+            Store(planar + f, left);
+            Store(planar + channelStride + f, right);
+            continue;
+        }
+
+        // channels left over from the groups
+        for(; c < nchannels; c++){
+            for(uint8_t i = 0; i < 4; i++){
+                planar[c * channelStride + f + i] = in[i * nchannels + c];
+            }
+        }
+    }
+
+    // remaining frames
+    AudioMixing::Scalar::InterleavedToPlanar(planar + nframesVec, channelStride, src + nframesVec * nchannels, nframes - nframesVec, nchannels);
+}
+
+}
+
+void AudioMixing::AdditiveBlend(float* dst, const float* src, size_t count){
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        Store(dst + i, Add(Load(dst + i), Load(src + i)));
+        Store(dst + i + 4, Add(Load(dst + i + 4), Load(src + i + 4)));
+    }
+    for(; i + 4 <= count; i += 4){
+        Store(dst + i, Add(Load(dst + i), Load(src + i)));
+    }
+    Scalar::AdditiveBlend(dst + i, src + i, count - i);
+}
+
+void AudioMixing::ApplyGain(float* data, size_t count, float gain){
+    CopyWithGain(data, data, count, gain);
+}
+
+void AudioMixing::CopyWithGain(float* dst, const float* src, size_t count, float gain){
+    const auto g = Splat(gain);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        Store(dst + i, Mul(Load(src + i), g));
+        Store(dst + i + 4, Mul(Load(src + i + 4), g));
+    }
+    for(; i + 4 <= count; i += 4){
+        Store(dst + i, Mul(Load(src + i), g));
+    }
+    Scalar::CopyWithGain(dst + i, src + i, count - i, gain);
+}
+
+void AudioMixing::PlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels){
+    InterleaveImpl<false>(dst, planar, channelStride, nframes, nchannels);
+}
+
+void AudioMixing::BlendPlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels){
+    InterleaveImpl<true>(dst, planar, channelStride, nframes, nchannels);
+}
+
+void AudioMixing::InterleavedToPlanar(float* planar, size_t channelStride, const float* src, size_t nframes, uint8_t nchannels){
+    // mono is already planar, and a plain copy beats any shuffle
+    if (nchannels == 1){
+        std::copy(src, src + nframes, planar);
+        return;
+    }
+    DeinterleaveImpl(planar, channelStride, src, nframes, nchannels);
+}
+
+void AudioMixing::Clamp(float* data, size_t count, float lo, float hi){
+    const auto vlo = Splat(lo);
+    const auto vhi = Splat(hi);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        Store(data + i, ClampVec(Load(data + i), vlo, vhi));
+    }
+    Scalar::Clamp(data + i, count - i, lo, hi);
+}
+
+const char* AudioMixing::GetKernelName(){
+    return kernelName;
+}
+
+#else
+
+void AudioMixing::AdditiveBlend(float* dst, const float* src, size_t count){
+    Scalar::AdditiveBlend(dst, src, count);
+}
+
+void AudioMixing::ApplyGain(float* data, size_t count, float gain){
+    Scalar::ApplyGain(data, count, gain);
+}
+
+void AudioMixing::CopyWithGain(float* dst, const float* src, size_t count, float gain){
+    Scalar::CopyWithGain(dst, src, count, gain);
+}
+
+void AudioMixing::PlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels){
+    Scalar::PlanarToInterleaved(dst, planar, channelStride, nframes, nchannels);
+}
+
+void AudioMixing::BlendPlanarToInterleaved(float* dst, const float* planar, size_t channelStride, size_t nframes, uint8_t nchannels){
+    Scalar::BlendPlanarToInterleaved(dst, planar, channelStride, nframes, nchannels);
+}
+
+void AudioMixing::InterleavedToPlanar(float* planar, size_t channelStride, const float* src, size_t nframes, uint8_t nchannels){
+    Scalar::InterleavedToPlanar(planar, channelStride, src, nframes, nchannels);
+}
+
+void AudioMixing::Clamp(float* data, size_t count, float lo, float hi){
+    Scalar::Clamp(data, count, lo, hi);
+}
+
+const char* AudioMixing::GetKernelName(){
+    return "Scalar";
+}
+
+#endif
@@ -6,6 +6,8 @@
 #include "AudioRoom.hpp"
 #include "DataStructures.hpp"
 #include "AudioGraphAsset.hpp"
+#include "AudioMixing.hpp"
+#include "AudioSnapshot.hpp"
 #include "App.hpp"
 #include <algorithm>
 #if _WIN32
@@ -54,8 +56,7 @@ inline static void TZero(T* data, size_t nData){
 
 void AudioPlayer::Tick(Uint8* stream, int len) {
     
-    GetApp()->SwapRenderAudioSnapshot();
-    SnapshotToRender = GetApp()->GetRenderAudioSnapshot();
+    SnapshotToRender = GetApp()->GetAudioSnapshotPublisher().AcquireLatest();
     auto buffer_idx = currentProcessingID % GetBufferCount();
         
     // kill all the remaining tasks
@@ -85,8 +86,6 @@ void AudioPlayer::Tick(Uint8* stream, int len) {
 
     //use the first audio listener (TODO: will cause unpredictable behavior if there are multiple listeners)
 
-    auto& lpos = SnapshotToRender->listenerPos;
-    auto& lrot = SnapshotToRender->listenerRot;
     const auto buffers_size = len / sizeof(float);
     stackarray(shared_buffer, float, buffers_size);
     stackarray(effect_scratch_buffer, float, buffers_size);
@@ -103,12 +102,9 @@ void AudioPlayer::Tick(Uint8* stream, int len) {
 
     const auto blendBufferIn = [accumView](PlanarSampleBufferInlineView sourceView){
         const auto nchannels = sourceView.GetNChannels();
-#pragma omp simd
-        for (int i = 0; i < accumView.size(); i++) {
-            //mix with existing
-            // also perform planar-to-interleaved conversion
-            accumView[i] += sourceView[i % nchannels][i / nchannels];
-        }
+        //mix with existing
+        // also perform planar-to-interleaved conversion
+        AudioMixing::BlendPlanarToInterleaved(accumView.data(), sourceView.data(), sourceView.sizeOneChannel(), accumView.size() / nchannels, nchannels);
     };
     
     // add blend temp buffer into output buffer
@@ -117,10 +113,11 @@ void AudioPlayer::Tick(Uint8* stream, int len) {
     };
     
 
-    for (const auto& r : SnapshotToRender->rooms) {
+    // simulate the rooms in parallel, each into its own buffer, then mix them in room order
+    roomRenderer.Render(SnapshotToRender->rooms.size(), [this, buffer_idx](size_t i, PlanarSampleBufferInlineView& roomBuffer, PlanarSampleBufferInlineView& roomScratch){
+        const auto& r = SnapshotToRender->rooms[i];
         auto& room = r.room;
-        room->SetListenerTransform(lpos, lrot);
-        resetShared();
+        room->SetListenerTransform(SnapshotToRender->listenerPos, SnapshotToRender->listenerRot);
 
         // raster sources
         for (const auto& source : SnapshotToRender->sources) {
@@ -134,13 +131,15 @@ void AudioPlayer::Tick(Uint8* stream, int len) {
             }
         }
 
-        //now simulate the fire-and-forget audio
-        resetShared();
-
         //simulate in the room
-        room->Simulate(sharedBufferView,effectScratchBuffer);
-        blendIn();
+        room->Simulate(roomBuffer, roomScratch);
+    }, accumView, GetNChannels());
+
+    const auto& roomTimes = roomRenderer.GetRoomMicroseconds();
+    for (size_t i = 0; i < roomTimes.size(); i++) {
+        SnapshotToRender->rooms[i].room->lastProcessingMicroseconds = roomTimes[i];
     }
+    roomStatistics.store(roomRenderer.GetStatistics());
 
     for (auto& source : SnapshotToRender->ambientSources) {
         auto& buffer = source->renderData.buffers[buffer_idx];
@@ -155,17 +154,16 @@ void AudioPlayer::Tick(Uint8* stream, int len) {
         }
     }
 
-    // run the graph on the listener, if present
+    // run the graph on the listener, if present. Nothing above is guaranteed to have written the shared buffer,
+    // so it is cleared rather than handing the graph whatever the stack held.
     if (SnapshotToRender->listenerGraph) {
-        SnapshotToRender->listenerGraph->Render(sharedBufferView, effectScratchBuffer, nchannels);
+        resetShared();
+        SnapshotToRender->listenerGraph->Render(sharedBufferView, effectScratchBuffer, nchannels, listenerGraphState);
         blendIn();
     }
     currentProcessingID++;  // advance proc id to mark it as completed
     //clipping: clamp all values to [-1,1]
-#pragma omp simd
-    for (int i = 0; i < accumView.size(); i++) {
-        accumView[i] = std::clamp(accumView[i], -1.0f, 1.0f);
-    }
+    AudioMixing::Clamp(accumView.data(), accumView.size(), -1.0f, 1.0f);
 }
 
 void AudioPlayer::EnqueueAudioTasks(){
@@ -178,36 +176,28 @@ void AudioPlayer::EnqueueAudioTasks(){
     decltype(currentProcessingID) nextID = currentProcessingID + i;   // this is the buffer slot we will render
     auto buffer_idx = nextID % GetBufferCount();
     
-    auto doPlayer = [buffer_idx, nextID](auto renderData, auto player){    // must be a AudioDataProvider. We use Auto here to avoid vtable.
+    // choose which sources are rendered this buffer
+    voiceManager.SetOptions(voiceOptions.load());
+    voiceManager.Update(*SnapshotToRender);
+    voiceStatistics.store(voiceManager.GetStatistics());
+    
+    auto doPlayer = [this, buffer_idx, nextID](const AudioVoiceManager::Voice& voice){
         numExecuting++;
-        auto& buffers = renderData->buffers[buffer_idx];
+        auto& buffers = voice.provider->renderData.buffers[buffer_idx];
         auto sharedBufferView = buffers.GetDataBufferView();
         auto effectScratchBuffer = buffers.GetScratchBufferView();
 
-        player->ProvideBufferData(sharedBufferView, effectScratchBuffer);
+        voiceManager.Render(voice, sharedBufferView, effectScratchBuffer);
         buffers.lastCompletedProcessingIterationID = nextID;   // mark it as having completed in this iter cycle
         numExecuting--;
    
     };
-    alreadyTicked.clear();
-    // point sources
-    for (const auto& source : SnapshotToRender->sources) {
-        auto player = source.data;
-        if (!alreadyTicked.contains(player)){
-            alreadyTicked.insert(player);
-            auto renderData = &source.data->renderData;
-            static_assert(sizeof(player) == sizeof(std::shared_ptr<void>), "Not a pointer, check this!");
-            theFutures.enqueue(audioExecutor.async(doPlayer, renderData, player));
-        }
-      
-    }
-    // ambient sources
-    for (auto& source : SnapshotToRender->ambientSources) {
-        auto renderData = &source->renderData;
-        static_assert(sizeof(source) == sizeof(std::shared_ptr<void>), "Not a pointer, check this!");
-        theFutures.enqueue(audioExecutor.async(doPlayer, renderData, source));
+    // real voices, both point and ambient. Tick skips the others because their buffers are not marked with this ID.
+    for (const auto& voice : voiceManager.GetRealVoices()) {
+        theFutures.enqueue(audioExecutor.async(doPlayer, voice));
     }
-
+    // virtual voices only move their playheads, which is too little work to be worth a task each
+    voiceManager.AdvanceVirtualVoices(GetBufferSize());
 }
 
 /**
@@ -261,6 +251,18 @@ void AudioPlayer::Init(){
 	SDL_PauseAudioDevice(device,0);	//begin audio playback
 }
 
+void AudioPlayer::SetRoomWorkerCount(uint32_t nworkers){
+    roomWorkerCount = nworkers;
+    // creating and joining threads is far too slow for the realtime callback, so it happens here with the callback held off
+    if (device != 0){
+        SDL_LockAudioDevice(device);
+    }
+    roomRenderer.SetWorkerCount(nworkers);
+    if (device != 0){
+        SDL_UnlockAudioDevice(device);
+    }
+}
+
 void AudioPlayer::Shutdown(){
 	SDL_CloseAudioDevice(device);
 }
@@ -11,7 +11,9 @@
 using namespace RavEngine;
 using namespace std;
 
-AudioRoom::RoomData::RoomData() : audioEngine(vraudio::CreateResonanceAudioApi(AudioPlayer::GetNChannels(), AudioPlayer::GetBufferSize(), AudioPlayer::GetSamplesPerSec())){}
+AudioRoom::RoomData::RoomData() : RoomData(AudioPlayer::GetNChannels(), AudioPlayer::GetBufferSize(), AudioPlayer::GetSamplesPerSec()){}
+
+AudioRoom::RoomData::RoomData(uint8_t nchannels, uint16_t bufferSize, uint32_t sampleRate) : audioEngine(vraudio::CreateResonanceAudioApi(nchannels, bufferSize, sampleRate)), bufferSize(bufferSize){}
 
 void AudioRoom::RoomData::SetListenerTransform(const vector3 &worldpos, const quaternion &wr){
 	audioEngine->SetHeadPosition(worldpos.x, worldpos.y, worldpos.z);
@@ -42,7 +44,7 @@ void AudioRoom::RoomData::AddEmitter(const float* data, const vector3 &pos, cons
         src = allSources[code];
     }
     
-    audioEngine->SetInterleavedBuffer(src, data, 1, AudioPlayer::GetBufferSize());   // they copy the contents of temp into their own buffer so giving stack memory is fine here
+    audioEngine->SetInterleavedBuffer(src, data, 1, bufferSize);   // they copy the contents of temp into their own buffer so giving stack memory is fine here
     audioEngine->SetSourceVolume(src, 1);   // the AudioAsset already applied the volume
     audioEngine->SetSourcePosition(src, worldpos.x, worldpos.y, worldpos.z);
     audioEngine->SetSourceRotation(src, worldrot.x, worldrot.y, worldrot.z, worldrot.w);
@@ -51,7 +53,7 @@ void AudioRoom::RoomData::AddEmitter(const float* data, const vector3 &pos, cons
 
 
 void AudioRoom::RoomData::Simulate(PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratchBuffer){
-    auto nchannels = AudioPlayer::GetNChannels();
+    auto nchannels = buffer.GetNChannels();
     
     // convert to an array of pointers for Resonance
     stackarray(allchannelptrs, float*, nchannels);
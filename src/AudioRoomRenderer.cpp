@@ -0,0 +1,103 @@
+#include "AudioRoomRenderer.hpp"
+#include "AudioMixing.hpp"
+#include <taskflow/taskflow.hpp>
+#include <taskflow/core/worker.hpp>
+#include <algorithm>
+#include <chrono>
+
+using namespace RavEngine;
+
+namespace{
+
+struct AudioRoomWorker : public tf::WorkerInterface{
+    void scheduler_prologue(tf::Worker& worker) final{
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+        pthread_setname_np(
+            #if __linux__
+                    pthread_self(),
+            #endif
+                    "Audio Room Worker"
+                    );
+#endif
+    }
+    void scheduler_epilogue(tf::Worker& worker, std::exception_ptr ptr) final{};
+};
+
+inline float MicrosecondsSince(std::chrono::steady_clock::time_point begin){
+    return std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - begin).count();
+}
+
+}
+
+AudioRoomRenderer::AudioRoomRenderer(uint32_t nworkers){
+    SetWorkerCount(nworkers);
+}
+
+AudioRoomRenderer::~AudioRoomRenderer() = default;
+
+void AudioRoomRenderer::SetWorkerCount(uint32_t count){
+    if (executor && count == nworkers){
+        return;
+    }
+    executor.reset();   // joins the old workers
+    nworkers = count;
+    if (nworkers > 0){
+        executor = std::make_unique<tf::Executor>(nworkers, std::make_shared<AudioRoomWorker>());
+    }
+}
+
+void AudioRoomRenderer::RenderOne(size_t room, const RenderRoomFn& renderRoom, size_t nframes, uint8_t nchannels){
+    const auto begin = std::chrono::steady_clock::now();
+    const auto roomSize = nframes * nchannels;
+    auto roomData = roomBuffers.data() + room * roomSize;
+    auto scratchData = scratchBuffers.data() + room * roomSize;
+    std::fill(roomData, roomData + roomSize, 0.0f);
+    std::fill(scratchData, scratchData + roomSize, 0.0f);
+    PlanarSampleBufferInlineView buffer(roomData, roomSize, nframes);
+    PlanarSampleBufferInlineView scratch(scratchData, roomSize, nframes);
+    renderRoom(room, buffer, scratch);
+    roomMicroseconds[room] = MicrosecondsSince(begin);
+}
+
+void AudioRoomRenderer::Render(size_t nrooms, const RenderRoomFn& renderRoom, InterleavedSampleBufferView output, uint8_t nchannels){
+    const auto begin = std::chrono::steady_clock::now();
+    const size_t nframes = output.size() / nchannels;
+    const size_t roomSize = nframes * nchannels;
+
+    // grows to the largest scene seen, so steady state does not allocate
+    if (roomBuffers.size() < nrooms * roomSize){
+        roomBuffers.resize(nrooms * roomSize);
+        scratchBuffers.resize(nrooms * roomSize);
+    }
+    roomMicroseconds.resize(nrooms);
+
+    // each room writes only its own slice of the buffers, so the rooms do not need to synchronize
+    if (!executor || nrooms <= 1){
+        for(size_t i = 0; i < nrooms; i++){
+            RenderOne(i, renderRoom, nframes, nchannels);
+        }
+    }
+    else{
+        for(size_t i = 0; i < nrooms; i++){
+            executor->silent_async([this, &renderRoom, i, nframes, nchannels]{
+                RenderOne(i, renderRoom, nframes, nchannels);
+            });
+        }
+        executor->wait_for_all();
+    }
+
+    // blend in room order, so the floating point sum is the same no matter which room finished first
+    for(size_t i = 0; i < nrooms; i++){
+        AudioMixing::BlendPlanarToInterleaved(output.data(), roomBuffers.data() + i * roomSize, nframes, nframes, nchannels);
+    }
+
+    statistics.nRooms = nrooms;
+    statistics.nWorkers = nworkers;
+    statistics.totalRoomMicroseconds = 0;
+    statistics.maxRoomMicroseconds = 0;
+    for(const auto time : roomMicroseconds){
+        statistics.totalRoomMicroseconds += time;
+        statistics.maxRoomMicroseconds = std::max(statistics.maxRoomMicroseconds, time);
+    }
+    statistics.wallMicroseconds = MicrosecondsSince(begin);
+}
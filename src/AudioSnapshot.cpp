@@ -0,0 +1,180 @@
+#include "AudioSnapshot.hpp"
+#include <algorithm>
+
+using namespace RavEngine;
+
+template<typename T>
+uint32_t AudioSnapshotPublisher::TrackedArray<T>::Touch(const void* key, uint64_t generation){
+    auto it = indices.find(key);
+    if (it == indices.end()){
+        return npos;
+    }
+    lastSeen[it->second] = generation;
+    return it->second;
+}
+
+template<typename T>
+void AudioSnapshotPublisher::TrackedArray<T>::Add(const void* key, T&& value, uint64_t generation){
+    const auto index = static_cast<uint32_t>(values.size());
+    values.push_back(std::move(value));
+    keys.push_back(key);
+    lastSeen.push_back(generation);
+    indices.emplace(key, index);
+    changes.emplace_back(generation, index);
+    nChanged++;
+}
+
+template<typename T>
+void AudioSnapshotPublisher::TrackedArray<T>::Set(uint32_t index, T&& value, uint64_t generation){
+    values[index] = std::move(value);
+    changes.emplace_back(generation, index);
+    nChanged++;
+}
+
+template<typename T>
+void AudioSnapshotPublisher::TrackedArray<T>::RemoveUnseen(uint64_t generation){
+    for(uint32_t i = 0; i < values.size();){
+        if (lastSeen[i] == generation){
+            i++;
+            continue;
+        }
+        // swap-remove, so the only index that changes is the one the last entry moves into
+        indices.erase(keys[i]);
+        const auto last = static_cast<uint32_t>(values.size() - 1);
+        if (i != last){
+            values[i] = std::move(values[last]);
+            keys[i] = keys[last];
+            lastSeen[i] = lastSeen[last];
+            indices[keys[i]] = i;
+            changes.emplace_back(generation, i);
+        }
+        values.pop_back();
+        keys.pop_back();
+        lastSeen.pop_back();
+        nRemoved++;
+    }
+}
+
+template<typename T>
+uint32_t AudioSnapshotPublisher::TrackedArray<T>::CopyTo(Vector<T>& copy, uint64_t copyGeneration) const{
+    if (copyGeneration < fullCopyBelow){
+        copy = values;
+        return values.size();
+    }
+    // every index at which the copy could differ from values was logged after the copy was made, so the rest can be left alone
+    copy.resize(values.size());
+    uint32_t ncopied = 0;
+    auto begin = std::upper_bound(changes.begin(), changes.end(), copyGeneration, [](uint64_t generation, const auto& change){
+        return generation < change.first;
+    });
+    for(auto it = begin; it != changes.end(); ++it){
+        const auto index = it->second;
+        if (index < values.size()){
+            copy[index] = values[index];
+            ncopied++;
+        }
+    }
+    return ncopied;
+}
+
+template<typename T>
+void AudioSnapshotPublisher::TrackedArray<T>::Prune(uint64_t oldestCopy, uint64_t generation){
+    // a copy that is not returned for a long time would make the log grow without bound. Past the size of the array, a full copy is cheaper than replaying the log.
+    if (changes.size() > values.size()){
+        changes.clear();
+        fullCopyBelow = generation;
+        return;
+    }
+    auto end = std::upper_bound(changes.begin(), changes.end(), oldestCopy, [](uint64_t generation, const auto& change){
+        return generation < change.first;
+    });
+    changes.erase(changes.begin(), end);
+}
+
+AudioSnapshotPublisher::AudioSnapshotPublisher(){
+    for(auto& snapshot : snapshots){
+        snapshot.listenerPos = listenerPos;
+        snapshot.listenerRot = listenerRot;
+    }
+}
+
+void AudioSnapshotPublisher::BeginUpdate(){
+    generation++;
+    sources.nChanged = sources.nRemoved = 0;
+    ambientSources.nChanged = ambientSources.nRemoved = 0;
+    rooms.nChanged = rooms.nRemoved = 0;
+}
+
+void AudioSnapshotPublisher::SetListener(const vector3& worldpos, const quaternion& worldrot, const Ref<AudioGraphAsset>& graph){
+    listenerPos = worldpos;
+    listenerRot = worldrot;
+    listenerGraph = graph;
+}
+
+void AudioSnapshotPublisher::UpdateSource(const Ref<AudioDataProvider>& provider, const vector3& worldpos, const quaternion& worldrot){
+    // most sources have not moved, so compare before building a new entry
+    const auto index = sources.Touch(provider.get(), generation);
+    if (index == sources.npos){
+        sources.Add(provider.get(), AudioSnapshot::PointSource(provider, worldpos, worldrot), generation);
+    }
+    else if (sources.values[index].worldpos != worldpos || sources.values[index].worldrot != worldrot){
+        sources.Set(index, AudioSnapshot::PointSource(provider, worldpos, worldrot), generation);
+    }
+}
+
+void AudioSnapshotPublisher::UpdateAmbientSource(const Ref<AudioDataProvider>& provider){
+    if (ambientSources.Touch(provider.get(), generation) == ambientSources.npos){
+        ambientSources.Add(provider.get(), Ref<AudioDataProvider>(provider), generation);
+    }
+}
+
+void AudioSnapshotPublisher::UpdateRoom(const Ref<AudioRoom::RoomData>& room, const vector3& worldpos, const quaternion& worldrot){
+    const auto index = rooms.Touch(room.get(), generation);
+    if (index == rooms.npos){
+        rooms.Add(room.get(), AudioSnapshot::Room(room, worldpos, worldrot), generation);
+    }
+    else if (rooms.values[index].worldpos != worldpos || rooms.values[index].worldrot != worldrot){
+        rooms.Set(index, AudioSnapshot::Room(room, worldpos, worldrot), generation);
+    }
+}
+
+void AudioSnapshotPublisher::EndUpdate(){
+    sources.RemoveUnseen(generation);
+    ambientSources.RemoveUnseen(generation);
+    rooms.RemoveUnseen(generation);
+
+    // the reader never touches the writing snapshot, so it can be caught up without the lock
+    statistics.nCopied = sources.CopyTo(writing->sources, writing->generation) + ambientSources.CopyTo(writing->ambientSources, writing->generation) + rooms.CopyTo(writing->rooms, writing->generation);
+    writing->listenerPos = listenerPos;
+    writing->listenerRot = listenerRot;
+    writing->listenerGraph = listenerGraph;
+    writing->generation = generation;
+
+    uint64_t oldestCopy;
+    mtx.lock();
+    std::swap(writing, latest);
+    fresh = true;
+    oldestCopy = std::min({writing->generation, latest->generation, reading->generation});
+    mtx.unlock();
+
+    sources.Prune(oldestCopy, generation);
+    ambientSources.Prune(oldestCopy, generation);
+    rooms.Prune(oldestCopy, generation);
+
+    statistics.nSources = sources.values.size();
+    statistics.nAmbientSources = ambientSources.values.size();
+    statistics.nRooms = rooms.values.size();
+    statistics.nChanged = sources.nChanged + ambientSources.nChanged + rooms.nChanged;
+    statistics.nRemoved = sources.nRemoved + ambientSources.nRemoved + rooms.nRemoved;
+}
+
+const AudioSnapshot* AudioSnapshotPublisher::AcquireLatest(){
+    mtx.lock();
+    if (fresh){
+        std::swap(latest, reading);
+        fresh = false;
+    }
+    auto snapshot = reading;
+    mtx.unlock();
+    return snapshot;
+}
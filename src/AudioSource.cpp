@@ -12,6 +12,7 @@
 #include <CDSPResampler.h>
 #include "VirtualFileSystem.hpp"
 #include "AudioPlayer.hpp"
+#include "DiskCache.hpp"
 
 using namespace RavEngine;
 using namespace std;
@@ -37,10 +38,50 @@ AudioAsset::AudioAsset(const std::string& name, decltype(nchannels) desired_chan
 	string path = StrFormat("/sounds/{}", name);
 	auto datavec = GetApp()->GetResources().FileContentsAt<std::vector<uint8_t>>(path.c_str(),false);    // the extra arg signals not to null terminate the file data
 	
-	const int desiredSampleRate = AudioPlayer::GetSamplesPerSec();
+	auto file_ext = Filesystem::Path(path).extension().string().substr(1);
+	Decode(datavec, file_ext, desired_channels, AudioPlayer::GetSamplesPerSec(), path);
+}
+
+AudioAsset::AudioAsset(const std::vector<uint8_t>& encodedData, const std::string& extension, decltype(nchannels) desired_channels, uint32_t sampleRate){
+	Decode(encodedData, extension, desired_channels, sampleRate, StrFormat("<{} data>", extension));
+}
+
+// bump when the layout of the decoded samples changes, so that entries written by older versions are not used
+static constexpr int decodeCacheVersion = 2;
+
+DiskCache& AudioAsset::GetDecodeCache(){
+	static DiskCache cache(DiskCache::TemporaryDirectory("AudioCache"), 256 * 1024 * 1024);
+	return cache;
+}
+
+void AudioAsset::Decode(const std::vector<uint8_t>& datavec, const std::string& file_ext, decltype(nchannels) desired_channels, uint32_t desiredSampleRate, const std::string& path){
+	// the cache stores the planar samples, which are read directly into place
+	auto& cache = GetDecodeCache();
+	std::string cacheKey;
+	if (cache.IsEnabled()){
+		cacheKey = StrFormat("audio{}-{:016x}-{}-{}ch-{}hz", decodeCacheVersion, DiskCache::Hash(datavec.data(), datavec.size()), file_ext, desired_channels, desiredSampleRate);
+		float* samples = nullptr;
+		size_t nsamples = 0;
+		const bool hit = cache.Load(cacheKey, [&](size_t bytes) -> void*{
+			if (desired_channels == 0 || bytes % (sizeof(float) * desired_channels) != 0){
+				return nullptr;
+			}
+			nsamples = bytes / sizeof(float);
+			samples = new float[nsamples];
+			return samples;
+		});
+		if (hit){
+			nchannels = desired_channels;
+			audiodata = samples;
+			MemoryTracker::Allocated(MemoryTag::Audio, nsamples * sizeof(float));
+			data = PlanarSampleBufferInlineView{samples, nsamples, nsamples / nchannels};
+			lengthSeconds = double(data.sizeOneChannel()) / desiredSampleRate;
+			return;
+		}
+		delete[] samples;
+	}
 	
 	nqr::NyquistIO loader;
-	auto file_ext = Filesystem::Path(path).extension().string().substr(1);
 	nqr::AudioData data;
 	loader.Load(&data, file_ext, datavec);
 	
@@ -51,9 +92,12 @@ AudioAsset::AudioAsset(const std::string& name, decltype(nchannels) desired_chan
 #endif
 
 		// resample to the correct rate
-		decltype(data.samples) finalbuffer(desiredSampleRate * data.lengthSeconds * data.channelCount);
-		decltype(data.samples) oneChannel(data.sampleRate * data.lengthSeconds);
-		decltype(data.samples) outChannel(desiredSampleRate * data.lengthSeconds);
+		// lengths are derived from the frame count rather than lengthSeconds, which is rounded to a float. StreamingAudioDataProvider uses the same formula.
+		const size_t inFrames = data.samples.size() / data.channelCount;
+		const size_t outFrames = static_cast<uint64_t>(inFrames) * desiredSampleRate / data.sampleRate;
+		decltype(data.samples) finalbuffer(outFrames * data.channelCount);
+		decltype(data.samples) oneChannel(inFrames);
+		decltype(data.samples) outChannel(outFrames);
 		for (int i = 0; i < data.channelCount; i++) {
 			// extract the channel
 			for (int j = 0; j < oneChannel.size(); j++) {
@@ -61,7 +105,7 @@ AudioAsset::AudioAsset(const std::string& name, decltype(nchannels) desired_chan
 			}
 
 			r8b::CDSPResampler resampler(data.sampleRate, desiredSampleRate, Debug::AssertSize<int>(oneChannel.size()));
-			resampler.oneshot(oneChannel.data(), static_cast<int>(oneChannel.size()), outChannel.data(), static_cast<int>(oneChannel.size()));
+			resampler.oneshot(oneChannel.data(), static_cast<int>(oneChannel.size()), outChannel.data(), Debug::AssertSize<int>(outChannel.size()));
 
 			// merge into final buffer
 			for (int j = 0; j < outChannel.size(); j++) {
@@ -99,17 +143,24 @@ AudioAsset::AudioAsset(const std::string& name, decltype(nchannels) desired_chan
 	}
 
 	
-	lengthSeconds = data.lengthSeconds;
+	// derived from the frame count, which is also all that the cache knows
+	lengthSeconds = double(data.samples.size() / nchannels) / data.sampleRate;
 	
-    audiodata = new float[data.samples.size()]{0};
+    audiodata = new float[data.samples.size()]();
+    MemoryTracker::Allocated(MemoryTag::Audio, data.samples.size() * sizeof(float));
     
     // convert to planar representation
     PlanarSampleBufferInlineView planarRep{const_cast<float*>(audiodata),data.samples.size(),data.samples.size() / nchannels};
 	planarRep.ImportInterleavedData(InterleavedSampleBufferView{data.samples.data(),data.samples.size()}, nchannels);
     this->data = planarRep;
+	
+	if (!cacheKey.empty()){
+		cache.Store(cacheKey, audiodata, data.samples.size() * sizeof(float));
+	}
 }
 
 AudioAsset::~AudioAsset(){
+	MemoryTracker::Deallocated(MemoryTag::Audio, data.size() * sizeof(float));
 	delete[] audiodata;
 	audiodata = nullptr;
 }
@@ -129,26 +180,47 @@ void SampledAudioDataProvider::ProvideBufferData(PlanarSampleBufferInlineView& b
     const auto nsamples = asset->GetNumSamples();
     const auto nchannels = asset->GetNChanels();
     assert(buffer.GetNChannels() >= nchannels);  // you are trying to do something that doesn't make sense!!
-    for(size_t i = 0; i < buffer.sizeOneChannel(); i++){
+    const auto nframes = buffer.sizeOneChannel();
+    size_t i = 0;
+    while (i < nframes){
         //is playhead past end of source?
         if (playhead_pos >= nsamples){
-            if (loops){
+            if (loops && nsamples > 0){
                 playhead_pos = 0;
             }
             else{
-#pragma omp simd
                 for(uint8_t c = 0; c < nchannels; c++){
-                    buffer[c][i] = 0;
+                    std::fill(buffer[c].begin() + i, buffer[c].end(), 0.0f);
                 }
                 isPlaying = false;
-                continue;
+                break;
             }
         }
-#pragma omp simd
+        // copy the longest run that does not cross the end of the source
+        const auto run = std::min<size_t>(nframes - i, nsamples - playhead_pos);
         for(uint8_t c = 0; c < nchannels; c++){
-            buffer[c][i] = asset->data[c][playhead_pos] * volume;
+            AudioMixing::CopyWithGain(buffer[c].data() + i, asset->data[c].data() + playhead_pos, run, volume);
         }
-        playhead_pos++;
+        i += run;
+        playhead_pos += run;
     }
     AudioGraphComposed::Render(buffer,scratchSpace, asset->GetNChanels());
 }
+
+void SampledAudioDataProvider::Advance(size_t nframes){
+    if (nframes == 0){
+        return;
+    }
+    const auto nsamples = asset->GetNumSamples();
+    // same end state as ProvideBufferData: a looping playhead wraps lazily, so it lands in (0, nsamples]
+    if (loops && nsamples > 0){
+        playhead_pos = (std::min(playhead_pos, nsamples) + nframes - 1) % nsamples + 1;
+    }
+    else if (playhead_pos + nframes > nsamples){
+        playhead_pos = std::max(playhead_pos, nsamples);
+        isPlaying = false;
+    }
+    else{
+        playhead_pos += nframes;
+    }
+}
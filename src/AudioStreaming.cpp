@@ -0,0 +1,532 @@
+#if defined _M_ARM64 && _M_ARM64
+#define ARCH_CPU_LITTLE_ENDIAN 1
+#endif
+#include "AudioStreaming.hpp"
+#include "AudioPlayer.hpp"
+#include "AudioMixing.hpp"
+#include "Debug.hpp"
+#include <libnyquist/Common.h>
+#include <r8bbase.h>
+#include <CDSPResampler.h>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cassert>
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#endif
+
+using namespace RavEngine;
+using namespace std;
+
+AudioRingBuffer::AudioRingBuffer(uint8_t nchannels, size_t capacityFrames) : nchannels(nchannels){
+    capacity = 1;
+    while (capacity < capacityFrames){
+        capacity <<= 1;
+    }
+    mask = capacity - 1;
+    storage.resize(capacity * nchannels);
+}
+
+size_t AudioRingBuffer::Write(const float* planar, size_t channelStride, size_t nframes){
+    const auto write = writePos.load(std::memory_order_relaxed);
+    const auto read = readPos.load(std::memory_order_acquire);
+    nframes = std::min<size_t>(nframes, capacity - static_cast<size_t>(write - read));
+
+    // the region may wrap around the end of the storage
+    const size_t start = write & mask;
+    const size_t first = std::min(nframes, capacity - start);
+    for(uint8_t c = 0; c < nchannels; c++){
+        auto src = planar + c * channelStride;
+        auto dst = storage.data() + c * capacity;
+        std::copy(src, src + first, dst + start);
+        std::copy(src + first, src + nframes, dst);
+    }
+    writePos.store(write + nframes, std::memory_order_release);
+    return nframes;
+}
+
+size_t AudioRingBuffer::Read(PlanarSampleBufferInlineView& dest, size_t offset, size_t nframes, float gain){
+    const auto read = readPos.load(std::memory_order_relaxed);
+    const auto write = writePos.load(std::memory_order_acquire);
+    nframes = std::min<size_t>(nframes, static_cast<size_t>(write - read));
+
+    const size_t start = read & mask;
+    const size_t first = std::min(nframes, capacity - start);
+    for(uint8_t c = 0; c < nchannels; c++){
+        auto src = storage.data() + c * capacity;
+        auto dst = dest[c].data() + offset;
+        AudioMixing::CopyWithGain(dst, src + start, first, gain);
+        AudioMixing::CopyWithGain(dst + first, src, nframes - first, gain);
+    }
+    readPos.store(read + nframes, std::memory_order_release);
+    return nframes;
+}
+
+size_t AudioRingBuffer::Skip(size_t nframes){
+    const auto read = readPos.load(std::memory_order_relaxed);
+    const auto write = writePos.load(std::memory_order_acquire);
+    nframes = std::min<size_t>(nframes, static_cast<size_t>(write - read));
+    readPos.store(read + nframes, std::memory_order_release);
+    return nframes;
+}
+
+void AudioRingBuffer::DiscardUntil(uint64_t position){
+    if (readPos.load(std::memory_order_relaxed) < position){
+        readPos.store(position, std::memory_order_release);
+    }
+}
+
+namespace{
+
+inline uint16_t ReadLE16(const uint8_t* p){
+    return uint16_t(p[0]) | (uint16_t(p[1]) << 8);
+}
+
+inline uint32_t ReadLE32(const uint8_t* p){
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/**
+ Reads the sample data of a WAV file incrementally
+ */
+struct WavStreamReader{
+    std::FILE* file = nullptr;
+    nqr::PCMFormat format = nqr::PCM_END;
+    uint32_t sampleRate = 0;
+    uint16_t nchannels = 0;
+    uint16_t frameSize = 0;         // in bytes
+    long dataOffset = 0;
+    size_t numFrames = 0;
+    size_t framesRead = 0;
+
+    WavStreamReader(const Filesystem::Path& path){
+        const auto name = path.string();
+        file = std::fopen(name.c_str(), "rb");
+        if (file == nullptr){
+            Debug::Fatal("Cannot open {}", name);
+        }
+
+        uint8_t riff[12];
+        if (std::fread(riff, 1, sizeof(riff), file) != sizeof(riff) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0){
+            Debug::Fatal("{} is not a RIFF WAVE file", name);
+        }
+
+        uint16_t formatCode = 0, bitDepth = 0;
+        bool haveFormat = false;
+        while (true){
+            uint8_t header[8];
+            if (std::fread(header, 1, sizeof(header), file) != sizeof(header)){
+                Debug::Fatal("{} has no data chunk", name);
+            }
+            const auto size = ReadLE32(header + 4);
+            if (std::memcmp(header, "fmt ", 4) == 0){
+                uint8_t fmt[40]{};
+                const auto toRead = std::min<uint32_t>(size, sizeof(fmt));
+                if (size < 16 || std::fread(fmt, 1, toRead, file) != toRead){
+                    Debug::Fatal("{} has a malformed fmt chunk", name);
+                }
+                formatCode = ReadLE16(fmt);
+                nchannels = ReadLE16(fmt + 2);
+                sampleRate = ReadLE32(fmt + 4);
+                frameSize = ReadLE16(fmt + 12);
+                bitDepth = ReadLE16(fmt + 14);
+                // WAVE_FORMAT_EXTENSIBLE stores the real format code at the start of the subformat GUID
+                if (formatCode == 0xFFFE && size >= 26){
+                    formatCode = ReadLE16(fmt + 24);
+                }
+                std::fseek(file, long(size - toRead + (size & 1)), SEEK_CUR);
+                haveFormat = true;
+            }
+            else if (std::memcmp(header, "data", 4) == 0){
+                if (!haveFormat || frameSize == 0 || nchannels == 0){
+                    Debug::Fatal("{} has no usable fmt chunk before its data", name);
+                }
+                dataOffset = std::ftell(file);
+                numFrames = size / frameSize;
+                break;
+            }
+            else{
+                // chunks are padded to an even size
+                std::fseek(file, long(size + (size & 1)), SEEK_CUR);
+            }
+        }
+
+        if (formatCode == 1){
+            switch (bitDepth){
+                case 8: format = nqr::PCM_U8; break;
+                case 16: format = nqr::PCM_16; break;
+                case 24: format = nqr::PCM_24; break;
+                case 32: format = nqr::PCM_32; break;
+            }
+        }
+        else if (formatCode == 3){
+            switch (bitDepth){
+                case 32: format = nqr::PCM_FLT; break;
+                case 64: format = nqr::PCM_DBL; break;
+            }
+        }
+        if (format == nqr::PCM_END){
+            Debug::Fatal("{} uses an unsupported WAV encoding (format {}, {} bits). Load it with AudioAsset instead.", name, formatCode, bitDepth);
+        }
+    }
+
+    ~WavStreamReader(){
+        std::fclose(file);
+    }
+
+    /**
+     Decode the next frames to interleaved floats
+     @return the number of frames decoded, which is 0 at the end of the file
+     */
+    size_t Read(Vector<uint8_t>& raw, float* dest, size_t nframes){
+        nframes = std::min(nframes, numFrames - framesRead);
+        raw.resize(nframes * frameSize);
+        nframes = std::fread(raw.data(), frameSize, nframes, file);
+        // the same conversion that libnyquist uses, so that streamed and fully decoded assets match
+        nqr::ConvertToFloat32(dest, raw.data(), nframes * nchannels, format);
+        framesRead += nframes;
+        return nframes;
+    }
+
+    void Rewind(){
+        std::fseek(file, dataOffset, SEEK_SET);
+        framesRead = 0;
+    }
+};
+
+}
+
+struct StreamingAudioDataProvider::StreamState{
+    WavStreamReader reader;
+    AudioRingBuffer ring;
+    const uint8_t nchannels;
+    const size_t chunkFrames;
+    size_t outputFramesPerPass = 0;
+
+    // worker-only
+    Vector<std::unique_ptr<r8b::CDSPResampler>> resamplers;     // one per source channel, empty if the rates match
+    Vector<uint8_t> raw;
+    TrackedVector<float, MemoryTag::Audio> decoded;             // interleaved source frames
+    TrackedVector<double, MemoryTag::Audio> resampleInput;
+    TrackedVector<float, MemoryTag::Audio> converted;           // planar source channels, after resampling
+    TrackedVector<float, MemoryTag::Audio> pending;             // planar output channels, waiting for space in the ring
+    size_t pendingStride = 0, pendingOffset = 0, pendingFrames = 0;
+    size_t outputFramesProduced = 0;
+
+    // shared with the consumer
+    std::atomic<bool> cancelled = false;
+    std::atomic<bool> restartRequested = false;
+    std::atomic<bool> fullyDecoded = false;
+    std::atomic<bool> loops = false;
+    std::atomic<uint64_t> discardUntil = 0;
+    std::atomic<size_t> underruns = 0;
+    std::atomic<size_t> underrunFrames = 0;
+
+    StreamState(const Filesystem::Path& path, uint8_t nchannels, const StreamingAudioOptions& options) : reader(path), ring(nchannels, options.bufferFrames), nchannels(nchannels), chunkFrames(options.chunkFrames){
+        Debug::Assert(chunkFrames > 0, "Chunk size must be positive");
+        const auto srcChannels = reader.nchannels;
+        if (srcChannels != nchannels && !(srcChannels == 1 && nchannels == 2) && !(srcChannels == 2 && nchannels == 1)){
+            Debug::Fatal("Unable to convert input audio with {} channels to desired {} channels", srcChannels, nchannels);
+        }
+
+        const uint32_t sampleRate = options.sampleRate != 0 ? options.sampleRate : AudioPlayer::GetSamplesPerSec();
+        size_t maxOut = chunkFrames;
+        if (reader.sampleRate != sampleRate){
+            // matches AudioAsset, which resamples the whole file at once
+            outputFramesPerPass = static_cast<uint64_t>(reader.numFrames) * sampleRate / reader.sampleRate;
+            for(uint16_t c = 0; c < srcChannels; c++){
+                resamplers.push_back(std::make_unique<r8b::CDSPResampler>(reader.sampleRate, sampleRate, Debug::AssertSize<int>(chunkFrames)));
+            }
+            maxOut = resamplers.front()->getMaxOutLen(0);
+            resampleInput.resize(chunkFrames);
+        }
+        else{
+            outputFramesPerPass = reader.numFrames;
+        }
+
+        decoded.resize(chunkFrames * srcChannels);
+        converted.resize(maxOut * srcChannels);
+        pendingStride = maxOut;
+        pending.resize(maxOut * nchannels);
+    }
+
+    /**
+     Seek to the start of the file and reset the resamplers. Worker-only.
+     */
+    void Rewind(){
+        reader.Rewind();
+        for(auto& resampler : resamplers){
+            resampler->clear();
+        }
+        pendingFrames = 0;
+        pendingOffset = 0;
+        outputFramesProduced = 0;
+        fullyDecoded.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     Decode and resample the next chunk into pending. Worker-only.
+     */
+    void DecodeChunk(){
+        const auto srcChannels = reader.nchannels;
+        const auto nread = reader.Read(raw, decoded.data(), chunkFrames);
+        size_t produced = 0;
+        if (resamplers.empty()){
+            for(uint16_t c = 0; c < srcChannels; c++){
+                for(size_t i = 0; i < nread; i++){
+                    converted[c * pendingStride + i] = decoded[i * srcChannels + c];
+                }
+            }
+            produced = nread;
+            if (nread == 0){
+                // the file is shorter than its header claims
+                outputFramesProduced = outputFramesPerPass;
+            }
+        }
+        else{
+            // once the file is exhausted, feed silence to flush the filters, as CDSPResampler::oneshot does
+            const size_t nin = nread > 0 ? nread : chunkFrames;
+            for(uint16_t c = 0; c < srcChannels; c++){
+                for(size_t i = 0; i < nin; i++){
+                    resampleInput[i] = i < nread ? decoded[i * srcChannels + c] : 0.0;
+                }
+                double* out = nullptr;
+                produced = resamplers[c]->process(resampleInput.data(), static_cast<int>(nin), out);
+                for(size_t i = 0; i < produced; i++){
+                    converted[c * pendingStride + i] = static_cast<float>(out[i]);
+                }
+            }
+        }
+        produced = std::min(produced, outputFramesPerPass - outputFramesProduced);
+
+        // channel conversion, as AudioAsset does it
+        if (srcChannels == nchannels){
+            std::copy(converted.begin(), converted.begin() + pendingStride * nchannels, pending.begin());
+        }
+        else if (nchannels == 2){
+            std::copy(converted.begin(), converted.begin() + produced, pending.begin());
+            std::copy(converted.begin(), converted.begin() + produced, pending.begin() + pendingStride);
+        }
+        else{
+            for(size_t i = 0; i < produced; i++){
+                pending[i] = (converted[i] + converted[pendingStride + i]) / 2.0f;
+            }
+        }
+        pendingOffset = 0;
+        pendingFrames = produced;
+        outputFramesProduced += produced;
+    }
+
+    /**
+     Top up the ring. Worker-only.
+     @return true if any work was done
+     */
+    bool Fill(){
+        bool didWork = false;
+        if (restartRequested.load(std::memory_order_acquire)){
+            Rewind();
+            // everything already in the ring is from before the restart
+            discardUntil.store(ring.GetWritePosition(), std::memory_order_release);
+            restartRequested.store(false, std::memory_order_release);
+            didWork = true;
+        }
+        while (true){
+            if (pendingFrames > 0){
+                const auto written = ring.Write(pending.data() + pendingOffset, pendingStride, pendingFrames);
+                pendingOffset += written;
+                pendingFrames -= written;
+                didWork |= written > 0;
+                if (pendingFrames > 0){
+                    return didWork;     // ring is full
+                }
+            }
+            if (fullyDecoded.load(std::memory_order_relaxed)){
+                return didWork;
+            }
+            if (outputFramesProduced >= outputFramesPerPass){
+                if (loops.load(std::memory_order_relaxed) && outputFramesPerPass > 0){
+                    Rewind();
+                }
+                else{
+                    fullyDecoded.store(true, std::memory_order_release);
+                    return true;
+                }
+            }
+            DecodeChunk();
+            didWork = true;
+        }
+    }
+};
+
+/**
+ Services every StreamingAudioDataProvider on one background thread
+ */
+class RavEngine::AudioStreamWorker{
+    using state_ptr = std::shared_ptr<StreamingAudioDataProvider::StreamState>;
+    std::mutex mtx;
+    std::condition_variable cv;
+    Vector<state_ptr> streams;
+    bool running = true;
+    bool wake = false;
+    std::thread thread;
+
+    // how often to check for buffer space when there is nothing to do. Must be well under the ring's duration.
+    constexpr static auto pollInterval = std::chrono::milliseconds(2);
+
+    void Run(){
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+        pthread_setname_np(
+#if __linux__
+            pthread_self(),
+#endif
+            "Audio Streaming"
+        );
+#endif
+        Vector<state_ptr> local;
+        while (true){
+            {
+                std::lock_guard lock(mtx);
+                if (!running){
+                    break;
+                }
+                streams.erase(std::remove_if(streams.begin(), streams.end(), [](const state_ptr& s){
+                    return s->cancelled.load(std::memory_order_acquire);
+                }), streams.end());
+                local.assign(streams.begin(), streams.end());
+            }
+
+            bool didWork = false;
+            for(auto& stream : local){
+                if (!stream->cancelled.load(std::memory_order_acquire)){
+                    didWork |= stream->Fill();
+                }
+            }
+            local.clear();
+
+            if (!didWork){
+                std::unique_lock lock(mtx);
+                cv.wait_for(lock, pollInterval, [this]{ return !running || wake; });
+                wake = false;
+            }
+        }
+    }
+
+public:
+    AudioStreamWorker() : thread([this]{ Run(); }){}
+
+    ~AudioStreamWorker(){
+        {
+            std::lock_guard lock(mtx);
+            running = false;
+        }
+        cv.notify_all();
+        thread.join();
+    }
+
+    void Add(const state_ptr& stream){
+        {
+            std::lock_guard lock(mtx);
+            streams.push_back(stream);
+            wake = true;
+        }
+        cv.notify_one();
+    }
+
+    void Wake(){
+        {
+            std::lock_guard lock(mtx);
+            wake = true;
+        }
+        cv.notify_one();
+    }
+
+    static AudioStreamWorker& Get(){
+        static AudioStreamWorker worker;
+        return worker;
+    }
+};
+
+StreamingAudioDataProvider::StreamingAudioDataProvider(const Filesystem::Path& path, uint8_t nchannels, const StreamingAudioOptions& options) :
+    AudioDataProvider(AudioPlayer::GetBufferCount(), AudioPlayer::GetBufferSize(), nchannels),
+    state(std::make_shared<StreamState>(path, nchannels, options)),
+    nchannels(nchannels)
+{
+    AudioStreamWorker::Get().Add(state);
+}
+
+StreamingAudioDataProvider::~StreamingAudioDataProvider(){
+    // the worker releases its reference on its next pass
+    state->cancelled.store(true, std::memory_order_release);
+}
+
+// reads into buffer, or skips if it is null. Returns the number of frames available.
+size_t StreamingAudioDataProvider::Consume(PlanarSampleBufferInlineView* buffer, size_t nframes){
+    auto& s = *state;
+    s.loops.store(loops, std::memory_order_relaxed);
+
+    size_t nread = 0;
+    bool finished = false;
+    if (!s.restartRequested.load(std::memory_order_acquire)){
+        s.ring.DiscardUntil(s.discardUntil.load(std::memory_order_acquire));
+        // check before reading, so that frames written after the check are not mistaken for the end
+        finished = s.fullyDecoded.load(std::memory_order_acquire);
+        nread = buffer ? s.ring.Read(*buffer, 0, nframes, volume) : s.ring.Skip(nframes);
+    }
+    else{
+        finished = true;    // silence until the worker has seeked, but not an underrun
+    }
+
+    if (nread < nframes){
+        if (!finished){
+            s.underruns.fetch_add(1, std::memory_order_relaxed);
+            s.underrunFrames.fetch_add(nframes - nread, std::memory_order_relaxed);
+        }
+        else if (!s.restartRequested.load(std::memory_order_relaxed)){
+            isPlaying = false;
+        }
+    }
+    return nread;
+}
+
+void StreamingAudioDataProvider::ProvideBufferData(PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratchSpace){
+    assert(buffer.GetNChannels() >= nchannels);
+    const auto nread = Consume(&buffer, buffer.sizeOneChannel());
+    for(uint8_t c = 0; c < nchannels; c++){
+        std::fill(buffer[c].begin() + nread, buffer[c].end(), 0.0f);
+    }
+    AudioGraphComposed::Render(buffer, scratchSpace, nchannels);
+}
+
+void StreamingAudioDataProvider::Advance(size_t nframes){
+    Consume(nullptr, nframes);
+}
+
+void StreamingAudioDataProvider::Restart(){
+    state->restartRequested.store(true, std::memory_order_release);
+    AudioStreamWorker::Get().Wake();
+}
+
+size_t StreamingAudioDataProvider::GetUnderrunCount() const{
+    return state->underruns.load(std::memory_order_relaxed);
+}
+
+size_t StreamingAudioDataProvider::GetUnderrunFrames() const{
+    return state->underrunFrames.load(std::memory_order_relaxed);
+}
+
+size_t StreamingAudioDataProvider::GetBufferedFrames() const{
+    return state->ring.AvailableToRead();
+}
+
+bool StreamingAudioDataProvider::IsFullyDecoded() const{
+    return state->fullyDecoded.load(std::memory_order_acquire);
+}
+
+size_t StreamingAudioDataProvider::GetNumFrames() const{
+    return state->outputFramesPerPass;
+}
@@ -0,0 +1,123 @@
+#include "AudioVoiceManager.hpp"
+#include "AudioSnapshot.hpp"
+#include "AudioSource.hpp"
+#include <algorithm>
+
+using namespace RavEngine;
+
+void AudioVoiceManager::AddCandidate(const Ref<AudioDataProvider>& provider, float attenuation){
+    auto& state = tracked[provider.get()];
+    if (state.lastSeen == generation){
+        return; // already a candidate this buffer
+    }
+    const bool isNew = state.lastSeen == 0;
+    state.lastSeen = generation;
+
+    float score = provider->volume * provider->priority * attenuation;
+    if (state.real){
+        score *= options.hysteresis;
+    }
+    candidates.push_back({provider, score, state.real, isNew});
+}
+
+void AudioVoiceManager::AddPointSource(const Ref<AudioDataProvider>& provider, const vector3& worldpos){
+    // ranking only needs the order, so inverse distance stands in for the rolloff the room applies
+    const auto distance = glm::distance(worldpos, listenerPosForRanking);
+    AddCandidate(provider, options.referenceDistance / std::max<float>(distance, options.referenceDistance));
+}
+
+void AudioVoiceManager::AddAmbientSource(const Ref<AudioDataProvider>& provider){
+    AddCandidate(provider, 1);
+}
+
+void AudioVoiceManager::SetListener(const vector3& listenerPos){
+    listenerPosForRanking = listenerPos;
+}
+
+void AudioVoiceManager::Update(const AudioSnapshot& snapshot){
+    SetListener(snapshot.listenerPos);
+    for(const auto& source : snapshot.sources){
+        AddPointSource(source.data, source.worldpos);
+    }
+    for(const auto& source : snapshot.ambientSources){
+        AddAmbientSource(source);
+    }
+    Update();
+}
+
+void AudioVoiceManager::Update(){
+    realVoices.clear();
+    virtualVoices.clear();
+    statistics = {};
+    statistics.nSources = candidates.size();
+
+    // only the boundary matters, so partition rather than sort everything
+    const auto budget = std::min<size_t>(options.maxVoices, candidates.size());
+    const auto byScore = [](const Candidate& a, const Candidate& b){
+        return a.score > b.score;
+    };
+    std::nth_element(candidates.begin(), candidates.begin() + budget, candidates.end(), byScore);
+    std::sort(candidates.begin(), candidates.begin() + budget, byScore);
+
+    for(size_t i = 0; i < candidates.size(); i++){
+        auto& candidate = candidates[i];
+        const bool real = i < budget;
+        tracked[candidate.provider.get()].real = real;
+        if (real){
+            // a source that starts out real plays its beginning unfaded
+            const auto fade = (candidate.wasReal || candidate.isNew) ? Fade::None : Fade::In;
+            statistics.nPromoted += fade == Fade::In;
+            realVoices.push_back({std::move(candidate.provider), candidate.score, fade});
+        }
+        else if (candidate.wasReal){
+            // one more buffer to fade out
+            statistics.nDemoted++;
+            realVoices.push_back({std::move(candidate.provider), candidate.score, Fade::Out});
+        }
+        else{
+            virtualVoices.push_back({std::move(candidate.provider), candidate.score, Fade::None});
+        }
+    }
+    statistics.nReal = realVoices.size();
+    statistics.nVirtual = virtualVoices.size();
+    candidates.clear();
+
+    // forget sources that are no longer in the scene
+    for(auto it = tracked.begin(); it != tracked.end();){
+        if (it->second.lastSeen != generation){
+            tracked.erase(it++);
+        }
+        else{
+            ++it;
+        }
+    }
+    generation++;
+}
+
+void AudioVoiceManager::Render(const Voice& voice, PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratchSpace) const{
+    voice.provider->ProvideBufferData(buffer, scratchSpace);
+    if (voice.fade == Fade::None){
+        return;
+    }
+
+    const auto nframes = buffer.sizeOneChannel();
+    const auto fadeFrames = std::min<size_t>(options.fadeFrames, nframes);
+    const float from = voice.fade == Fade::In ? 0.0f : 1.0f;
+    const float step = ((voice.fade == Fade::In ? 1.0f : 0.0f) - from) / std::max<size_t>(fadeFrames, 1);
+    for(uint8_t c = 0; c < buffer.GetNChannels(); c++){
+        auto channel = buffer[c];
+        for(size_t i = 0; i < fadeFrames; i++){
+            channel[i] *= from + step * i;
+        }
+        // a voice fading out is silent after the fade, as it will be while virtual
+        if (voice.fade == Fade::Out){
+            std::fill(channel.begin() + fadeFrames, channel.end(), 0.0f);
+        }
+    }
+}
+
+void AudioVoiceManager::AdvanceVirtualVoices(size_t nframes) const{
+    for(const auto& voice : virtualVoices){
+        voice.provider->Advance(nframes);
+    }
+}
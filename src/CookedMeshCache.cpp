@@ -0,0 +1,155 @@
+#include "CookedMeshCache.hpp"
+#include "PhysicsSolver.hpp"
+#include "MeshAsset.hpp"
+#include "DiskCache.hpp"
+#include "Debug.hpp"
+#include <PxPhysicsAPI.h>
+#include <mutex>
+#include <vector>
+
+using namespace RavEngine;
+using namespace physx;
+
+namespace{
+
+// bump when the cooking parameters change, so that entries cooked by older versions are not used. PhysX's own version is part of the key.
+constexpr int cookedMeshCacheVersion = 1;
+
+std::mutex mtx;
+UnorderedMap<uint64_t, PxTriangleMesh*> triangleMeshes;
+UnorderedMap<uint64_t, PxConvexMesh*> convexMeshes;
+CookedMeshCache::Statistics statistics;
+
+// only the positions matter for collision, so the rest of each vertex is dropped before hashing and cooking
+struct MeshSource{
+    std::vector<PxVec3> vertices;
+    uint64_t hash;
+
+    MeshSource(MeshAsset& mesh, bool withIndices){
+        auto& meshdata = mesh.GetSystemCopy();
+        Debug::Assert(meshdata.vertices.size() > 0, "Cooking a collider requires the mesh's system memory copy");
+        vertices.resize(meshdata.vertices.size());
+        for(size_t i = 0; i < vertices.size(); i++){
+            vertices[i] = PxVec3(meshdata.vertices[i].position[0], meshdata.vertices[i].position[1], meshdata.vertices[i].position[2]);
+        }
+        hash = DiskCache::Hash(vertices.data(), vertices.size() * sizeof(vertices[0]));
+        if (withIndices){
+            hash = DiskCache::Hash(meshdata.indices.data(), meshdata.indices.size() * sizeof(meshdata.indices[0]), hash);
+        }
+    }
+};
+
+std::string KeyFor(const char* kind, uint64_t hash){
+    return StrFormat("{}{}-{:016x}-px{:x}", kind, cookedMeshCacheVersion, hash, PX_PHYSICS_VERSION);
+}
+
+/**
+ Find a mesh cooked earlier in this process, or load it from the disk cache, or cook it and store it there.
+ The lock is not held while loading or cooking, so two threads may cook the same mesh at once. The first to finish wins.
+ */
+template<typename T, typename cook_t, typename create_t>
+T* GetOrCook(UnorderedMap<uint64_t, T*>& meshes, const char* kind, uint64_t hash, const cook_t& cook, const create_t& create){
+    {
+        std::lock_guard lock(mtx);
+        if (auto it = meshes.find(hash); it != meshes.end()){
+            statistics.memoryHits++;
+            it->second->acquireReference();
+            return it->second;
+        }
+    }
+
+    auto& cache = CookedMeshCache::GetDiskCache();
+    const auto key = KeyFor(kind, hash);
+    T* mesh = nullptr;
+    bool fromDisk = false;
+    if (cache.IsEnabled()){
+        std::vector<uint8_t> stream;
+        if (cache.Load(key, [&](size_t bytes) -> void*{
+            stream.resize(bytes);
+            return stream.data();
+        })){
+            PxDefaultMemoryInputData input(stream.data(), PxU32(stream.size()));
+            mesh = create(input);
+            fromDisk = mesh != nullptr;     // a damaged entry is cooked again and replaced
+        }
+    }
+    if (mesh == nullptr){
+        PxDefaultMemoryOutputStream output;
+        if (!cook(output)){
+            Debug::Fatal("PhysX failed to cook a {} with hash {:016x}", kind, hash);
+        }
+        cache.Store(key, output.getData(), output.getSize());
+        PxDefaultMemoryInputData input(output.getData(), output.getSize());
+        mesh = create(input);
+    }
+
+    std::lock_guard lock(mtx);
+    (fromDisk ? statistics.diskHits : statistics.cooked)++;
+    auto [it, added] = meshes.try_emplace(hash, mesh);
+    if (!added){
+        mesh->release();
+    }
+    it->second->acquireReference();     // one reference for the map, one for the caller
+    return it->second;
+}
+
+}
+
+PxTriangleMesh* CookedMeshCache::GetTriangleMesh(MeshAsset& mesh){
+    MeshSource source(mesh, true);
+    auto& indices = mesh.GetSystemCopy().indices;
+    return GetOrCook(triangleMeshes, "trimesh", source.hash, [&](PxOutputStream& output){
+        PxTriangleMeshDesc meshDesc;
+        meshDesc.setToDefault();
+        meshDesc.points.data = source.vertices.data();
+        meshDesc.points.stride = sizeof(source.vertices[0]);
+        meshDesc.points.count = Debug::AssertSize<PxU32>(source.vertices.size(), "vertex count");
+        meshDesc.triangles.count = Debug::AssertSize<PxU32>(indices.size() / 3, "triangle count");
+        meshDesc.triangles.stride = 3 * sizeof(indices[0]);
+        meshDesc.triangles.data = indices.data();
+        // specify width
+        if (sizeof(indices[0]) == sizeof(uint16_t)){
+            meshDesc.flags = PxMeshFlag::e16_BIT_INDICES;
+        }    //otherwise assume 32 bit
+        return PhysicsSolver::GetCooking()->cookTriangleMesh(meshDesc, output);
+    }, [](PxInputStream& input){
+        return PhysicsSolver::phys->createTriangleMesh(input);
+    });
+}
+
+PxConvexMesh* CookedMeshCache::GetConvexMesh(MeshAsset& mesh){
+    MeshSource source(mesh, false);
+    return GetOrCook(convexMeshes, "convex", source.hash, [&](PxOutputStream& output){
+        PxConvexMeshDesc meshDesc;
+        meshDesc.setToDefault();
+        meshDesc.points.count = Debug::AssertSize<PxU32>(source.vertices.size(), "vertex count");
+        meshDesc.points.stride = sizeof(PxVec3);
+        meshDesc.points.data = source.vertices.data();
+        meshDesc.flags = PxConvexFlag::eCOMPUTE_CONVEX;
+        return PhysicsSolver::GetCooking()->cookConvexMesh(meshDesc, output);
+    }, [](PxInputStream& input){
+        return PhysicsSolver::phys->createConvexMesh(input);
+    });
+}
+
+DiskCache& CookedMeshCache::GetDiskCache(){
+    static DiskCache cache(DiskCache::TemporaryDirectory("CookedMeshCache"), 512 * 1024 * 1024);
+    return cache;
+}
+
+void CookedMeshCache::ReleaseAll(){
+    std::lock_guard lock(mtx);
+    for(auto& [hash, mesh] : triangleMeshes){
+        mesh->release();
+    }
+    for(auto& [hash, mesh] : convexMeshes){
+        mesh->release();
+    }
+    triangleMeshes.clear();
+    convexMeshes.clear();
+}
+
+CookedMeshCache::Statistics CookedMeshCache::GetStatistics(){
+    std::lock_guard lock(mtx);
+    return statistics;
+}
@@ -0,0 +1,305 @@
+#include "DiskCache.hpp"
+#include "Debug.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <ctime>
+
+#if (TARGET_OS_IOS && __IPHONE_OS_VERSION_MIN_REQUIRED < 130000)
+namespace fs = boost::filesystem;
+using error_code = boost::system::error_code;
+static inline auto Now(){ return std::time(nullptr); }
+#else
+namespace fs = std::filesystem;
+using error_code = std::error_code;
+static inline auto Now(){ return fs::file_time_type::clock::now(); }
+#endif
+
+using namespace RavEngine;
+
+namespace{
+
+constexpr uint32_t entryMagic = 0x43455652;     // "RVEC"
+constexpr uint32_t entryVersion = 1;
+constexpr const char* entryExtension = ".rvecache";
+
+struct EntryHeader{
+    uint32_t magic = entryMagic;
+    uint32_t version = entryVersion;
+    uint64_t payloadSize = 0;
+};
+
+// XXH64
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL, P2 = 0xC2B2AE3D27D4EB4FULL, P3 = 0x165667B19E3779F9ULL, P4 = 0x85EBCA77C2B2AE63ULL, P5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t Rotl(uint64_t x, int r){
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t Read64(const uint8_t* p){
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t Read32(const uint8_t* p){
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input){
+    acc += input * P2;
+    acc = Rotl(acc, 31);
+    return acc * P1;
+}
+
+inline uint64_t Merge(uint64_t acc, uint64_t val){
+    acc ^= Round(0, val);
+    return acc * P1 + P4;
+}
+
+}
+
+uint64_t DiskCache::Hash(const void* data, size_t size, uint64_t seed){
+    auto p = static_cast<const uint8_t*>(data);
+    const auto end = p + size;
+    uint64_t h;
+    if (size >= 32){
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        const auto limit = end - 32;
+        do{
+            v1 = Round(v1, Read64(p));
+            v2 = Round(v2, Read64(p + 8));
+            v3 = Round(v3, Read64(p + 16));
+            v4 = Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+        h = Merge(h, v1);
+        h = Merge(h, v2);
+        h = Merge(h, v3);
+        h = Merge(h, v4);
+    }
+    else{
+        h = seed + P5;
+    }
+    h += size;
+    for(; p + 8 <= end; p += 8){
+        h ^= Round(0, Read64(p));
+        h = Rotl(h, 27) * P1 + P4;
+    }
+    if (p + 4 <= end){
+        h ^= uint64_t(Read32(p)) * P1;
+        h = Rotl(h, 23) * P2 + P3;
+        p += 4;
+    }
+    for(; p < end; p++){
+        h ^= (*p) * P5;
+        h = Rotl(h, 11) * P1;
+    }
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+Filesystem::Path DiskCache::TemporaryDirectory(const std::string& name){
+    error_code ec;
+    auto temp = fs::temp_directory_path(ec);
+    return ec ? Filesystem::Path{} : temp / "RavEngine" / name;
+}
+
+DiskCache::DiskCache(const Filesystem::Path& directory, size_t maxBytes) : directory(directory), maxBytes(maxBytes){}
+
+void DiskCache::SetDirectory(const Filesystem::Path& dir){
+    std::lock_guard lock(mtx);
+    directory = dir;
+    scanned = false;
+    statistics.totalBytes = 0;
+}
+
+Filesystem::Path DiskCache::GetDirectory() const{
+    std::lock_guard lock(mtx);
+    return directory;
+}
+
+void DiskCache::SetMaxBytes(size_t bytes){
+    std::lock_guard lock(mtx);
+    maxBytes = bytes;
+    if (!directory.empty()){
+        ScanIfNeeded();
+        EvictToFit(maxBytes);
+    }
+}
+
+size_t DiskCache::GetMaxBytes() const{
+    std::lock_guard lock(mtx);
+    return maxBytes;
+}
+
+DiskCache::Statistics DiskCache::GetStatistics() const{
+    std::lock_guard lock(mtx);
+    return statistics;
+}
+
+Filesystem::Path DiskCache::PathFor(const std::string& key) const{
+    return directory / (key + entryExtension);
+}
+
+// call with the lock held
+void DiskCache::ScanIfNeeded(){
+    if (scanned){
+        return;
+    }
+    scanned = true;
+    statistics.totalBytes = 0;
+    error_code ec;
+    fs::create_directories(directory, ec);
+    for(fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)){
+        if (it->path().extension() == entryExtension){
+            statistics.totalBytes += fs::file_size(it->path(), ec);
+        }
+    }
+}
+
+// call with the lock held
+void DiskCache::EvictToFit(size_t limit){
+    if (statistics.totalBytes <= limit){
+        return;
+    }
+    struct Entry{
+        Filesystem::Path path;
+        decltype(fs::last_write_time(Filesystem::Path{})) lastUsed;
+        size_t size;
+    };
+    std::vector<Entry> entries;
+    error_code ec;
+    size_t total = 0;
+    for(fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)){
+        if (it->path().extension() != entryExtension){
+            continue;
+        }
+        error_code entryError;
+        Entry entry{it->path(), fs::last_write_time(it->path(), entryError), fs::file_size(it->path(), entryError)};
+        if (!entryError){
+            total += entry.size;
+            entries.push_back(std::move(entry));
+        }
+    }
+    // oldest first. Loads update the modification time, so it orders entries by last use.
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){
+        return a.lastUsed < b.lastUsed;
+    });
+    for(const auto& entry : entries){
+        if (total <= limit){
+            break;
+        }
+        error_code removeError;
+        if (fs::remove(entry.path, removeError)){
+            total -= entry.size;
+            statistics.evictions++;
+        }
+    }
+    statistics.totalBytes = total;
+}
+
+bool DiskCache::Load(const std::string& key, const Function<void*(size_t)>& allocate){
+    Filesystem::Path path;
+    {
+        std::lock_guard lock(mtx);
+        if (directory.empty()){
+            return false;
+        }
+        path = PathFor(key);
+    }
+
+    bool loaded = false;
+    if (auto file = std::fopen(path.string().c_str(), "rb")){
+        std::setvbuf(file, nullptr, _IONBF, 0);     // the payload goes straight to its destination
+        EntryHeader header;
+        if (std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == entryMagic && header.version == entryVersion){
+            error_code ec;
+            const auto fileSize = fs::file_size(path, ec);
+            // a truncated or padded file is treated as a miss
+            if (!ec && fileSize == sizeof(header) + header.payloadSize){
+                if (auto dest = allocate(header.payloadSize)){
+                    loaded = std::fread(dest, 1, header.payloadSize, file) == header.payloadSize;
+                }
+            }
+        }
+        std::fclose(file);
+    }
+
+    if (loaded){
+        error_code ec;
+        fs::last_write_time(path, Now(), ec);
+    }
+    std::lock_guard lock(mtx);
+    if (loaded){
+        statistics.hits++;
+    }
+    else{
+        statistics.misses++;
+    }
+    return loaded;
+}
+
+void DiskCache::Store(const std::string& key, const void* data, size_t size){
+    Filesystem::Path path, temp;
+    {
+        std::lock_guard lock(mtx);
+        if (directory.empty()){
+            return;
+        }
+        ScanIfNeeded();
+        path = PathFor(key);
+        // unique per store, so that concurrent stores of the same key do not interleave
+        static std::atomic<uint64_t> counter = 0;
+        temp = directory / StrFormat("{}.{}.{}.tmp", key, std::hash<std::thread::id>()(std::this_thread::get_id()), counter++);
+    }
+
+    auto file = std::fopen(temp.string().c_str(), "wb");
+    if (file == nullptr){
+        Debug::Warning("Cannot write cache entry {}", temp.string());
+        return;
+    }
+    EntryHeader header;
+    header.payloadSize = size;
+    const bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 && std::fwrite(data, 1, size, file) == size;
+    const bool closed = std::fclose(file) == 0;
+    error_code ec;
+    if (!written || !closed){
+        fs::remove(temp, ec);
+        Debug::Warning("Cannot write cache entry {}", temp.string());
+        return;
+    }
+
+    std::lock_guard lock(mtx);
+    const auto replaced = fs::exists(path, ec) ? fs::file_size(path, ec) : 0;
+    fs::rename(temp, path, ec);
+    if (ec){
+        fs::remove(temp, ec);
+        return;
+    }
+    statistics.stores++;
+    statistics.totalBytes += sizeof(header) + size;
+    statistics.totalBytes -= std::min<size_t>(replaced, statistics.totalBytes);
+    EvictToFit(maxBytes);
+}
+
+void DiskCache::Clear(){
+    std::lock_guard lock(mtx);
+    if (directory.empty()){
+        return;
+    }
+    ScanIfNeeded();
+    const auto evictions = statistics.evictions;
+    EvictToFit(0);
+    statistics.evictions = evictions;   // clearing is not an eviction
+}
@@ -0,0 +1,70 @@
+#include "FrameAllocator.hpp"
+#include <cstdlib>
+#include <algorithm>
+
+using namespace RavEngine;
+using namespace std;
+
+std::atomic<uint64_t> FrameArena::currentGeneration = 0;
+std::atomic<size_t> FrameArena::globalHighWaterMark = 0;
+size_t FrameArena::defaultCapacity = 512 * 1024;
+
+FrameArena::FrameArena(size_t capacity) : block(new std::byte[capacity]), capacity(capacity), generation(currentGeneration.load(std::memory_order_relaxed)){}
+
+FrameArena::~FrameArena(){
+    generation = currentGeneration.load(std::memory_order_relaxed);
+    Reset();
+}
+
+FrameArena& FrameArena::GetThreadArena(){
+    thread_local FrameArena arena(defaultCapacity);
+    return arena;
+}
+
+void* FrameArena::AllocateOverflow(size_t size, size_t alignment){
+    // round up so that aligned_alloc's size requirement is satisfied
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    auto rounded = (size + (alignment - 1)) & ~(alignment - 1);
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(rounded, alignment);
+#else
+    void* ptr = std::aligned_alloc(alignment, rounded);
+#endif
+    if (ptr == nullptr){
+        throw std::bad_alloc();
+    }
+    overflowAllocations.push_back(ptr);
+    overflowBytes += rounded;
+    return ptr;
+}
+
+void FrameArena::Reset(){
+    // record the peak before discarding this frame's usage
+    const auto frameUsage = offset + overflowBytes;
+    highWaterMark = std::max(highWaterMark, frameUsage);
+    auto prev = globalHighWaterMark.load(std::memory_order_relaxed);
+    while (prev < frameUsage && !globalHighWaterMark.compare_exchange_weak(prev, frameUsage, std::memory_order_relaxed));
+
+    for(auto ptr : overflowAllocations){
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+    overflowAllocations.clear();
+    overflowBytes = 0;
+    offset = 0;
+    lastOffset = 0;
+    generation = currentGeneration.load(std::memory_order_relaxed);
+}
+
+FrameArena::Statistics FrameArena::GetStatistics() const{
+    return Statistics{
+        .capacity = capacity,
+        .used = offset,
+        .overflowBytes = overflowBytes,
+        .overflowCount = overflowAllocations.size(),
+        .highWaterMark = std::max(highWaterMark, offset + overflowBytes)
+    };
+}
@@ -0,0 +1,71 @@
+#include "MemoryTracker.hpp"
+#include "SpinLock.hpp"
+#include <fmt/format.h>
+
+using namespace RavEngine;
+using namespace std;
+
+std::array<MemoryTracker::TagCounters, size_t(MemoryTag::Count)> MemoryTracker::tags;
+
+static SpinLock callbackLock;
+static std::array<MemoryTracker::budget_callback_t, size_t(MemoryTag::Count)> budgetCallbacks;
+
+MemoryTracker::TagStatistics MemoryTracker::GetStatistics(MemoryTag tag){
+    auto& counters = tags[size_t(tag)];
+    return TagStatistics{
+        .currentBytes = counters.current.load(std::memory_order_relaxed),
+        .peakBytes = counters.peak.load(std::memory_order_relaxed),
+        .allocations = counters.allocations.load(std::memory_order_relaxed),
+        .deallocations = counters.deallocations.load(std::memory_order_relaxed),
+        .budgetBytes = counters.budget.load(std::memory_order_relaxed)
+    };
+}
+
+void MemoryTracker::SetBudget(MemoryTag tag, size_t bytes, const budget_callback_t& callback){
+    RAIILock lock(callbackLock);
+    budgetCallbacks[size_t(tag)] = callback;
+    tags[size_t(tag)].budget.store(bytes, std::memory_order_relaxed);
+}
+
+void MemoryTracker::ResetPeaks(){
+    for(auto& counters : tags){
+        counters.peak.store(counters.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void MemoryTracker::BudgetExceeded(MemoryTag tag, size_t current, size_t budget){
+    // copy out so that the callback may call SetBudget
+    budget_callback_t callback;
+    {
+        RAIILock lock(callbackLock);
+        callback = budgetCallbacks[size_t(tag)];
+    }
+    if (callback){
+        callback(tag, current, budget);
+    }
+}
+
+const char* MemoryTracker::TagName(MemoryTag tag){
+    switch(tag){
+        case MemoryTag::General:    return "General";
+        case MemoryTag::Containers: return "Containers";
+        case MemoryTag::Meshes:     return "Meshes";
+        case MemoryTag::Audio:      return "Audio";
+        case MemoryTag::Physics:    return "Physics";
+        case MemoryTag::GPUBuffers: return "GPU Buffers";
+        case MemoryTag::Textures:   return "Textures";
+        default:                    return "Unknown";
+    }
+}
+
+std::string MemoryTracker::Report(){
+    std::string report = fmt::format("{:<12} {:>14} {:>14} {:>14} {:>10} {:>10}\n", "Tag", "Current", "Peak", "Budget", "Allocs", "Frees");
+    for(size_t i = 0; i < size_t(MemoryTag::Count); i++){
+        auto tag = static_cast<MemoryTag>(i);
+        auto stats = GetStatistics(tag);
+        auto budget = stats.budgetBytes == 0 ? std::string("-") : fmt::format("{}", stats.budgetBytes);
+        auto marker = (stats.budgetBytes != 0 && stats.currentBytes > stats.budgetBytes) ? " OVER" : "";
+        report += fmt::format("{:<12} {:>14} {:>14} {:>14} {:>10} {:>10}{}\n", TagName(tag), stats.currentBytes, stats.peakBytes, budget, stats.allocations, stats.deallocations, marker);
+    }
+    return report;
+}
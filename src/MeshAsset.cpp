@@ -153,6 +153,10 @@ MeshAsset::MeshAsset(const Filesystem::Path& path, const std::string& name, cons
 
 RavEngine::MeshAsset::~MeshAsset()
 {
+	// meshes that were never uploaded may outlive (or exist without) the renderer
+	if (!GetApp()->HasRenderEngine()){
+		return;
+	}
 	auto& gcBuffers = GetApp()->GetRenderEngine().gcBuffers;
 	gcBuffers.enqueue(vertexBuffer);
 	gcBuffers.enqueue(indexBuffer);
@@ -268,9 +272,9 @@ void MeshAsset::InitializeFromRawMeshView(const MeshPartView& allMeshes, const M
         totalVerts = v.size();
         totalIndices = i.size();
 
-		auto device = GetApp()->GetRenderEngine().GetDevice();
+		auto& renderEngine = GetApp()->GetRenderEngine();
 
-		vertexBuffer = device->CreateBuffer({
+		vertexBuffer = renderEngine.CreateBuffer({
 			uint32_t(totalVerts),
 			{.VertexBuffer = true},
 			sizeof(decltype(allMeshes.vertices)::value_type),
@@ -280,7 +284,7 @@ void MeshAsset::InitializeFromRawMeshView(const MeshPartView& allMeshes, const M
 
 		uint32_t index_stride = sizeof(uint32_t);
 
-		indexBuffer = device->CreateBuffer({
+		indexBuffer = renderEngine.CreateBuffer({
 			uint32_t(totalIndices),
 			{.IndexBuffer = true},
 			index_stride,
@@ -119,7 +119,7 @@ MeshAssetSkinned::MeshAssetSkinned(const std::string& path, Ref<SkeletonAsset> s
 	
 	//map to GPU
 	//TODO: make buffer Private
-	weightsBuffer = GetApp()->GetRenderEngine().GetDevice()->CreateBuffer({
+	weightsBuffer = GetApp()->GetRenderEngine().CreateBuffer({
 		uint32_t(weightsgpu.size()),
 		{.StorageBuffer = true},
 		sizeof(wrapper),
@@ -10,6 +10,7 @@
 #include "App.hpp"
 #include "MeshAsset.hpp"
 #include "RenderEngine.hpp"
+#include "FrameAllocator.hpp"
 
 using namespace std;
 using namespace RavEngine;
@@ -293,16 +294,18 @@ RavEngine::Vector<vector3> NavMeshComponent::CalculatePath(const vector3 &start,
         Debug::Fatal("Could not locate end poly");
     }
     
-    std::vector<dtPolyRef> polyPath(maxPoints);
+    // scratch buffers only live for this query, so take them from the frame arena instead of the heap.
+    // This is why the query must run inside a World tick: no frame can end between the two allocations.
+    FrameVector<dtPolyRef> polyPath(maxPoints);
     int nPathCount = 0;
     
     status = navMeshQuery->findPath(startPoly, endPoly, nearestpt, endpt, &filter, polyPath.data(), &nPathCount, maxPoints);
     if (dtStatusFailed(status)){
         Debug::Fatal("Unable to create poly path");
     }
-    std::vector<float> straightPath(maxPoints);
+    FrameVector<float> straightPath(maxPoints * 3);    // 3 floats per point
     int nVertCount = 0;
-    status = navMeshQuery->findStraightPath(nearestpt, endpt, polyPath.data(), nPathCount, straightPath.data(), NULL, NULL, &nVertCount, maxPoints*3);
+    status = navMeshQuery->findStraightPath(nearestpt, endpt, polyPath.data(), nPathCount, straightPath.data(), NULL, NULL, &nVertCount, maxPoints);
     if (dtStatusFailed(status)){
         Debug::Fatal("Unable to create path");
     }
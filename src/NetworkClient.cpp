@@ -151,7 +151,8 @@ void NetworkClient::ClientTick(){
                 NetDestroy(message);
                 break;
             case NetworkBase::CommandCode::RPC:
-				OnRPC(message);
+				OnRPC(pIncomingMsg);
+				pIncomingMsg = nullptr;	// the RPCComponent releases it after running the RPC
                 break;
 			case NetworkBase::CommandCode::OwnershipRevoked:
 				OwnershipRevoked(message);
@@ -164,7 +165,9 @@ void NetworkClient::ClientTick(){
             }
 			
 			// We don't need this anymore.
-			pIncomingMsg->Release();
+			if (pIncomingMsg) {
+				pIncomingMsg->Release();
+			}
 		}
 		
 		//state changes
@@ -270,17 +273,18 @@ void NetworkClient::SendMessageToServer(const std::string_view& msg, Reliability
 	net_interface->SendMessageToConnection(connection, msg.data(), static_cast<uint32_t>(msg.length()), mode, nullptr);
 }
 
-void RavEngine::NetworkClient::OnRPC(const std::string_view& cmd)
+void RavEngine::NetworkClient::OnRPC(SteamNetworkingMessage_t* msg)
 {
 	//decode the RPC header to to know where it is going
-	uuids::uuid id(cmd.data() + 1);
-	bool success = NetworkIdentities.if_contains(id, [&cmd,this](auto entity) {
+	uuids::uuid id(static_cast<const char*>(msg->m_pData) + 1);
+	bool success = NetworkIdentities.if_contains(id, [msg,this](auto entity) {
         assert(entity.template HasComponent<RPCComponent>());
         assert(entity.template HasComponent<NetworkIdentity>());
         auto& netid = entity.template GetComponent<NetworkIdentity>();
-        entity.template GetComponent<RPCComponent>().CacheClientRPC(cmd, netid.Owner == k_HSteamNetConnection_Invalid, this->connection);
+        entity.template GetComponent<RPCComponent>().CacheClientRPC(msg, netid.Owner == k_HSteamNetConnection_Invalid, this->connection);
 	});
 	if (!success) {
+		msg->Release();
 		Debug::Warning("Cannot relay RPC, entity with ID {} does not exist", id.to_string());
 	}
 }
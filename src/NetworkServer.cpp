@@ -6,6 +6,8 @@
 #include <steam/isteamnetworkingutils.h>
 #include "App.hpp"
 #include "RPCComponent.hpp"
+#include <vector>
+#include <algorithm>
 
 using namespace RavEngine;
 using namespace std;
@@ -63,6 +65,13 @@ void RavEngine::NetworkServer::SendMessageToAllClientsExcept(const std::string_v
 }
 
 void NetworkServer::Start(uint16_t port){
+	counters.messagesReceived = 0;
+	counters.bytesReceived = 0;
+	counters.receiveCalls = 0;
+	counters.idleWaits = 0;
+	counters.totalLatencyMicroseconds = 0;
+	counters.maxLatencyMicroseconds = 0;
+
 	//configure and start server
 	SteamNetworkingConfigValue_t opt;
 	opt.SetPtr(k_ESteamNetworkingConfig_ConnectionUserData, (void*)this);	//the thisptr
@@ -209,48 +218,93 @@ void NetworkServer::SteamNetConnectionStatusChanged(SteamNetConnectionStatusChan
 }
 
 void NetworkServer::ServerTick(){
+	std::vector<SteamNetworkingMessage_t*> batch(std::max(maxMessagesPerReceive, 1));
 	while(workerIsRunning){
 		
-		//get incoming messages
-		while (workerIsRunning){	//do we need this double loop?
-			ISteamNetworkingMessage *pIncomingMsg = nullptr;
-			int numMsgs = net_interface->ReceiveMessagesOnPollGroup( pollGroup, &pIncomingMsg, 1 );
+		//get incoming messages, a batch at a time, until none are left
+		bool received = false;
+		while (workerIsRunning){
+			int numMsgs = net_interface->ReceiveMessagesOnPollGroup( pollGroup, batch.data(), static_cast<int>(batch.size()) );
 			if ( numMsgs == 0 ){
 				break;
 			}
 			if ( numMsgs < 0 ){
 				Debug::Fatal( "Error checking for messages" );
 			}
+			received = true;
 			
-			//is this from a connected client
-			assert(clients.contains(pIncomingMsg->m_conn));
-			
-			//figure out what to do with the message
-            //get the command code (first byte in the message)
-            std::string_view message((char*)pIncomingMsg->m_pData, pIncomingMsg->m_cbSize);
-            uint8_t cmdcode = message[0];
-            switch (cmdcode) {
-            case NetworkBase::CommandCode::RPC:
-                //TODO: server needs to check ownership, client does not
-				OnRPC(message, pIncomingMsg->GetConnection());
-                break;
-			case NetworkBase::CommandCode::ClientRequestingWorldSynchronization:
-				SynchronizeWorldToClient(pIncomingMsg->GetConnection(), message);
-				break;
-            default:
-                Debug::Warning("Invalid command code: {}",cmdcode);
-            }
+			const auto now = SteamNetworkingUtils()->GetLocalTimestamp();
+			uint64_t bytes = 0;
+			int64_t latency = 0, maxLatency = counters.maxLatencyMicroseconds.load(std::memory_order_relaxed);
+			for (int i = 0; i < numMsgs; i++) {
+				bytes += batch[i]->m_cbSize;
+				const auto waited = now - batch[i]->m_usecTimeReceived;
+				latency += waited;
+				maxLatency = std::max<int64_t>(maxLatency, waited);
+				HandleMessage(batch[i]);
+			}
+			counters.messagesReceived.fetch_add(numMsgs, std::memory_order_relaxed);
+			counters.bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+			counters.receiveCalls.fetch_add(1, std::memory_order_relaxed);
+			counters.totalLatencyMicroseconds.fetch_add(latency, std::memory_order_relaxed);
+			counters.maxLatencyMicroseconds.store(maxLatency, std::memory_order_relaxed);
 			
-			//deallocate when done
-			pIncomingMsg->Release();
+			if (numMsgs < static_cast<int>(batch.size())) {
+				break;	// the poll group is drained
+			}
 		}
 				
 		//invoke callbacks
 		net_interface->RunCallbacks();
+		
+		// the library has no wait call, so when idle, check again after the poll interval instead of spinning
+		const auto interval = idlePollInterval.load(std::memory_order_relaxed);
+		if (!received && interval.count() > 0) {
+			counters.idleWaits.fetch_add(1, std::memory_order_relaxed);
+			std::this_thread::sleep_for(interval);
+		}
 	}
 	workerHasStopped = true;
 }
 
+void NetworkServer::HandleMessage(SteamNetworkingMessage_t* pIncomingMsg){
+	//is this from a connected client
+	assert(clients.contains(pIncomingMsg->m_conn));
+	
+	//figure out what to do with the message
+	//get the command code (first byte in the message)
+	std::string_view message((char*)pIncomingMsg->m_pData, pIncomingMsg->m_cbSize);
+	uint8_t cmdcode = message[0];
+	switch (cmdcode) {
+	case NetworkBase::CommandCode::RPC:
+		//TODO: server needs to check ownership, client does not
+		OnRPC(pIncomingMsg, pIncomingMsg->GetConnection());
+		pIncomingMsg = nullptr;	// the RPCComponent releases it after running the RPC
+		break;
+	case NetworkBase::CommandCode::ClientRequestingWorldSynchronization:
+		SynchronizeWorldToClient(pIncomingMsg->GetConnection(), message);
+		break;
+	default:
+		Debug::Warning("Invalid command code: {}",cmdcode);
+	}
+	
+	//deallocate when done
+	if (pIncomingMsg) {
+		pIncomingMsg->Release();
+	}
+}
+
+NetworkServer::Statistics NetworkServer::GetStatistics() const{
+	Statistics stats;
+	stats.messagesReceived = counters.messagesReceived;
+	stats.bytesReceived = counters.bytesReceived;
+	stats.receiveCalls = counters.receiveCalls;
+	stats.idleWaits = counters.idleWaits;
+	stats.totalLatencyMicroseconds = counters.totalLatencyMicroseconds;
+	stats.maxLatencyMicroseconds = counters.maxLatencyMicroseconds;
+	return stats;
+}
+
 void RavEngine::NetworkServer::SynchronizeWorldToClient(HSteamNetConnection connection, const std::string_view& in_message)
 {
     char buffer[World::id_size]{0};
@@ -273,17 +327,17 @@ void RavEngine::NetworkServer::SynchronizeWorldToClient(HSteamNetConnection conn
 	}
 }
 
-void RavEngine::NetworkServer::OnRPC(const std::string_view& cmd, HSteamNetConnection origin)
+void RavEngine::NetworkServer::OnRPC(SteamNetworkingMessage_t* msg, HSteamNetConnection origin)
 {
 	//decode the RPC header to to know where it is going
 
-	uuids::uuid id(cmd.data() + 1);
-	if (!NetworkIdentities.if_contains(id, [&cmd, &origin](auto entity) {
+	uuids::uuid id(static_cast<const char*>(msg->m_pData) + 1);
+	if (!NetworkIdentities.if_contains(id, [msg, &origin](auto entity) {
 		assert(entity.template HasComponent<NetworkIdentity>());
 		bool isOwner = origin == entity.template GetComponent<NetworkIdentity>().Owner;
-		entity.template GetComponent<RPCComponent>().CacheServerRPC(cmd, isOwner, origin);
+		entity.template GetComponent<RPCComponent>().CacheServerRPC(msg, isOwner, origin);
 		})) {
-		
+			msg->Release();
             Debug::Warning("Got RPC for {} but it has not been tracked, ids = ",id.to_string());
             for (const auto& [id,entity] : NetworkIdentities) {
                 Debug::Warning(" - UUID = {}, id = {}", id.to_string(), entity.id);
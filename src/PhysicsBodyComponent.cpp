@@ -29,6 +29,20 @@ void PhysicsBodyComponent::CompleteConstruction(){
     GetOwner().GetWorld()->Solver->Spawn(*this);
 }
 
+void PhysicsBodyComponent::EnsureInScene(){
+	if (rigidActor->getScene() == nullptr) {
+		// FlushActorChanges does nothing during a step, so wait for the step and apply the changes under the same lock
+		auto& solver = *GetOwner().GetWorld()->Solver;
+		solver.LockBodies(true);
+		solver.ApplyActorChanges();
+		solver.scene->unlockWrite();
+	}
+}
+
+void PhysicsBodyComponent::LockScene(PxScene* scene, bool write){
+	static_cast<PhysicsSolver*>(scene->userData)->LockBodies(write);
+}
+
 PhysicsBodyComponent::~PhysicsBodyComponent(){
     
 }
@@ -37,9 +51,7 @@ void PhysicsBodyComponent::Destroy(){
     //note: do not need to delete the rigid actor here. The PhysicsSolver will delete it
 	if (rigidActor != nullptr) {
 		auto e = GetOwner();
-		e.GetWorld()->Solver->Destroy(*this);
-		rigidActor->userData = nullptr;
-		rigidActor->release();
+		e.GetWorld()->Solver->Destroy(*this);	// releases the actor once it has left the scene
 
 		auto otherwayHandle = GetOwner().GetAllComponentsPolymorphic<PhysicsBodyComponent>().HandleFor<PolymorphicComponentHandle<PhysicsBodyComponent>>(0);
 		for (auto& receiver : receivers) {
@@ -96,9 +108,39 @@ std::pair<vector3,quaternion> PhysicsBodyComponent::getDynamicsWorldPose() const
 }
 
 void PhysicsBodyComponent::setDynamicsWorldPose(const vector3& pos, const quaternion& quat) const{
-	rigidActor->getScene()->lockWrite();
+	LockWrite([&] {
 		rigidActor->setGlobalPose(PxTransform(convert(pos), convertQuat(quat)));
-	rigidActor->getScene()->unlockWrite();
+	});
+}
+
+/**
+Call func on each write, holding the write lock of the body's scene. Consecutive bodies in the same scene share one lock.
+*/
+template<typename T>
+static inline void ForEachLocked(std::span<const PhysicsBodyComponent::PoseWrite> writes, const T& func){
+	PxScene* locked = nullptr;
+	for (const auto& write : writes) {
+		auto scene = write.body->rigidActor->getScene();
+		if (scene != locked) {
+			if (locked) {
+				locked->unlockWrite();
+			}
+			if (scene) {
+				static_cast<PhysicsSolver*>(scene->userData)->LockBodies(true);
+			}
+			locked = scene;
+		}
+		func(write);
+	}
+	if (locked) {
+		locked->unlockWrite();
+	}
+}
+
+void PhysicsBodyComponent::SetDynamicsWorldPoses(std::span<const PoseWrite> writes){
+	ForEachLocked(writes, [](const PoseWrite& write) {
+		write.body->rigidActor->setGlobalPose(PxTransform(convert(write.position), convertQuat(write.rotation)));
+	});
 }
 
 /**
@@ -153,35 +195,54 @@ RigidBodyDynamicComponent::~RigidBodyDynamicComponent() {
 
 void RigidBodyDynamicComponent::SetKinematicTarget(const vector3 &targetPos, const quaternion &targetRot){
     PxTransform transform(convert(targetPos), convertQuat(targetRot));
-    rigidActor->getScene()->lockWrite();
-    static_cast<PxRigidDynamic*>(rigidActor)->setKinematicTarget(transform);
-    rigidActor->getScene()->unlockWrite();
+    EnsureInScene();
+    LockWrite([&] {
+        static_cast<PxRigidDynamic*>(rigidActor)->setKinematicTarget(transform);
+    });
+}
+
+void RigidBodyDynamicComponent::SetKinematicTargets(std::span<const PoseWrite> writes){
+	// kinematic targets need the bodies in the scene. The first one that is not yet brings in the rest of its world's.
+	for (const auto& write : writes) {
+		static_cast<RigidBodyDynamicComponent*>(write.body)->EnsureInScene();
+	}
+	ForEachLocked(writes, [](const PoseWrite& write) {
+		assert(static_cast<RigidBodyDynamicComponent*>(write.body)->IsKinematic());
+		static_cast<PxRigidDynamic*>(write.body->rigidActor)->setKinematicTarget(PxTransform(convert(write.position), convertQuat(write.rotation)));
+	});
+}
+
+void RigidBodyDynamicComponent::SetKinematic(bool state){
+	kinematic = state;
+	LockWrite([&] {
+		static_cast<PxRigidDynamic*>(rigidActor)->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, state);
+	});
 }
 
 std::pair<vector3, quaternion> RigidBodyDynamicComponent::GetKinematicTarget() const{
     PxTransform trns;
-    rigidActor->getScene()->lockRead();
-    static_cast<PxRigidDynamic*>(rigidActor)->getKinematicTarget(trns);
-    rigidActor->getScene()->unlockRead();
+    LockRead([&] {
+        static_cast<PxRigidDynamic*>(rigidActor)->getKinematicTarget(trns);
+    });
     return std::make_pair(vector3(trns.p.x,trns.p.y,trns.p.z),quaternion(trns.q.w,trns.q.x,trns.q.y,trns.q.z));
 }
 
 vector3 RavEngine::RigidBodyDynamicComponent::GetLinearVelocity() const
 {
-	rigidActor->getScene()->lockRead();
-	auto vel = static_cast<PxRigidBody*>(rigidActor)->getLinearVelocity();
-	auto ret = vector3(vel.x,vel.y,vel.z);
-	rigidActor->getScene()->unlockRead();
-	return ret;
+	PxVec3 vel;
+	LockRead([&] {
+		vel = static_cast<PxRigidBody*>(rigidActor)->getLinearVelocity();
+	});
+	return vector3(vel.x,vel.y,vel.z);
 }
 
 vector3 RavEngine::RigidBodyDynamicComponent::GetAngularVelocity() const
 {
-	rigidActor->getScene()->lockRead();
-	auto vel = static_cast<PxRigidBody*>(rigidActor)->getAngularVelocity();
-	auto ret = vector3(vel.x,vel.y,vel.z);
-	rigidActor->getScene()->unlockRead();
-	return ret;
+	PxVec3 vel;
+	LockRead([&] {
+		vel = static_cast<PxRigidBody*>(rigidActor)->getAngularVelocity();
+	});
+	return vector3(vel.x,vel.y,vel.z);
 }
 
 /**
@@ -218,16 +279,19 @@ uint16_t RavEngine::RigidBodyDynamicComponent::GetAxisLock() const{
 
 void RavEngine::RigidBodyDynamicComponent::Wake()
 {
+	EnsureInScene();
 	static_cast<PxRigidDynamic*>(rigidActor)->wakeUp();
 }
 
 void RavEngine::RigidBodyDynamicComponent::Sleep()
 {
+	EnsureInScene();
 	static_cast<PxRigidDynamic*>(rigidActor)->putToSleep();
 }
 
 bool RavEngine::RigidBodyDynamicComponent::IsSleeping()
 {
+	EnsureInScene();
 	return static_cast<PxRigidDynamic*>(rigidActor)->isSleeping();
 }
 
@@ -259,6 +323,16 @@ void PhysicsBodyComponent::OnColliderExit(PhysicsBodyComponent& other, const Con
 }
 
 
+void PhysicsBodyComponent::SetWantsContactData(bool state){
+	wantsContactData = state;
+	// the flag travels in the shapes' filter data, so the solver can read it while PhysX reports contacts
+	LockWrite([&]{
+		for (auto& collider : colliders) {
+			collider.UpdateFilterData(this);
+		}
+	});
+}
+
 void PhysicsBodyComponent::OnTriggerEnter(PhysicsBodyComponent& other){
 	for (auto& receiver : receivers) {
         receiver->OnTriggerEnter(other);
@@ -292,24 +366,28 @@ decimalType RigidBodyDynamicComponent::GetMassInverse() const{
 }
 
 void RigidBodyDynamicComponent::AddForce(const vector3 &force){
+	EnsureInScene();
 	LockWrite([&]{
 		static_cast<PxRigidDynamic*>(rigidActor)->addForce(PxVec3(force.x,force.y,force.z));
 	});
 }
 
 void RigidBodyDynamicComponent::AddTorque(const vector3 &torque){
+	EnsureInScene();
 	LockWrite([&]{
 		static_cast<PxRigidDynamic*>(rigidActor)->addTorque(PxVec3(torque.x,torque.y,torque.z));
 	});
 }
 
 void RigidBodyDynamicComponent::ClearAllForces(){
+	EnsureInScene();
 	LockWrite([&]{
 		static_cast<PxRigidDynamic*>(rigidActor)->clearForce();
 	});
 }
 
 void RigidBodyDynamicComponent::ClearAllTorques(){
+	EnsureInScene();
 	LockWrite([&]{
 		static_cast<PxRigidDynamic*>(rigidActor)->clearTorque();
 	});
@@ -317,7 +395,9 @@ void RigidBodyDynamicComponent::ClearAllTorques(){
 
 /// Static Body ========================================
 RigidBodyStaticComponent::RigidBodyStaticComponent(entity_t owner) : PhysicsBodyComponent(owner) {
-	rigidActor = PhysicsSolver::phys->createRigidStatic(PxTransform(PxVec3(0, 0, 0)));	//will be set pre-tick to the entity's location
+	// created where the entity is, because statics are only moved again when their Transform changes
+	auto& transform = Entity(owner).GetTransform();
+	rigidActor = PhysicsSolver::phys->createRigidStatic(PxTransform(convert(transform.GetWorldPosition()), convertQuat(transform.GetWorldRotation())));
     CompleteConstruction();
 }
 
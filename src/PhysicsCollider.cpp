@@ -6,6 +6,7 @@
 #include "DebugDrawer.hpp"
 #include "PhysicsSolver.hpp"
 #include "Transform.hpp"
+#include "CookedMeshCache.hpp"
 
 using namespace physx;
 using namespace RavEngine;
@@ -14,7 +15,10 @@ void PhysicsCollider::UpdateFilterData(PhysicsBodyComponent* owner){
     PxFilterData filterData;
     filterData.word0 = owner->filterGroup; // word0 = own ID
     filterData.word1 = owner->filterMask;
+    filterData.word2 = owner->GetWantsContactData();   // read by PhysicsSolver::onContact
     collider->setSimulationFilterData(filterData);
+    // scene queries test only the group, so that a query's layers select bodies by what they are
+    collider->setQueryFilterData(PxFilterData(owner->filterGroup, 0, 0, 0));
 }
 
 BoxCollider::BoxCollider(PhysicsBodyComponent* owner, const vector3& ext, Ref<PhysicsMaterial> mat, const vector3& position, const quaternion& rotation) : extent(ext){
@@ -61,42 +65,7 @@ MeshCollider::MeshCollider(PhysicsBodyComponent* owner, Ref<MeshAsset> meshAsset
 #endif
 {
     material = mat;
-    auto& meshdata = meshAsset->GetSystemCopy();
-    
-    RavEngine::Vector<PxVec3> vertices(meshdata.vertices.size());
-    RavEngine::Vector<PxU32> indices(meshdata.indices.size());
-    // only want positional data here, UVs and other data are not relevant
-    for(int i = 0; i < vertices.size(); i++){
-        vertices[i] = PxVec3(meshdata.vertices[i].position[0],meshdata.vertices[i].position[1],meshdata.vertices[i].position[2]);
-    }
-    
-    for(int i = 0; i < indices.size(); i++){
-        indices[i] = meshdata.indices[i];
-    }
-    
-    // cooking data info
-    PxTriangleMeshDesc meshDesc;
-    meshDesc.setToDefault();
-    meshDesc.points.data = &vertices[0];
-    meshDesc.points.stride = sizeof(vertices[0]);
-	assert(vertices.size() < std::numeric_limits<physx::PxU32>::max());
-    meshDesc.points.count = static_cast<physx::PxU32>(vertices.size());
-    
-	assert(indices.size() / 3 < std::numeric_limits<physx::PxU32>::max());
-    meshDesc.triangles.count = static_cast<physx::PxU32>(indices.size() / 3);
-    meshDesc.triangles.stride = 3 * sizeof(indices[0]);
-    meshDesc.triangles.data = &indices[0];
-    
-    // specify width
-    if (sizeof(indices[0]) == sizeof(uint16_t)){
-        meshDesc.flags = PxMeshFlag::e16_BIT_INDICES;
-    }    //otherwise assume 32 bit
-    
-#ifndef NDEBUG
-    //Debug::Assert(PhysicsSolver::cooking->validateTriangleMesh(meshDesc), "Triangle mesh validation failed");
-#endif
-    
-    physx::PxTriangleMesh* triMesh = PhysicsSolver::cooking->createTriangleMesh(meshDesc, PhysicsSolver::phys->getPhysicsInsertionCallback());
+    auto triMesh = CookedMeshCache::GetTriangleMesh(*meshAsset);
     
     collider = PxRigidActorExt::createExclusiveShape(*owner->rigidActor, PxTriangleMeshGeometry(triMesh), *material->GetPhysXmat());
     triMesh->release();
@@ -105,30 +74,10 @@ MeshCollider::MeshCollider(PhysicsBodyComponent* owner, Ref<MeshAsset> meshAsset
 
 ConvexMeshCollider::ConvexMeshCollider(PhysicsBodyComponent* owner, Ref<MeshAsset> meshAsset, Ref<PhysicsMaterial> mat) {
     material = mat;
-    
-    auto& meshdata = meshAsset->GetSystemCopy();
-    
-    // only want positional data here, UVs and other data are not relevant
-    RavEngine::Vector<PxVec3> vertices(meshdata.vertices.size());
-    for(int i = 0; i < vertices.size(); i++){
-        vertices[i] = PxVec3(meshdata.vertices[i].position[0],meshdata.vertices[i].position[1],meshdata.vertices[i].position[2]);
-    }
-    
-    PxBoundedData pointdata;
-	assert(vertices.size() < std::numeric_limits<physx::PxU32>::max());
-    pointdata.count = static_cast<physx::PxU32>(vertices.size());
-    pointdata.stride = sizeof(PxVec3);
-    pointdata.data = &vertices[0];
-    
-    PxConvexMeshDesc meshDesc;
-    meshDesc.setToDefault();
-    meshDesc.points.count = static_cast<physx::PxU32>(vertices.size());
-    meshDesc.points = pointdata;
-    meshDesc.flags = PxConvexFlag::eCOMPUTE_CONVEX;
-    
-    physx::PxConvexMesh* convMesh = PhysicsSolver::cooking->createConvexMesh(meshDesc, PhysicsSolver::phys->getPhysicsInsertionCallback());
+    auto convMesh = CookedMeshCache::GetConvexMesh(*meshAsset);
     
     collider = PxRigidActorExt::createExclusiveShape(*owner->rigidActor, PxConvexMeshGeometry(convMesh), *material->GetPhysXmat());
+    convMesh->release();
     UpdateFilterData(owner);
 }
 
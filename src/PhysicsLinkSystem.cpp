@@ -7,22 +7,32 @@
 
 #include "PhysicsLinkSystem.hpp"
 #include "PhysicsBodyComponent.hpp"
+#include "World.hpp"
 #include "Entity.hpp"
 #include "Transform.hpp"
 
 using namespace RavEngine;
 
-void PhysicsLinkSystemRead::operator()(const RigidBodyDynamicComponent& rigid, Transform& transform) const{
-    //physx requires reads and writes to be sequential
-    auto pose = rigid.getDynamicsWorldPose();
-    transform.SetWorldPosition(pose.first);
-    transform.SetWorldRotation(pose.second);
-}
+uint32_t PhysicsLinkSystemWrite::operator()(World& world){
+    moved.clear();
+    targets.clear();
 
-void PhysicsLinkSystemWrite::operator()(const RigidBodyStaticComponent& rigid, const Transform& transform) const{
+    // only look at the poses of bodies that moved, because each write makes PhysX update its broadphase
+    world.Filter([this](RigidBodyStaticComponent& rigid, const Transform& transform){
+        if (transform.isPhysicsDirty){
+            moved.push_back({&rigid, transform.GetWorldPosition(), transform.GetWorldRotation()});
+            transform.isPhysicsDirty = false;
+        }
+    });
+    world.Filter([this](RigidBodyDynamicComponent& rigid, const Transform& transform){
+        if (transform.isPhysicsDirty && rigid.IsKinematic()){
+            targets.push_back({&rigid, transform.GetWorldPosition(), transform.GetWorldRotation()});
+            transform.isPhysicsDirty = false;
+        }
+    });
 
-    //physx requires reads and writes to be sequential
-    auto pos = transform.GetWorldPosition();
-    auto rot = transform.GetWorldRotation();
-    rigid.setDynamicsWorldPose(pos,rot);
+    //physx requires reads and writes to be sequential, so all of them happen under one lock
+    PhysicsBodyComponent::SetDynamicsWorldPoses({moved.data(), moved.size()});
+    RigidBodyDynamicComponent::SetKinematicTargets({targets.data(), targets.size()});
+    return uint32_t(moved.size() + targets.size());
 }
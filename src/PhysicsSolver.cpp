@@ -10,11 +10,17 @@
 #include "App.hpp"
 #include "PhysXDefines.h"
 #include "Entity.hpp"
-#include <snippetcommon/SnippetPVD.h>
+#include "MemoryTracker.hpp"
+#include "Transform.hpp"
+#include "CookedMeshCache.hpp"
+#include <cstdlib>
 #include <extensions/PxDefaultSimulationFilterShader.h>
 #define PX_RELEASE(x)    if(x)    { x->release(); x = NULL;    }
 
 #include <thread>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
 
 using namespace physx;
 using namespace std;
@@ -27,6 +33,39 @@ STATIC(PhysicsSolver::foundation) = nullptr;
 STATIC(PhysicsSolver::phys) = nullptr;
 STATIC(PhysicsSolver::pvd) = nullptr;
 STATIC(PhysicsSolver::cooking) = nullptr;
+STATIC(PhysicsSolver::config);
+
+// PhysX requires 16-byte alignment. The allocation size is stored in front of the returned block
+// so that deallocate, which is not given a size, can uncharge it.
+constexpr static size_t physx_alignment = 16;
+
+void* PhysicsSolver::TrackingAllocator::allocate(size_t size, const char* typeName, const char* filename, int line){
+    const auto total = size + physx_alignment;
+#ifdef _WIN32
+    auto block = static_cast<std::byte*>(_aligned_malloc(total, physx_alignment));
+#else
+    auto block = static_cast<std::byte*>(std::aligned_alloc(physx_alignment, (total + physx_alignment - 1) & ~(physx_alignment - 1)));
+#endif
+    if (block == nullptr){
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    MemoryTracker::Allocated(MemoryTag::Physics, size);
+    return block + physx_alignment;
+}
+
+void PhysicsSolver::TrackingAllocator::deallocate(void* ptr){
+    if (ptr == nullptr){
+        return;
+    }
+    auto block = static_cast<std::byte*>(ptr) - physx_alignment;
+    MemoryTracker::Deallocated(MemoryTag::Physics, *reinterpret_cast<size_t*>(block));
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+}
 
 
 //see https://gameworksdocs.nvidia.com/PhysX/4.1/documentation/physxguide/Manual/RigidBodyCollision.html#broad-phase-callback
@@ -50,57 +89,72 @@ PxFilterFlags FilterShader(physx::PxFilterObjectAttributes attributes0, physx::P
 }
 
 
-// Invoked by PhysX after simulation each tick
+namespace{
+    // marks the actors of destroyed bodies, which stay in the scene until the next FlushActorChanges
+    void* const removedActorData = reinterpret_cast<void*>(~uintptr_t(0));
+
+    // false for actors whose body was never spawned or has been destroyed, which PhysX keeps reporting until they leave the scene
+    inline bool HasLiveOwner(const PxActor* actor){
+        return actor->userData != nullptr && actor->userData != removedActorData;
+    }
+}
+
+// Invoked by PhysX while fetching each substep's results. Only records the events, because PhysX holds its own locks here. DispatchEvents delivers them.
 void PhysicsSolver::onContact(const physx::PxContactPairHeader& pairHeader, const physx::PxContactPair* pairs, physx::PxU32 nbPairs)
 {
+    //if these actors do not exist in the scene anymore due to deallocation, do not process
+    if(!HasLiveOwner(pairHeader.actors[0]) || !HasLiveOwner(pairHeader.actors[1])){
+        return;
+    }
+    Entity actor1_e, actor2_e;
+    std::memcpy(&actor1_e, &pairHeader.actors[0]->userData, sizeof(actor1_e));
+    std::memcpy(&actor2_e, &pairHeader.actors[1]->userData, sizeof(actor2_e));
+
     for (PxU32 i = 0; i < nbPairs; ++i) {
         const PxContactPair& contactpair = pairs[i];
         
-        //if these actors do not exist in the scene anymore due to deallocation, do not process
-        if(pairHeader.actors[0]->userData == nullptr || pairHeader.actors[1]->userData == nullptr){
-            continue;
-        }
-
-        Entity actor1_e, actor2_e;
-        
-        //get the physics body component stored in the user data (non-owning pointer!)
-        std::memcpy(&actor1_e, &pairHeader.actors[0]->userData, sizeof(actor1_e));
-        std::memcpy(&actor2_e, &pairHeader.actors[1]->userData, sizeof(actor2_e));
-
-        auto& actor1 = actor1_e.GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0];
-        auto& actor2 = actor2_e.GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0];
-
-        size_t numContacts = 0;
-        stackarray(contactPoints, ContactPairPoint, contactpair.contactCount);
-        {
-            // do we need contact data?
-            if (actor1.GetWantsContactData() || actor2.GetWantsContactData()) {
-                stackarray(points, PxContactPairPoint, contactpair.contactCount);
-                auto count = contactpair.extractContacts(points, contactpair.contactCount);
-                for (int i = 0; i < contactpair.contactCount; i++) {
-                    contactPoints[i] = points[i];
-                }
-                numContacts = count;
-            }
-        }
-		
-        //invoke events
+        ContactEvent event;
+        event.a = actor1_e.id;
+        event.b = actor2_e.id;
+        event.step = eventStep;
         if (contactpair.events & PxPairFlag::eNOTIFY_TOUCH_FOUND) {
-
-            actor1.OnColliderEnter(actor2,contactPoints, numContacts);
-            actor2.OnColliderEnter(actor1, contactPoints, numContacts);
+            event.flags |= ContactEvent::Begin;
+        }
+        if (contactpair.events & PxPairFlag::eNOTIFY_TOUCH_PERSISTS) {
+            event.flags |= ContactEvent::Persist;
         }
-
         if (contactpair.events & PxPairFlag::eNOTIFY_TOUCH_LOST) {
-            actor1.OnColliderExit(actor2, contactPoints, numContacts);
-            actor2.OnColliderExit(actor1, contactPoints, numContacts);
+            event.flags |= ContactEvent::End;
         }
-
-        if (contactpair.events & PxPairFlag::eNOTIFY_TOUCH_PERSISTS) {
-            actor1.OnColliderPersist(actor2, contactPoints, numContacts);
-            actor2.OnColliderPersist(actor1, contactPoints, numContacts);
+        if (event.flags == 0){
+            continue;
         }
 
+        if (contactpair.contactCount > 0) {
+            extractedPoints.resize(std::max<size_t>(extractedPoints.size(), contactpair.contactCount));
+            const auto count = contactpair.extractContacts(extractedPoints.data(), contactpair.contactCount);
+            if (count > 0){
+                const auto& first = extractedPoints[0];
+                event.point = vector3(first.position.x, first.position.y, first.position.z);
+                event.normal = vector3(first.normal.x, first.normal.y, first.normal.z);
+                PxVec3 impulse(0);
+                for (PxU32 p = 0; p < count; p++) {
+                    impulse += extractedPoints[p].impulse;
+                }
+                event.impulse = vector3(impulse.x, impulse.y, impulse.z);
+
+                // whether a body wants all of the points travels in its shapes' filter data, so no component lookup is needed here
+                const bool shapesRemoved = contactpair.flags & (PxContactPairFlag::eREMOVED_SHAPE_0 | PxContactPairFlag::eREMOVED_SHAPE_1);
+                if (!shapesRemoved && (contactpair.shapes[0]->getSimulationFilterData().word2 || contactpair.shapes[1]->getSimulationFilterData().word2)) {
+                    event.firstPoint = uint32_t(eventPoints.size());
+                    event.nPoints = count;
+                    for (PxU32 p = 0; p < count; p++) {
+                        eventPoints.emplace_back(extractedPoints[p]);
+                    }
+                }
+            }
+        }
+        events.push_back(event);
     }
 }
 
@@ -114,7 +168,7 @@ void PhysicsSolver::onTrigger(physx::PxTriggerPair* pairs, physx::PxU32 count)
         }
 		
         //if these actors do not exist in the scene anymore due to deallocation, do not process
-        if(cp.otherActor->userData == nullptr || cp.triggerActor->userData == nullptr){
+        if(!HasLiveOwner(cp.otherActor) || !HasLiveOwner(cp.triggerActor)){
             continue;
         }
         
@@ -124,38 +178,188 @@ void PhysicsSolver::onTrigger(physx::PxTriggerPair* pairs, physx::PxU32 count)
         memcpy(&other_e, &cp.otherActor->userData, sizeof(other_e));
         memcpy(&trigger_e, &cp.triggerActor->userData, sizeof(trigger_e));
     
-        auto& other = other_e.GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0];
-        auto& trigger = trigger_e.GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0];
-
-		//process events
+        ContactEvent event;
+        event.a = trigger_e.id;
+        event.b = other_e.id;
+        event.step = eventStep;
+        event.flags = ContactEvent::Trigger;
 		if(cp.status & (PxPairFlag::eNOTIFY_TOUCH_FOUND)){
-			other.OnTriggerEnter(trigger);
-			trigger.OnTriggerEnter(other);
+            event.flags |= ContactEvent::Begin;
 		}
-		
 		if(cp.status & (PxPairFlag::eNOTIFY_TOUCH_LOST)){
-			other.OnTriggerExit(trigger);
-			trigger.OnTriggerExit(other);
+            event.flags |= ContactEvent::End;
 		}
+        events.push_back(event);
+    }
+}
+
+uint32_t PhysicsSolver::DispatchEvents(){
+    const auto nevents = uint32_t(events.size());
+
+    // every event goes to both of its bodies. Sorting by receiver lets each body be looked up once, and keeps its events in order.
+    deliveries.clear();
+    for (uint32_t i = 0; i < nevents; i++) {
+        const auto& event = events[i];
+        deliveries.push_back({event.a, event.b, i});
+        deliveries.push_back({event.b, event.a, i});
+    }
+    std::sort(deliveries.begin(), deliveries.end(), [](const EventDelivery& x, const EventDelivery& y){
+        return x.receiver < y.receiver || (x.receiver == y.receiver && x.event < y.event);
+    });
+
+    // receivers may destroy bodies, so destroyedSinceFetch is checked before every call. The lock is not held
+    // across the calls, because a receiver that destroys a body takes it too.
+    auto alive = [this](entity_t id){
+        RAIILock lock(bodyLock);
+        return destroyedSinceFetch.empty() || !destroyedSinceFetch.contains(id);
+    };
+    for (size_t begin = 0; begin < deliveries.size();) {
+        const auto receiver = deliveries[begin].receiver;
+        size_t end = begin + 1;
+        while (end < deliveries.size() && deliveries[end].receiver == receiver) {
+            end++;
+        }
+        if (!alive(receiver)) {
+            begin = end;
+            continue;
+        }
+        // receivers may spawn or destroy bodies, which can move the others in memory, so bodies are looked up again after that happens
+        auto lookup = [](entity_t id){
+            return &Entity(id).GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0];
+        };
+        auto body = lookup(receiver);
+        uint64_t lookedUpAt = bodyGeneration;
+        // most bodies in a pile have nobody listening, so their events cost nothing more
+        if (!body->HasReceivers()) {
+            begin = end;
+            continue;
+        }
+        for (auto d = begin; d < end; d++) {
+            const auto& delivery = deliveries[d];
+            const auto& event = events[delivery.event];
+            PhysicsBodyComponent* other = nullptr;
+            auto deliver = [&](const auto& func){
+                if (!alive(receiver) || !alive(delivery.other)) {
+                    return;
+                }
+                if (other == nullptr || lookedUpAt != bodyGeneration) {
+                    body = lookup(receiver);
+                    other = lookup(delivery.other);
+                    lookedUpAt = bodyGeneration;
+                }
+                func(*body, *other);
+            };
+            if (event.flags & ContactEvent::Trigger) {
+                if (event.flags & ContactEvent::Begin) {
+                    deliver([](auto& body, auto& other){ body.OnTriggerEnter(other); });
+                }
+                if (event.flags & ContactEvent::End) {
+                    deliver([](auto& body, auto& other){ body.OnTriggerExit(other); });
+                }
+                continue;
+            }
+            const auto points = eventPoints.data() + event.firstPoint;
+            const auto npoints = event.nPoints;
+            if (event.flags & ContactEvent::Begin) {
+                deliver([=](auto& body, auto& other){ body.OnColliderEnter(other, points, npoints); });
+            }
+            if (event.flags & ContactEvent::End) {
+                deliver([=](auto& body, auto& other){ body.OnColliderExit(other, points, npoints); });
+            }
+            if (event.flags & ContactEvent::Persist) {
+                deliver([=](auto& body, auto& other){ body.OnColliderPersist(other, points, npoints); });
+            }
+        }
+        begin = end;
     }
+
+    events.clear();
+    eventPoints.clear();
+    {
+        RAIILock lock(bodyLock);
+        destroyedSinceFetch.clear();
+    }
+    return nevents;
 }
 
 void PhysicsSolver::DeallocatePhysx() {
     if (scene != nullptr) {
+        FlushActorChanges();    // releases the actors of destroyed bodies
         PX_RELEASE(scene);
     }
 }
 
+namespace{
+    // guards the process-wide PhysX objects, which are created by the first solver or cook that needs them
+    std::mutex staticsMtx;
+}
+
 void PhysicsSolver::ReleaseStatics() {
+    CookedMeshCache::ReleaseAll();
+    std::lock_guard lock(staticsMtx);
+    PX_RELEASE(cooking);
+    if (phys != nullptr){
+        PxCloseExtensions();
+    }
     PX_RELEASE(phys);
+    if (pvd != nullptr){
+        auto transport = pvd->getTransport();
+        PX_RELEASE(pvd);
+        PX_RELEASE(transport);
+    }
     PX_RELEASE(foundation);
-	PX_RELEASE(cooking);
+}
+
+PxCooking* PhysicsSolver::GetCooking(){
+    std::lock_guard lock(staticsMtx);
+    if (cooking == nullptr){
+        Debug::Assert(foundation != nullptr, "Create a PhysicsSolver before cooking meshes");
+        PxCookingParams params(phys->getTolerancesScale());
+        // disable mesh cleaning - perform mesh validation on development configurations
+        //params.meshPreprocessParams |= PxMeshPreprocessingFlag::eDISABLE_CLEAN_MESH;
+        // disable edge precompute, edges are set for each triangle, slows contact generation
+        //params.meshPreprocessParams |= PxMeshPreprocessingFlag::eDISABLE_ACTIVE_EDGES_PRECOMPUTE;
+        cooking = PxCreateCooking(PX_PHYSICS_VERSION, *foundation, params);
+        if (!cooking){
+            Debug::Fatal("PhysX Cooking initialization failed");
+        }
+    }
+    return cooking;
+}
+
+namespace{
+    /**
+     Drops hits on actors waiting to be removed, and keeps the rest as the hit type PhysX would have chosen without a filter.
+     */
+    struct SkipRemovedActors : public PxQueryFilterCallback{
+        const PxQueryHitType::Enum keep;
+
+        SkipRemovedActors(PxQueryHitType::Enum keep) : keep(keep){}
+
+        PxQueryHitType::Enum preFilter(const PxFilterData&, const PxShape*, const PxRigidActor* actor, PxHitFlags&) override{
+            return actor->userData == removedActorData ? PxQueryHitType::eNONE : keep;
+        }
+
+        PxQueryHitType::Enum postFilter(const PxFilterData&, const PxQueryHit&, const PxShape*, const PxRigidActor*) override{
+            return keep;
+        }
+    };
+    // queries with room only for the blocking hit, and queries that collect touching hits
+    SkipRemovedActors skipRemovedBlocks(PxQueryHitType::eBLOCK), skipRemovedTouches(PxQueryHitType::eTOUCH);
+}
+
+PxQueryFilterData PhysicsSolver::SkipRemoved(PxQueryFilterData data) const{
+    // without removals pending, queries do not pay for a callback per candidate
+    if (nPendingRemovals.load(std::memory_order_relaxed) > 0){
+        data.flags |= PxQueryFlag::ePREFILTER;
+    }
+    return data;
 }
 
 bool RavEngine::PhysicsSolver::Raycast(const vector3& origin, const vector3& direction, decimalType maxDistance, RaycastHit& out_hit)
 {
     PxRaycastBuffer hit;
-    bool result = scene->raycast(PxVec3(origin.x, origin.y, origin.z), PxVec3(direction.x, direction.y, direction.z), maxDistance, hit);
+    bool result = scene->raycast(PxVec3(origin.x, origin.y, origin.z), PxVec3(direction.x, direction.y, direction.z), maxDistance, hit, PxHitFlag::eDEFAULT, SkipRemoved(PxQueryFilterData()), &skipRemovedBlocks);
 
     //construct hit result
     out_hit = RaycastHit(hit);
@@ -180,11 +384,231 @@ bool RavEngine::PhysicsSolver::CapsuleOverlap(const vector3& origin, const quate
 bool RavEngine::PhysicsSolver::generic_overlap(const PhysicsTransform& t, const PxGeometry& geo, OverlapHit& out_hit)
 {
     PxOverlapBuffer hit;
-    bool result = scene->overlap(geo,PxTransform(PxVec3(t.pos.x,t.pos.y,t.pos.y),PxQuat(t.rot.x,t.rot.y,t.rot.z,t.rot.w)),hit);
+    bool result = scene->overlap(geo,PxTransform(PxVec3(t.pos.x,t.pos.y,t.pos.z),PxQuat(t.rot.x,t.rot.y,t.rot.z,t.rot.w)),hit,SkipRemoved(PxQueryFilterData()),&skipRemovedBlocks);
     out_hit = OverlapHit(hit);
     return result;
 }
 
+PhysicsSolver::QueryShape PhysicsSolver::QueryShape::Box(const vector3& origin, const quaternion& rotation, const vector3& half_ext){
+    return {Type::Box, origin, rotation, half_ext};
+}
+
+PhysicsSolver::QueryShape PhysicsSolver::QueryShape::Sphere(const vector3& origin, decimalType radius){
+    return {Type::Sphere, origin, quaternion(1, 0, 0, 0), vector3(radius, 0, 0)};
+}
+
+PhysicsSolver::QueryShape PhysicsSolver::QueryShape::Capsule(const vector3& origin, const quaternion& rotation, decimalType radius, decimalType halfheight){
+    return {Type::Capsule, origin, rotation, vector3(radius, halfheight, 0)};
+}
+
+namespace{
+    // queries per chunk, below which handing work to another thread costs more than it saves
+    constexpr uint32_t min_query_chunk = 256;
+
+    // how many touching hits PhysX gathers before handing them to a NearestHits
+    constexpr PxU32 query_scratch_hits = 16;
+
+    PxGeometryHolder ToGeometry(const PhysicsSolver::QueryShape& shape){
+        switch(shape.type){
+            case PhysicsSolver::QueryShape::Type::Box:
+                return PxBoxGeometry(shape.size.x, shape.size.y, shape.size.z);
+            case PhysicsSolver::QueryShape::Type::Capsule:
+                return PxCapsuleGeometry(shape.size.x, shape.size.y);
+            default:
+                return PxSphereGeometry(shape.size.x);
+        }
+    }
+
+    PxTransform ToPose(const PhysicsSolver::QueryShape& shape){
+        return PxTransform(PxVec3(shape.origin.x, shape.origin.y, shape.origin.z), PxQuat(shape.rotation.x, shape.rotation.y, shape.rotation.z, shape.rotation.w));
+    }
+
+    PxQueryFilterData ToFilterData(const PhysicsSolver::QueryFilter& filter){
+        PxQueryFilterData data(PxQueryFlags(0));
+        if (filter.statics){
+            data.flags |= PxQueryFlag::eSTATIC;
+        }
+        if (filter.dynamics){
+            data.flags |= PxQueryFlag::eDYNAMIC;
+        }
+        // PhysX skips the layer test when the filter words are all zero, so the default filter also hits bodies without a group
+        if (filter.layers != ~PxU32(0)){
+            data.data.word0 = filter.layers;
+        }
+        return data;
+    }
+
+    /**
+     Receives every touching hit of one query and keeps the first max of them, or the nearest max if Ordered.
+     PhysX hands over hits in small groups, so the query's output never needs a buffer of its own.
+     */
+    template<typename PxHit, typename Hit, bool Ordered>
+    struct NearestHits : public PxHitCallback<PxHit>{
+        PxHit scratch[query_scratch_hits];
+        Hit* out;
+        uint32_t max;
+        uint32_t count = 0;
+        bool overflowed = false;
+
+        NearestHits(Hit* out, uint32_t max) : PxHitCallback<PxHit>(scratch, query_scratch_hits), out(out), max(max){}
+
+        PxAgain processTouches(const PxHit* buffer, PxU32 nbHits) override{
+            for(PxU32 i = 0; i < nbHits; i++){
+                if (count < max){
+                    out[count++] = Hit(buffer[i]);
+                    continue;
+                }
+                overflowed = true;
+                if constexpr (!Ordered){
+                    return false;       // any subset will do, so stop looking
+                }
+                else{
+                    // replace the farthest kept hit. max is small, so a scan is cheaper than a heap.
+                    uint32_t farthest = 0;
+                    for(uint32_t h = 1; h < count; h++){
+                        if (out[h].hitDistance > out[farthest].hitDistance){
+                            farthest = h;
+                        }
+                    }
+                    if (buffer[i].distance < out[farthest].hitDistance){
+                        out[farthest] = Hit(buffer[i]);
+                    }
+                }
+            }
+            return true;
+        }
+
+        void finalizeQuery() override{
+            if constexpr (Ordered){
+                std::sort(out, out + count, [](const Hit& a, const Hit& b){
+                    return a.hitDistance < b.hitDistance;
+                });
+            }
+        }
+    };
+}
+
+template<typename T>
+void PhysicsSolver::ParallelChunks(uint32_t count, const T& func){
+    // each chunk holds the scene read lock only while it runs. The caller may help the executor below, which can run
+    // the physics step's tasks, and those take the write lock.
+    auto chunk = [this, &func](uint32_t begin, uint32_t end){
+        scene->lockRead();
+        func(begin, end);
+        scene->unlockRead();
+    };
+    auto& executor = GetApp()->executor;
+    const auto nchunks = std::min<uint32_t>(executor.num_workers(), (count + min_query_chunk - 1) / min_query_chunk);
+    if (nchunks <= 1){
+        chunk(0, count);
+        return;
+    }
+    const auto chunkSize = (count + nchunks - 1) / nchunks;
+    std::atomic<uint32_t> remaining = nchunks - 1;
+    for(uint32_t c = 1; c < nchunks; c++){
+        executor.silent_async([&chunk, &remaining, c, chunkSize, count]{
+            chunk(c * chunkSize, std::min(count, (c + 1) * chunkSize));
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    // the caller takes the first chunk rather than sitting idle
+    chunk(0, chunkSize);
+    if (executor.this_worker_id() >= 0){
+        // a worker that blocked here could starve the chunks it is waiting for, so it runs other tasks instead
+        executor.loop_until([&remaining]{
+            return remaining.load(std::memory_order_acquire) == 0;
+        });
+    }
+    else{
+        while(remaining.load(std::memory_order_acquire) != 0){
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint32_t PhysicsSolver::RaycastBatch(std::span<const RayQuery> rays, std::span<RaycastHit> hits, std::span<BatchResult> results, uint32_t maxHitsPerQuery, const QueryFilter& filter){
+    Debug::Assert(results.size() >= rays.size() && hits.size() >= rays.size() * maxHitsPerQuery, "RaycastBatch buffers are too small for {} rays", rays.size());
+    const auto filterData = SkipRemoved(ToFilterData(filter));
+    std::atomic<uint32_t> total = 0;
+
+    ParallelChunks(uint32_t(rays.size()), [&](uint32_t begin, uint32_t end){
+        uint32_t nhits = 0;
+        for(uint32_t i = begin; i < end; i++){
+            const auto& ray = rays[i];
+            const PxVec3 origin(ray.origin.x, ray.origin.y, ray.origin.z), direction(ray.direction.x, ray.direction.y, ray.direction.z);
+            auto out = hits.data() + size_t(i) * maxHitsPerQuery;
+            if (maxHitsPerQuery == 1){
+                // a single blocking hit lets PhysX shorten the ray as it goes
+                PxRaycastBuffer hit;
+                scene->raycast(origin, direction, ray.maxDistance, hit, PxHitFlag::eDEFAULT, filterData, &skipRemovedBlocks);
+                if (hit.hasBlock){
+                    out[0] = RaycastHit(hit);
+                }
+                results[i] = {hit.hasBlock ? 1u : 0u, false};
+            }
+            else{
+                NearestHits<PxRaycastHit, RaycastHit, true> collector(out, maxHitsPerQuery);
+                scene->raycast(origin, direction, ray.maxDistance, collector, PxHitFlag::eDEFAULT, filterData, &skipRemovedTouches);
+                results[i] = {collector.count, collector.overflowed};
+            }
+            nhits += results[i].nHits;
+        }
+        total.fetch_add(nhits, std::memory_order_relaxed);
+    });
+    return total;
+}
+
+uint32_t PhysicsSolver::SweepBatch(std::span<const SweepQuery> sweeps, std::span<RaycastHit> hits, std::span<BatchResult> results, uint32_t maxHitsPerQuery, const QueryFilter& filter){
+    Debug::Assert(results.size() >= sweeps.size() && hits.size() >= sweeps.size() * maxHitsPerQuery, "SweepBatch buffers are too small for {} sweeps", sweeps.size());
+    const auto filterData = SkipRemoved(ToFilterData(filter));
+    std::atomic<uint32_t> total = 0;
+
+    ParallelChunks(uint32_t(sweeps.size()), [&](uint32_t begin, uint32_t end){
+        uint32_t nhits = 0;
+        for(uint32_t i = begin; i < end; i++){
+            const auto& sweep = sweeps[i];
+            const auto geometry = ToGeometry(sweep.shape);
+            const PxVec3 direction(sweep.direction.x, sweep.direction.y, sweep.direction.z);
+            auto out = hits.data() + size_t(i) * maxHitsPerQuery;
+            if (maxHitsPerQuery == 1){
+                PxSweepBuffer hit;
+                scene->sweep(geometry.any(), ToPose(sweep.shape), direction, sweep.maxDistance, hit, PxHitFlag::eDEFAULT, filterData, &skipRemovedBlocks);
+                if (hit.hasBlock){
+                    out[0] = RaycastHit(hit.block);
+                }
+                results[i] = {hit.hasBlock ? 1u : 0u, false};
+            }
+            else{
+                NearestHits<PxSweepHit, RaycastHit, true> collector(out, maxHitsPerQuery);
+                scene->sweep(geometry.any(), ToPose(sweep.shape), direction, sweep.maxDistance, collector, PxHitFlag::eDEFAULT, filterData, &skipRemovedTouches);
+                results[i] = {collector.count, collector.overflowed};
+            }
+            nhits += results[i].nHits;
+        }
+        total.fetch_add(nhits, std::memory_order_relaxed);
+    });
+    return total;
+}
+
+uint32_t PhysicsSolver::OverlapBatch(std::span<const QueryShape> shapes, std::span<OverlapHit> hits, std::span<BatchResult> results, uint32_t maxHitsPerQuery, const QueryFilter& filter){
+    Debug::Assert(results.size() >= shapes.size() && hits.size() >= shapes.size() * maxHitsPerQuery, "OverlapBatch buffers are too small for {} shapes", shapes.size());
+    const auto filterData = SkipRemoved(ToFilterData(filter));
+    std::atomic<uint32_t> total = 0;
+
+    ParallelChunks(uint32_t(shapes.size()), [&](uint32_t begin, uint32_t end){
+        uint32_t nhits = 0;
+        for(uint32_t i = begin; i < end; i++){
+            const auto geometry = ToGeometry(shapes[i]);
+            NearestHits<PxOverlapHit, OverlapHit, false> collector(hits.data() + size_t(i) * maxHitsPerQuery, maxHitsPerQuery);
+            scene->overlap(geometry.any(), ToPose(shapes[i]), collector, filterData, &skipRemovedTouches);
+            results[i] = {collector.count, collector.overflowed};
+            nhits += collector.count;
+        }
+        total.fetch_add(nhits, std::memory_order_relaxed);
+    });
+    return total;
+}
+
 
 /**
  Make the physics system aware of an object
@@ -195,9 +619,11 @@ void PhysicsSolver::Spawn(PhysicsBodyComponent& actor){
     if (actor.rigidActor->userData == nullptr){
         memcpy(&actor.rigidActor->userData, &e, sizeof(e)); // store the ID inside the userdata variable (NOT a pointer)
     }
-    scene->lockWrite();
-    scene->addActor(*(actor.rigidActor));
-    scene->unlockWrite();
+    {
+        RAIILock lock(pendingLock);
+        pendingAdds.push_back(actor.rigidActor);
+    }
+    bodyGeneration++;
 }
 
 /**
@@ -205,9 +631,63 @@ void PhysicsSolver::Spawn(PhysicsBodyComponent& actor){
  @param e the entity to remove
  */
 void PhysicsSolver::Destroy(PhysicsBodyComponent& body){
+    auto actor = body.rigidActor;
+    {
+        RAIILock lock(pendingLock);
+        if (actor->getScene() == nullptr){
+            // spawned and destroyed between flushes, so it never needs to enter the scene
+            auto it = std::find(pendingAdds.rbegin(), pendingAdds.rend(), actor);
+            if (it != pendingAdds.rend()){
+                pendingAdds.erase(std::next(it).base());
+            }
+            actor->release();
+        }
+        else{
+            actor->userData = removedActorData;
+            pendingRemovals.push_back(actor);
+            nPendingRemovals.store(uint32_t(pendingRemovals.size()), std::memory_order_relaxed);
+        }
+    }
+    {
+        // a step in flight may still record events that name the body, so the destruction is always recorded
+        RAIILock lock(bodyLock);
+        stepPoses.erase(body.GetOwner().id);
+        destroyedSinceFetch.insert(body.GetOwner().id);
+    }
+    bodyGeneration++;
+}
+
+uint32_t PhysicsSolver::FlushActorChanges(){
     scene->lockWrite();
-    scene->removeActor(*(body.rigidActor));
+    uint32_t nchanges = 0;
+    // PhysX ignores actor changes while it simulates, so they stay queued until the step has been fetched
+    if (!stepping.load(std::memory_order_relaxed)){
+        nchanges = ApplyActorChanges();
+    }
     scene->unlockWrite();
+    return nchanges;
+}
+
+uint32_t PhysicsSolver::ApplyActorChanges(){
+    RAIILock lock(pendingLock);
+    const auto nchanges = uint32_t(pendingAdds.size() + pendingRemovals.size());
+    if (nchanges == 0){
+        return 0;
+    }
+    // removals first, so that the broadphase never holds a body and its replacement at once
+    if (!pendingRemovals.empty()){
+        scene->removeActors(pendingRemovals.data(), PxU32(pendingRemovals.size()));
+        for(auto actor : pendingRemovals){
+            actor->release();
+        }
+    }
+    if (!pendingAdds.empty()){
+        scene->addActors(pendingAdds.data(), PxU32(pendingAdds.size()));
+    }
+    pendingAdds.clear();
+    pendingRemovals.clear();
+    nPendingRemovals.store(0, std::memory_order_relaxed);
+    return nchanges;
 }
 
 /**
@@ -215,36 +695,202 @@ void PhysicsSolver::Destroy(PhysicsBodyComponent& body){
  @param deltaTime the scale factor to apply
  */
 void PhysicsSolver::Tick(float scaleFactor){
+    BeginTick(scaleFactor);
+    FinishTick();
+}
 
+void PhysicsSolver::BeginTick(float scaleFactor){
     auto step = scaleFactor / (GetApp()->evalNormal / 2);
 
-    //physics substepping
-    int nsteps = ceil(step / max_step_time);
-    float step_time = step / nsteps;
+    if (fixedStep > 0){
+        accumulator += step;
+        pendingSteps = std::min<int>(accumulator / fixedStep, max_fixed_steps);
+        accumulator -= pendingSteps * fixedStep;
+        if (accumulator >= fixedStep){
+            accumulator = std::fmod(accumulator, fixedStep);     // fell too far behind, drop the excess
+        }
+        pendingStepTime = fixedStep;
+    }
+    else{
+        //physics substepping
+        pendingSteps = ceil(step / max_step_time);
+        pendingStepTime = step / pendingSteps;
+    }
+    
 	scene->lockWrite();
-    for (int i = 0; i < nsteps; i++)
+    ApplyActorChanges();
+    activePoses.clear();
+    // events that were not dispatched since the last Tick are dropped, like the poses
+    events.clear();
+    eventPoints.clear();
     {
-        scene->simulate(step_time);
-        scene->fetchResults(true);      //simulate is async, this blocks until the results have been calculated
+        RAIILock lock(bodyLock);
+        destroyedSinceFetch.clear();
+    }
+    eventStep = 0;
+    if (pendingSteps > 0){
+        stepping.store(true, std::memory_order_relaxed);
+        scene->simulate(pendingStepTime);      //simulate is async, FinishTick collects the results
     }
 	scene->unlockWrite();
 }
 
-//constructor which configures PhysX
-PhysicsSolver::PhysicsSolver(){
-    if (foundation == nullptr){
-        foundation = PxCreateFoundation(PX_PHYSICS_VERSION, gDefaultAllocatorCallback, gDefaultErrorCallback);
+void PhysicsSolver::LockBodies(bool write){
+    while (true){
+        if (write){
+            scene->lockWrite();
+        }
+        else{
+            scene->lockRead();
+        }
+        // stepping only changes under the write lock, so it cannot become true before this lock is released
+        if (!stepping.load(std::memory_order_acquire)){
+            return;
+        }
+        if (write){
+            scene->unlockWrite();
+        }
+        else{
+            scene->unlockRead();
+        }
+        // FinishTick may be queued on this very worker, so it runs other tasks rather than blocking
+        auto& executor = GetApp()->executor;
+        auto finished = [this]{
+            return !stepping.load(std::memory_order_acquire);
+        };
+        if (executor.this_worker_id() >= 0){
+            executor.loop_until(finished);
+        }
+        else{
+            while (!finished()){
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+void PhysicsSolver::FinishTick(){
+    auto& executor = GetApp()->executor;
+    while (pendingSteps > 0){
+        // PhysX's tasks are queued on the same executor, so a worker that blocked here would take a thread away from them
+        // (and with a single worker, never finish). The lock is not held while waiting, so that tasks this worker picks up can take it.
+        if (executor.this_worker_id() >= 0){
+            executor.loop_until([this]{
+                return scene->checkResults(false);
+            });
+        }
+        scene->lockWrite();
+        FetchStep();
+        pendingSteps--;
+        if (pendingSteps > 0){
+            scene->simulate(pendingStepTime);
+        }
+        else{
+            stepping.store(false, std::memory_order_release);
+        }
+        scene->unlockWrite();
+    }
+}
+
+void PhysicsSolver::FetchStep(){
+    scene->fetchResults(true);      //returns immediately if FinishTick already waited; records the step's contact events
+    eventStep++;
+    
+    // PhysX only reports the actors that moved in the most recent step, so collect after each one.
+    // Copying the poses out now means the sync does not need the scene lock or the actors to stay alive.
+    PxU32 nactive = 0;
+    auto active = scene->getActiveActors(nactive);
+    RAIILock lock(bodyLock);
+    for (PxU32 a = 0; a < nactive; a++){
+        if (!HasLiveOwner(active[a])){
+            continue;
+        }
+        Entity owner;
+        memcpy(&owner, &active[a]->userData, sizeof(owner));
+        const auto pose = static_cast<PxRigidActor*>(active[a])->getGlobalPose();
+        activePoses.push_back({owner.id, pose});
+        
+        auto [it, added] = stepPoses.try_emplace(owner.id, StepPoses{pose, pose, stepCount});
+        if (!added){
+            it->second.previous = it->second.current;
+            it->second.current = pose;
+            it->second.step = stepCount;
+        }
+        movedThisStep.push_back(owner.id);
+    }
+    
+    // a body that stopped moving must stop interpolating, so it rests at its current pose. It stays in the list
+    // for one more step, so that whatever was drawn between its last two poses is replaced by the final one.
+    for (const auto owner : movedLastStep){
+        auto it = stepPoses.find(owner);
+        if (it != stepPoses.end() && it->second.step != stepCount){
+            it->second.previous = it->second.current;
+            if (it->second.step + 1 == stepCount){
+                movedThisStep.push_back(owner);
+            }
+        }
+    }
+    std::swap(movedLastStep, movedThisStep);
+    movedThisStep.clear();
+    stepCount++;
+}
+
+void PhysicsSolver::SetFixedStep(float seconds){
+    fixedStep = std::max(seconds, 0.0f);
+    accumulator = 0;
+}
+
+float PhysicsSolver::GetInterpolationFactor() const{
+    return fixedStep > 0 ? accumulator / fixedStep : 1;
+}
+
+bool PhysicsSolver::GetInterpolatedPose(entity_t owner, vector3& pos, quaternion& rot) const{
+    auto it = stepPoses.find(owner);
+    if (it == stepPoses.end()){
+        return false;
     }
-    if (foundation == nullptr){
-		Debug::Fatal("PhysX foundation failed to create");
+    const auto& poses = it->second;
+    const auto alpha = GetInterpolationFactor();
+    const vector3 previousPos{poses.previous.p.x, poses.previous.p.y, poses.previous.p.z}, currentPos{poses.current.p.x, poses.current.p.y, poses.current.p.z};
+    const quaternion previousRot{poses.previous.q.w, poses.previous.q.x, poses.previous.q.y, poses.previous.q.z}, currentRot{poses.current.q.w, poses.current.q.x, poses.current.q.y, poses.current.q.z};
+    pos = glm::mix(previousPos, currentPos, decimalType(alpha));
+    rot = glm::slerp(previousRot, currentRot, decimalType(alpha));
+    return true;
+}
+
+uint32_t PhysicsSolver::SyncActiveActors(){
+    // poses are in step order, so a body that moved in several substeps ends at its latest pose
+    for (const auto& active : activePoses){
+        auto& transform = Entity(active.owner).GetTransform();
+        transform.SetWorldPosition(vector3{active.pose.p.x, active.pose.p.y, active.pose.p.z});
+        transform.SetWorldRotation(quaternion{active.pose.q.w, active.pose.q.x, active.pose.q.y, active.pose.q.z});
+        transform.isPhysicsDirty = false;   // already the body's pose, so PhysicsLinkSystemWrite need not write it back
     }
-    bool recordMemoryAllocations = true;
-    if (pvd == nullptr) {
-        pvd = PxCreatePvd(*foundation);
-        PxPvdTransport* transport = PxDefaultPvdSocketTransportCreate(PVD_HOST, 5425, 10);
-        pvd->connect(*transport, PxPvdInstrumentationFlag::eALL);
+    return activePoses.size();
+}
+
+//constructor which configures PhysX
+PhysicsSolver::PhysicsSolver(){
+    {
+        std::lock_guard lock(staticsMtx);
+        if (foundation == nullptr){
+            foundation = PxCreateFoundation(PX_PHYSICS_VERSION, gDefaultAllocatorCallback, gDefaultErrorCallback);
+        }
+        if (foundation == nullptr){
+            Debug::Fatal("PhysX foundation failed to create");
+        }
         if (phys == nullptr) {
+            if (config.connectPVD) {
+                pvd = PxCreatePvd(*foundation);
+                PxPvdTransport* transport = PxDefaultPvdSocketTransportCreate(config.pvdHost, config.pvdPort, config.pvdTimeoutMilliseconds);
+                pvd->connect(*transport, PxPvdInstrumentationFlag::eALL);
+            }
+            bool recordMemoryAllocations = true;
             phys = PxCreatePhysics(PX_PHYSICS_VERSION, *foundation, PxTolerancesScale(), recordMemoryAllocations, pvd);
+            // initialize extensions (can be omitted, these are optional components)
+            if (!PxInitExtensions(*phys, pvd)){
+                Debug::Fatal("Unable to initialize PhysX");
+            }
         }
     }
 
@@ -257,33 +903,14 @@ PhysicsSolver::PhysicsSolver(){
 
     desc.filterShader = FilterShader;
     desc.simulationEventCallback = this;
+    desc.flags |= PxSceneFlag::eENABLE_ACTIVE_ACTORS;     // so that SyncActiveActors visits only what moved
 	
-	// initialize cooking library with defaults
-	cooking = PxCreateCooking(PX_PHYSICS_VERSION, *foundation, PxCookingParams(PxTolerancesScale()));
-	if (!cooking){
-		Debug::Fatal("PhysX Cooking initialization failed");
-	}
-	
-	// setup cooking parameters (used for all subsequent calls to cooking)
-	PxTolerancesScale scale;
-	PxCookingParams params(scale);
-	// disable mesh cleaning - perform mesh validation on development configurations
-	//params.meshPreprocessParams |= PxMeshPreprocessingFlag::eDISABLE_CLEAN_MESH;
-	// disable edge precompute, edges are set for each triangle, slows contact generation
-	//params.meshPreprocessParams |= PxMeshPreprocessingFlag::eDISABLE_ACTIVE_EDGES_PRECOMPUTE;
-	
-	PhysicsSolver::cooking->setParams(params);
-	
-	// initialize extensions (can be omitted, these are optional components)
-	if (!PxInitExtensions(*phys, pvd)){
-		Debug::Fatal("Unable to initialize PhysX");
-	}
-    
     //create the scene
     scene = phys->createScene(desc);
     if (!scene) {
 		Debug::Fatal("PhysX Scene failed to create");
     }
+    scene->userData = this;     // so that bodies can find their solver from their actor
 }
 
 PhysicsSolver::RaycastHit::RaycastHit(const physx::PxRaycastBuffer& hit) : 
@@ -297,7 +924,33 @@ PhysicsSolver::RaycastHit::RaycastHit(const physx::PxRaycastBuffer& hit) :
     }
 }
 
+PhysicsSolver::RaycastHit::RaycastHit(const physx::PxLocationHit& hit, const physx::PxRigidActor* actor) :
+    hasBlocking(true),
+    hitPosition(vector3(hit.position.x, hit.position.y, hit.position.z)),
+    hitNormal(vector3(hit.normal.x, hit.normal.y, hit.normal.z)),
+    hitDistance(hit.distance),
+    hitObject(entity_t(uintptr_t(actor->userData))) {}
+
+PhysicsSolver::RaycastHit::RaycastHit(const physx::PxRaycastHit& hit) : RaycastHit(hit, hit.actor) {}
+
+PhysicsSolver::RaycastHit::RaycastHit(const physx::PxSweepHit& hit) : RaycastHit(hit, hit.actor) {}
+
 Entity RavEngine::PhysicsSolver::RaycastHit::getEntity() const
 {
     return Entity(hitObject);
 }
+
+PhysicsSolver::OverlapHit::OverlapHit(const physx::PxOverlapBuffer& hit) : hasBlocking(hit.hasBlock) {
+    if (hit.hasBlock) {
+        overlapObject = entity_t(uintptr_t(hit.block.actor->userData));
+    }
+}
+
+PhysicsSolver::OverlapHit::OverlapHit(const physx::PxOverlapHit& hit) :
+    hasBlocking(true),
+    overlapObject(entity_t(uintptr_t(hit.actor->userData))) {}
+
+Entity RavEngine::PhysicsSolver::OverlapHit::getEntity() const
+{
+    return Entity(overlapObject);
+}
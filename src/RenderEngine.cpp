@@ -910,7 +910,7 @@ RenderEngine::RenderEngine(const AppConfig& config) {
 		{{10, 10}},
 		{{-10, 10}}
 	};
-	screenTriVerts = device->CreateBuffer({
+	screenTriVerts = CreateBuffer({
 		   {.VertexBuffer = true},
 		   sizeof(Vertex2D),
 		   vertices,
@@ -920,14 +920,14 @@ RenderEngine::RenderEngine(const AppConfig& config) {
 
 	auto pointLightMeshData = genIcosphere(2);
 
-	pointLightVertexBuffer = device->CreateBuffer({
+	pointLightVertexBuffer = CreateBuffer({
 		uint32_t(pointLightMeshData.Positions.size()),
 		{.VertexBuffer = true},
 		sizeof(float) * 3,
 		RGL::BufferAccess::Private
 	});
 
-	pointLightIndexBuffer = device->CreateBuffer({
+	pointLightIndexBuffer = CreateBuffer({
 		uint32_t(pointLightMeshData.TriangleIndices.size()),
 		{.IndexBuffer = true},
 		sizeof(uint32_t),
@@ -940,14 +940,14 @@ RenderEngine::RenderEngine(const AppConfig& config) {
 
 	auto coneMesh = generateCone(1, 1, 16);
 
-	spotLightVertexBuffer = device->CreateBuffer({
+	spotLightVertexBuffer = CreateBuffer({
 		uint32_t(coneMesh.verts.size()),
 		{.VertexBuffer = true},
 		sizeof(float) * 3,
 		RGL::BufferAccess::Private
 	});
 
-	spotLightIndexBuffer = device->CreateBuffer({
+	spotLightIndexBuffer = CreateBuffer({
 		uint32_t(coneMesh.indices.size()),
 		{.IndexBuffer = true},
 		sizeof(uint16_t),
@@ -1143,7 +1143,7 @@ void RavEngine::RenderEngine::createGBuffers()
 	gcTextures.enqueue(normalTexture);
 	gcTextures.enqueue(lightingTexture);
 
-	depthStencil = device->CreateTexture({
+	depthStencil = CreateTexture({
 		.usage = { .Sampled = true, .DepthStencilAttachment = true },
 		.aspect = { .HasDepth = true },
 		.width = width,
@@ -1152,7 +1152,7 @@ void RavEngine::RenderEngine::createGBuffers()
 		.debugName = "Depth Texture"
 		}
 	);
-	diffuseTexture = device->CreateTexture({
+	diffuseTexture = CreateTexture({
 		.usage = { .Sampled = true, .ColorAttachment = true },
 		.aspect = { .HasColor = true },
 		.width = width,
@@ -1162,7 +1162,7 @@ void RavEngine::RenderEngine::createGBuffers()
 		.debugName = "Color gbuffer"
 		}
 	);
-	normalTexture = device->CreateTexture({
+	normalTexture = CreateTexture({
 		.usage = { .Sampled = true, .ColorAttachment = true },
 		.aspect = { .HasColor = true },
 		.width = width,
@@ -1172,7 +1172,7 @@ void RavEngine::RenderEngine::createGBuffers()
 		.debugName = "Normal gbuffer"
 		}
 	);
-	lightingTexture = device->CreateTexture({
+	lightingTexture = CreateTexture({
 		.usage = { .Sampled = true, .ColorAttachment = true },
 		.aspect = { .HasColor = true },
 		.width = width,
@@ -1204,6 +1204,43 @@ RavEngine::RenderEngine::~RenderEngine()
 	device->BlockUntilIdle();
 }
 
+RGLBufferPtr RenderEngine::CreateBuffer(const RGL::BufferConfig& config, MemoryTag tag){
+	return CreateBuffer(*device, config, tag);
+}
+
+RGLTexturePtr RenderEngine::CreateTexture(const RGL::TextureConfig& config, MemoryTag tag){
+	return CreateTexture(*device, config, tag);
+}
+
+RGLTexturePtr RenderEngine::CreateTextureWithData(const RGL::TextureConfig& config, RGL::untyped_span data, MemoryTag tag){
+	return CreateTextureWithData(*device, config, data, tag);
+}
+
+size_t RenderEngine::EstimateTextureSize(const RGL::TextureConfig& config){
+	size_t bytesPerPixel = 4;
+	switch(config.format){
+		case RGL::TextureFormat::RGBA16_Unorm:
+		case RGL::TextureFormat::RGBA16_Snorm:
+		case RGL::TextureFormat::RGBA16_Sfloat:
+			bytesPerPixel = 8;
+			break;
+		case RGL::TextureFormat::RGBA32_Sfloat:
+			bytesPerPixel = 16;
+			break;
+		default:
+			break;
+	}
+	size_t total = 0;
+	uint32_t width = config.width, height = config.height, depth = config.depth;
+	for(uint32_t mip = 0; mip < std::max(config.mipLevels, 1u); mip++){
+		total += size_t(width) * height * depth * bytesPerPixel;
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+		depth = std::max(depth / 2, 1u);
+	}
+	return total * std::max(config.arrayLayers, 1u);
+}
+
 void RenderEngine::DestroyUnusedResources() {
 	// deallocate the resources that have been freed
 
@@ -151,7 +151,7 @@ namespace RavEngine {
 	{
 		auto oldBuffer = reallocBuffer;
 		// trash old buffer
-		reallocBuffer = device->CreateBuffer({
+		reallocBuffer = CreateBuffer({
 			newSize,
 			bufferType,
 			stride,
@@ -117,7 +117,7 @@ namespace RavEngine {
 						if (buffer) {
 							gcBuffers.enqueue(buffer);
 						}
-						buffer = device->CreateBuffer({
+						buffer = CreateBuffer({
 							size_count,
 							type,
 							stride,
@@ -271,7 +271,7 @@ namespace RavEngine {
 				if (newSize == 0) {
 					return;
 				}
-				buffer = device->CreateBuffer({
+				buffer = CreateBuffer({
 					newSize,
 					type,
 					stride,
@@ -652,7 +652,7 @@ void RavEngine::RenderEngine::DebugRender(const Im3d::DrawList& drawList)
 	const Im3d::VertexData* vertexdata = drawList.m_vertexData;
 	const auto nverts = drawList.m_vertexCount;
 
-	auto vertBuffer = device->CreateBuffer({
+	auto vertBuffer = CreateBuffer({
 		uint32_t(nverts),
 		{.VertexBuffer = true},
 		sizeof(Im3d::VertexData),
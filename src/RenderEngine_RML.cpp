@@ -61,7 +61,7 @@ static inline Rml::TextureHandle createTexture(uint32_t width, uint32_t height,
 
 	auto uncompressed_size = width * height * numChannels * numLayers;
 	
-	auto th = device->CreateTextureWithData(
+	auto th = GetApp()->GetRenderEngine().CreateTextureWithData(
 		{
 			.usage = {.TransferDestination = true, .Sampled = true},
 			.aspect {.HasColor = true},
@@ -97,14 +97,14 @@ void RenderEngine::GetClipboardText(Rml::String &text){
 /// Called by RmlUi when it wants to render geometry that it does not wish to optimise.
 void RenderEngine::RenderGeometry(Rml::Vertex* vertices, int num_vertices, int* indices, int num_indices, Rml::TextureHandle texture, const Rml::Vector2f& translation) {
 
-	auto vbuf = device->CreateBuffer({
+	auto vbuf = CreateBuffer({
 		 uint32_t(num_vertices),
 		{.VertexBuffer = true},
 		sizeof(Rml::Vertex),
 		RGL::BufferAccess::Private
 		});
 
-	auto ibuf = device->CreateBuffer({
+	auto ibuf = CreateBuffer({
 		 uint32_t(num_indices),
 		{.IndexBuffer = true},
 		sizeof(int),
@@ -142,14 +142,14 @@ void RenderEngine::RenderGeometry(Rml::Vertex* vertices, int num_vertices, int*
 
 /// Called by RmlUi when it wants to compile geometry it believes will be static for the forseeable future.
 Rml::CompiledGeometryHandle RenderEngine::CompileGeometry(Rml::Vertex* vertices, int num_vertices, int* indices, int num_indices, Rml::TextureHandle texture){
-	auto vbuf = device->CreateBuffer({
+	auto vbuf = CreateBuffer({
 		 uint32_t(num_vertices),
 		{.VertexBuffer = true},
 		sizeof(Rml::Vertex),
 		RGL::BufferAccess::Private
 	});
 
-	auto ibuf = device->CreateBuffer({
+	auto ibuf = CreateBuffer({
 		 uint32_t(num_indices),
 		{.IndexBuffer = true},
 		sizeof(int),
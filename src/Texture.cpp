@@ -82,8 +82,7 @@ void Texture::CreateTexture(int width, int height, bool hasMipMaps, int numlayer
 	
 	uint32_t uncompressed_size = width * height * numChannels * numlayers;
 
-	auto device = GetApp()->GetRenderEngine().GetDevice();
-	texture = device->CreateTextureWithData({
+	texture = GetApp()->GetRenderEngine().CreateTextureWithData({
 		.usage = {.TransferDestination = true, .Sampled = true},
 		.aspect = {.HasColor = true},
 		.width = uint32_t(width),
@@ -0,0 +1,156 @@
+#include "TimerWheel.hpp"
+#include "Debug.hpp"
+#include <cmath>
+#include <algorithm>
+
+using namespace RavEngine;
+using namespace std;
+
+TimerWheel::TimerWheel(double resolutionSeconds) : resolution(resolutionSeconds){
+    Debug::Assert(resolutionSeconds > 0, "Timer resolution must be positive");
+    slotHeads.fill(npos);
+}
+
+TimerWheel::Handle TimerWheel::Schedule(double time, const callback_t& func){
+    auto index = AllocateNode();
+    auto& node = nodes[index];
+    node.func = func;
+    // round up so that a timer never fires before its time
+    node.expiry = std::max(static_cast<uint64_t>(std::max(std::ceil(time / resolution), 0.0)), nextTick);
+    Place(index);
+    pendingCount++;
+    return Handle{index, node.generation};
+}
+
+bool TimerWheel::Cancel(Handle handle){
+    if (!IsPending(handle)){
+        return false;
+    }
+    Unlink(handle.index);
+    FreeNode(handle.index);
+    pendingCount--;
+    return true;
+}
+
+bool TimerWheel::IsPending(Handle handle) const{
+    return handle.index < nodes.size() && nodes[handle.index].generation == handle.generation && nodes[handle.index].slot != npos;
+}
+
+void TimerWheel::Advance(double time, Vector<callback_t>& expired){
+    const auto target = static_cast<uint64_t>(std::max(std::floor(time / resolution), 0.0));
+    while (nextTick <= target){
+        if (pendingCount == 0){
+            nextTick = target + 1;
+            break;
+        }
+
+        const auto index = static_cast<uint32_t>(nextTick & slot_mask);
+        if (index == 0){
+            Cascade(1);
+        }
+
+        // everything in the current level 0 slot is due
+        auto current = slotHeads[index];
+        slotHeads[index] = npos;
+        while (current != npos){
+            auto& node = nodes[current];
+            auto next = node.next;
+            expired.push_back(std::move(node.func));
+            node.slot = npos;
+            levelCounts[0]--;
+            pendingCount--;
+            FreeNode(current);
+            current = next;
+        }
+        nextTick++;
+
+        // nothing can fire before the next cascade if level 0 is empty
+        if (levelCounts[0] == 0){
+            const uint64_t boundary = (nextTick + slot_mask) & ~uint64_t(slot_mask);
+            nextTick = std::min(boundary, target + 1);
+        }
+    }
+}
+
+uint32_t TimerWheel::AllocateNode(){
+    if (freeHead != npos){
+        auto index = freeHead;
+        freeHead = nodes[index].next;
+        nodes[index].next = npos;
+        return index;
+    }
+    nodes.emplace_back();
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void TimerWheel::FreeNode(uint32_t index){
+    auto& node = nodes[index];
+    node.func = nullptr;
+    node.generation++;      // invalidate outstanding handles
+    node.slot = npos;
+    node.prev = npos;
+    node.next = freeHead;
+    freeHead = index;
+}
+
+void TimerWheel::Place(uint32_t index){
+    auto& node = nodes[index];
+    uint64_t delta = node.expiry - nextTick;
+
+    // timers beyond the range of the top level park at its far end and are re-placed when cascaded
+    constexpr uint64_t max_delta = (uint64_t(1) << (slot_bits * n_levels)) - 1;
+    uint64_t when = node.expiry;
+    if (delta > max_delta){
+        delta = max_delta;
+        when = nextTick + max_delta;
+    }
+
+    uint32_t level = 0;
+    while (level < n_levels - 1 && delta >= (uint64_t(1) << (slot_bits * (level + 1)))){
+        level++;
+    }
+    const auto slot = level * slots_per_level + static_cast<uint32_t>((when >> (slot_bits * level)) & slot_mask);
+
+    node.slot = slot;
+    node.prev = npos;
+    node.next = slotHeads[slot];
+    if (node.next != npos){
+        nodes[node.next].prev = index;
+    }
+    slotHeads[slot] = index;
+    levelCounts[level]++;
+}
+
+void TimerWheel::Unlink(uint32_t index){
+    auto& node = nodes[index];
+    if (node.prev == npos){
+        slotHeads[node.slot] = node.next;
+    }
+    else{
+        nodes[node.prev].next = node.next;
+    }
+    if (node.next != npos){
+        nodes[node.next].prev = node.prev;
+    }
+    levelCounts[node.slot / slots_per_level]--;
+    node.slot = npos;
+    node.prev = npos;
+    node.next = npos;
+}
+
+void TimerWheel::Cascade(uint32_t level){
+    // called when the lower levels have wrapped around, move the current slot of this level down
+    const auto index = static_cast<uint32_t>((nextTick >> (slot_bits * level)) & slot_mask);
+    const auto slot = level * slots_per_level + index;
+    auto current = slotHeads[slot];
+    slotHeads[slot] = npos;
+    while (current != npos){
+        auto next = nodes[current].next;
+        levelCounts[level]--;
+        Place(current);
+        current = next;
+    }
+    if (index == 0 && level + 1 < n_levels){
+        Cascade(level + 1);
+    }
+}
@@ -30,6 +30,7 @@
 #include "PhysicsSolver.hpp"
 #include "VRAMSparseSet.hpp"
 #include "PhysicsBodyComponent.hpp"
+#include "FrameAllocator.hpp"
 
 using namespace std;
 using namespace RavEngine;
@@ -65,12 +66,13 @@ RavEngine::World::World() : Solver(std::make_unique<PhysicsSolver>()){
     EmplaceSystem<AnimatorSystem>();
 	EmplaceSystem<SocketSystem>();
     CreateDependency<AnimatorSystem,ScriptSystem>();			// run scripts before animations
-    CreateDependency<AnimatorSystem,PhysicsLinkSystemRead>();	// run physics reads before animator
-    CreateDependency<PhysicsLinkSystemWrite,ScriptSystem>();	// run physics write before scripts
+    systemRecords.at(CTTI<AnimatorSystem>()).execute.succeed(physicsSyncTask);	// run physics reads before animator
+    physicsWriteTask.succeed(systemRecords.at(CTTI<ScriptSystem>()).execute);	// run physics write after scripts
 	CreateDependency<SocketSystem, AnimatorSystem>();			// run animator before socket system
         
     EmplaceSystem<AudioRoomSyncSystem>();
     EmplaceSystem<RPCSystem>();
+    audioTaskModule.succeed(systemRecords.at(CTTI<AudioRoomSyncSystem>()).execute, systemRecords.at(CTTI<RPCSystem>()).execute);	// rooms and RPCs before the audio snapshot
     if (PHYSFS_isInit()){
         skybox = make_shared<Skybox>();
     }
@@ -112,8 +114,13 @@ void RavEngine::World::TickECS(float fpsScale) {
 	//update time
 	time_now = e_clock_t::now();
 	
+	PlanSystemSchedule();
+	
 	//execute and wait
     GetApp()->executor.run(masterTasks).wait();
+    
+    // all per-frame scratch memory is dead now, recycle it
+    FrameArena::EndFrame();
 	if (isRendering){
 		newFrame = true;
 	}
@@ -132,33 +139,33 @@ bool RavEngine::World::InitPhysics() {
 void World::SetupTaskGraph(){
     masterTasks.name("RavEngine Master Tasks");
 	
-    //TODO: FIX (use conditional tasking here)
     setupRenderTasks();
     
     ECSTasks.name("ECS");
     ECSTaskModule = masterTasks.composed_of(ECSTasks).name("ECS");
     
-    // ensure Systems run before rendering
-    renderTaskModule.succeed(ECSTaskModule);
+    // ensure Systems run before rendering, and skip rendering if the world has no render data (headless)
+    auto checkRender = masterTasks.emplace([this]{
+        return renderData ? 0 : 1;
+    }).name("Check render");
+    checkRender.succeed(ECSTaskModule);
+    checkRender.precede(renderTaskModule);
     
     // process any dispatched coroutines
-    auto updateAsyncIterators = ECSTasks.emplace([&]{
-        async_begin = async_tasks.begin();
-        async_end = async_tasks.end();
-    }).name("async iterator update");
-    auto doAsync = ECSTasks.for_each(std::ref(async_begin), std::ref(async_end), [&](const shared_ptr<dispatched_func>& item){
-        if (GetApp()->GetCurrentTime() >= item->runAtTime){
-            item->func();
-            ranFunctions.push_back(async_tasks.hash_for(item));
+    auto advanceAsyncTimers = ECSTasks.emplace([this]{
+        {
+            RAIILock lock(asyncTimersLock);
+            asyncTimers.Advance(GetApp()->GetCurrentTime(), expiredAsync);
         }
+        async_begin = expiredAsync.begin();
+        async_end = expiredAsync.end();
+    }).name("Advance async timers");
+    auto doAsync = ECSTasks.for_each(std::ref(async_begin), std::ref(async_end), [](const TimerWheel::callback_t& func){
+        func();
     }).name("Exec Async");
-    updateAsyncIterators.precede(doAsync);
-    auto cleanupRanAsync = ECSTasks.emplace([&]{
-        // remove functions that have been run
-        for(const auto hash : ranFunctions){
-            async_tasks.erase_by_hash(hash);
-        }
-        ranFunctions.clear();
+    advanceAsyncTimers.precede(doAsync);
+    auto cleanupRanAsync = ECSTasks.emplace([this]{
+        expiredAsync.clear();
     }).name("Async cleanup");
     doAsync.precede(cleanupRanAsync);
     
@@ -166,37 +173,51 @@ void World::SetupTaskGraph(){
 
 	auto physicsRootTask = ECSTasks.emplace([] {}).name("PhysicsRootTask");
 
+	// simulate returns right away and fetch helps the executor while it waits, so Systems that are not ordered
+	// against physics (and PhysX's own tasks) run during the step. Such Systems may run scene queries. Reading or
+	// writing a body waits until the step has been fetched, so a System must not touch bodies if fetch depends on it.
 	auto RunPhysics = ECSTasks.emplace([this]{
-		Solver->Tick(GetCurrentFPSScale());
-	}).name("PhysX Execute");
+		Solver->BeginTick(GetCurrentFPSScale());
+	}).name("PhysX Simulate");
+	auto FetchPhysics = ECSTasks.emplace([this]{
+		Solver->FinishTick();
+	}).name("PhysX Fetch");
+	RunPhysics.precede(FetchPhysics);
     
-    auto read = EmplaceSystem<PhysicsLinkSystemRead>();
-    auto write = EmplaceSystem<PhysicsLinkSystemWrite>();
-    RunPhysics.precede(read.second);
-    RunPhysics.succeed(write.second);
+    // only the bodies PhysX reports as having moved are copied back, so sleeping bodies cost nothing.
+    // Contact and trigger events are delivered after the Transforms are up to date.
+    physicsSyncTask = ECSTasks.emplace([this]{
+        Solver->SyncActiveActors();
+        Solver->DispatchEvents();
+    }).name("PhysX Sync");
+    // static and kinematic bodies follow their Transforms, written in one batch before the step
+    physicsWriteTask = ECSTasks.emplace([this, write = PhysicsLinkSystemWrite()]() mutable {
+        write(*this);
+    }).name("PhysX Write");
+    FetchPhysics.precede(physicsSyncTask);
+    RunPhysics.succeed(physicsWriteTask);
 	
-    physicsRootTask.precede(read.first,write.first);
-	read.second.succeed(RunPhysics);	// if checkRunPhysics returns a 1, it goes here anyways.
+    physicsRootTask.precede(physicsWriteTask);
     
     // setup audio tasks
     audioTasks.name("Audio");
     
-    auto audioClear = audioTasks.emplace([this]{
-        GetApp()->GetCurrentAudioSnapshot()->Clear();
+    // the snapshot persists between ticks, so each task only reports what it finds and the publisher works out what changed
+    auto audioBegin = audioTasks.emplace([this]{
+        auto& snapshots = GetApp()->GetAudioSnapshotPublisher();
+        snapshots.BeginUpdate();
         //TODO: currently this selects the LAST listener, but there is no need for this
-        Filter([](const AudioListener& listener, const Transform& transform){
-            auto ptr = GetApp()->GetCurrentAudioSnapshot();
-            ptr->listenerPos = transform.GetWorldPosition();
-            ptr->listenerRot = transform.GetWorldRotation();
-            ptr->listenerGraph = listener.GetGraph();
+        Filter([&snapshots](const AudioListener& listener, const Transform& transform){
+            snapshots.SetListener(transform.GetWorldPosition(), transform.GetWorldRotation(), listener.GetGraph());
         });
-    }).name("Clear + Listener");
+    }).name("Begin + Listener");
     
   
     
     auto copyAudios = audioTasks.emplace([this]{
-        Filter([this](AudioSourceComponent& audioSource, const Transform& transform){
-            GetApp()->GetCurrentAudioSnapshot()->sources.emplace(audioSource.GetPlayer(),transform.GetWorldPosition(),transform.GetWorldRotation());
+        auto& snapshots = GetApp()->GetAudioSnapshotPublisher();
+        Filter([&snapshots](AudioSourceComponent& audioSource, const Transform& transform){
+            snapshots.UpdateSource(audioSource.GetPlayer(),transform.GetWorldPosition(),transform.GetWorldRotation());
         });
         
         // now clean up the fire-and-forget audios that have completed
@@ -206,14 +227,15 @@ void World::SetupTaskGraph(){
         
         // now do fire-and-forget audios that need to play
         for(auto& f : instantaneousToPlay){
-            GetApp()->GetCurrentAudioSnapshot()->sources.emplace(f.GetPlayer(),f.source_position,quaternion(0,0,0,1));
+            snapshots.UpdateSource(f.GetPlayer(),f.source_position,quaternion(0,0,0,1));
         }
-    }).name("Point Audios").succeed(audioClear);
+    }).name("Point Audios").succeed(audioBegin);
     
     auto copyAmbients = audioTasks.emplace([this]{
+        auto& snapshots = GetApp()->GetAudioSnapshotPublisher();
         // raster audio
-        Filter([this](AmbientAudioSourceComponent& audioSource){
-            GetApp()->GetCurrentAudioSnapshot()->ambientSources.emplace(audioSource.GetPlayer());
+        Filter([&snapshots](AmbientAudioSourceComponent& audioSource){
+            snapshots.UpdateAmbientSource(audioSource.GetPlayer());
         });
 
         // now clean up the fire-and-forget audios that have completed
@@ -223,24 +245,29 @@ void World::SetupTaskGraph(){
         
         // now do fire-and-forget audios that need to play
         for(auto& f : ambientToPlay){
-            GetApp()->GetCurrentAudioSnapshot()->ambientSources.emplace(f.GetPlayer());
+            snapshots.UpdateAmbientSource(f.GetPlayer());
         }
         
-    }).name("Ambient Audios").succeed(audioClear);
+    }).name("Ambient Audios").succeed(audioBegin);
     
     auto copyRooms = audioTasks.emplace([this]{
-        Filter( [this](AudioRoom& room, Transform& transform){
-            GetApp()->GetCurrentAudioSnapshot()->rooms.emplace_back(room.data,transform.GetWorldPosition(),transform.GetWorldRotation());
+        auto& snapshots = GetApp()->GetAudioSnapshotPublisher();
+        Filter( [&snapshots](AudioRoom& room, Transform& transform){
+            snapshots.UpdateRoom(room.data,transform.GetWorldPosition(),transform.GetWorldRotation());
         });
         
-    }).name("Rooms").succeed(audioClear);
+    }).name("Rooms").succeed(audioBegin);
     
-    auto audioSwap = audioTasks.emplace([]{
-        GetApp()->SwapCurrrentAudioSnapshot();
-    }).name("Swap Current").succeed(copyAudios,copyAmbients,copyRooms);
+    auto audioPublish = audioTasks.emplace([]{
+        GetApp()->GetAudioSnapshotPublisher().EndUpdate();
+    }).name("Publish").succeed(copyAudios,copyAmbients,copyRooms);
     
-    audioTaskModule = masterTasks.composed_of(audioTasks).name("Audio");
-    audioTaskModule.succeed(ECSTaskModule);
+    // the snapshot only reads Transforms and never touches bodies, so it runs while PhysX steps. It waits for the
+    // body write (and so for scripts), async callbacks, room sync and RPCs, and is done before Sync, Animator and Socket
+    // write Transforms. Physics-driven sources are reported at their pre-step position, one tick behind their bodies.
+    // As for PhysX Write, user Systems not ordered against it must not write the Transforms of sources or listeners.
+    audioTaskModule = ECSTasks.composed_of(audioTasks).name("Audio");
+    audioTaskModule.succeed(physicsWriteTask, cleanupRanAsync).precede(physicsSyncTask);
 }
 
 void World::setupRenderTasks(){
@@ -311,6 +338,23 @@ void World::setupRenderTasks(){
     
     resizeBuffer.precede(updateRenderDataStaticMesh, updateRenderDataSkinnedMesh);
     
+    // with a fixed physics step, draw moving bodies between their last two steps. Only the render matrices change, the Transforms keep the latest step.
+    auto interpolatePhysics = renderTasks.emplace([this]{
+        if (Solver->GetInterpolationFactor() >= 1){
+            return;
+        }
+        for(const auto owner : Solver->GetInterpolatingBodies()){
+            vector3 pos;
+            quaternion rot;
+            if (!Solver->GetInterpolatedPose(owner, pos, rot)){
+                continue;
+            }
+            Entity e(owner);
+            renderData->worldTransforms[e.GetIdInWorld()] = glm::translate(matrix4(1), pos) * glm::toMat4(rot) * glm::scale(matrix4(1), e.GetTransform().GetLocalScale());
+        }
+    }).name("Interpolate physics transforms");
+    interpolatePhysics.succeed(updateRenderDataStaticMesh, updateRenderDataSkinnedMesh);
+    
     auto updateInvalidatedDirs = renderTasks.emplace([this]{
         if (auto ptr = GetAllComponentsOfType<DirectionalLight>()){
             for(int i = 0; i < ptr->DenseSize(); i++){
@@ -408,11 +452,125 @@ void World::setupRenderTasks(){
     renderTaskModule = masterTasks.composed_of(renderTasks).name("Render");
 }
 
-void World::DispatchAsync(const Function<void ()>& func, double delaySeconds){
+void World::PlanSystemSchedule(){
+    const auto& config = systemSchedulingConfig;
+    SystemRecord* leader = nullptr;
+    double batchMicros = 0;
+    for(const auto id : systemOrder){
+        auto& record = systemRecords.at(id);
+        record.fusedBatch.clear();
+        record.runByBatchLeader = false;
+        
+        // only Systems with no ordering constraints may run inside another System's task.
+        // prepare has predecessors for timed Systems and physics link Systems,
+        // execute has more than one predecessor or any successor if CreateDependency was used.
+        const bool independent = record.prepare.num_dependents() == 0 && record.execute.num_dependents() == 1 && record.execute.num_successors() == 0;
+        const bool tiny = record.sampled && record.stats.avgMicros < config.fuseThresholdMicros;
+        if (!config.adaptive || !independent || !tiny){
+            continue;
+        }
+        
+        // a batch should still be cheaper than a System that is worth parallelizing
+        if (leader != nullptr && batchMicros + record.stats.avgMicros < config.serialThresholdMicros){
+            leader->fusedBatch.push_back(&record);
+            record.runByBatchLeader = true;
+            batchMicros += record.stats.avgMicros;
+        }
+        else{
+            leader = &record;
+            batchMicros = record.stats.avgMicros;
+        }
+    }
+}
+
+void World::RunSystem(SystemRecord& record, tf::Subflow* subflow){
+    const auto& config = systemSchedulingConfig;
+    auto& stats = record.stats;
+    const auto count = record.getCount();
+    
+    stats.lastFused = subflow == nullptr;
+    stats.lastEntityCount = count;
+    
+    const auto nworkers = GetApp()->executor.num_workers();
+    const pos_t maxChunks = std::max<pos_t>(1, nworkers * config.maxChunksPerWorker);
+    
+    // decide the chunk size for this tick
+    pos_t chunkSize = count;
+    if (subflow != nullptr && nworkers > 1 && count > 1){
+        if (!config.adaptive){
+            chunkSize = 1;
+        }
+        else if (!record.hasCostHistory){
+            // no cost model yet, split evenly
+            chunkSize = (count + maxChunks - 1) / maxChunks;
+        }
+        else{
+            const auto estimatedMicros = stats.avgNanosPerEntity * count / 1000.0;
+            if (estimatedMicros >= config.serialThresholdMicros){
+                const auto perChunk = static_cast<pos_t>(std::max(1.0, config.targetChunkMicros * 1000.0 / std::max(stats.avgNanosPerEntity, 1.0)));
+                const pos_t minChunkSize = (count + maxChunks - 1) / maxChunks;
+                chunkSize = std::max(perChunk, minChunkSize);
+            }
+        }
+    }
+    
+    uint64_t workNanos = 0;
+    if (count == 0){
+        stats.lastChunkCount = 0;
+    }
+    else if (chunkSize >= count){
+        auto begin = e_clock_t::now();
+        record.runRange(0, count);
+        workNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(e_clock_t::now() - begin).count();
+        stats.lastChunkCount = 1;
+    }
+    else if (!config.adaptive){
+        auto begin = e_clock_t::now();
+        subflow->for_each_index(pos_t(0), count, pos_t(1), [&record](pos_t i){
+            record.runRange(i, i + 1);
+        });
+        subflow->join();
+        workNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(e_clock_t::now() - begin).count();  // wall time, the cost model is unused in this mode
+        stats.lastChunkCount = count;
+    }
+    else{
+        std::atomic<uint64_t> totalNanos = 0;
+        pos_t nchunks = 0;
+        for(pos_t begin = 0; begin < count; begin += chunkSize){
+            const pos_t end = std::min(count, begin + chunkSize);
+            subflow->emplace([&record, &totalNanos, begin, end]{
+                auto start = e_clock_t::now();
+                record.runRange(begin, end);
+                totalNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(e_clock_t::now() - start).count(), std::memory_order_relaxed);
+            });
+            nchunks++;
+        }
+        subflow->join();
+        workNanos = totalNanos.load(std::memory_order_relaxed);
+        stats.lastChunkCount = nchunks;
+    }
+    
+    // update the moving averages. The first sample replaces the initial values.
+    const double alpha = record.sampled ? config.smoothing : 1.0;
+    stats.avgMicros += alpha * (workNanos / 1000.0 - stats.avgMicros);
+    stats.avgEntityCount += alpha * (count - stats.avgEntityCount);
+    if (count > 0){
+        const double costAlpha = record.hasCostHistory ? config.smoothing : 1.0;
+        stats.avgNanosPerEntity += costAlpha * (static_cast<double>(workNanos) / count - stats.avgNanosPerEntity);
+        record.hasCostHistory = true;
+    }
+    record.sampled = true;
+}
+
+TimerWheel::Handle World::DispatchAsync(const Function<void ()>& func, double delaySeconds){
     auto time = GetApp()->GetCurrentTime();
-    GetApp()->DispatchMainThread([=]{
-        async_tasks.insert(make_shared<dispatched_func>(time + delaySeconds,func));
-    });
+    RAIILock lock(asyncTimersLock);
+    return asyncTimers.Schedule(time + delaySeconds, func);
+}
+
+bool World::CancelAsync(TimerWheel::Handle handle){
+    RAIILock lock(asyncTimersLock);
+    return asyncTimers.Cancel(handle);
 }
 
 void RavEngine::World::updateStaticMeshMaterial(entity_t localId, decltype(RenderData::staticMeshRenderData)::key_type oldMat, decltype(RenderData::staticMeshRenderData)::key_type newMat, Ref<MeshAsset> mesh)
@@ -0,0 +1,434 @@
+#include <RavEngine/AudioMixing.hpp>
+#include <RavEngine/AudioVoiceManager.hpp>
+#include <RavEngine/AudioSource.hpp>
+#include <RavEngine/DiskCache.hpp>
+#include <RavEngine/AudioGraphAsset.hpp>
+#include <RavEngine/AudioRoom.hpp>
+#include <RavEngine/AudioRoomRenderer.hpp>
+#include <RavEngine/AudioSnapshot.hpp>
+#include <RavEngine/Debug.hpp>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <filesystem>
+
+using namespace RavEngine;
+using namespace std;
+
+static std::chrono::steady_clock timer;
+
+template<typename T>
+static inline std::chrono::microseconds time(const T& func){
+	auto begin_time = timer.now();
+	func();
+	auto end_time = timer.now();
+	return chrono::duration_cast<std::chrono::microseconds>(end_time - begin_time);
+}
+
+constexpr size_t nframes = 512;			// AudioPlayer's buffer size
+constexpr size_t nsources = 16;			// planar buffers mixed into each output buffer
+constexpr size_t nbuffers = 20'000;
+
+struct MixKernels{
+	const char* name;
+	decltype(&AudioMixing::BlendPlanarToInterleaved) blend;
+	decltype(&AudioMixing::ApplyGain) gain;
+	decltype(&AudioMixing::Clamp) clamp;
+};
+
+// the work AudioPlayer::Tick does per output buffer: apply a volume, blend every source into the interleaved output, then clip
+static inline void RunMixBenchmark(const MixKernels& kernels, uint8_t nchannels){
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> dist(-0.2f, 0.2f);
+	std::vector<float> sources(nsources * nframes * nchannels);
+	for(auto& sample : sources){
+		sample = dist(rng);
+	}
+	std::vector<float> output(nframes * nchannels);
+
+	auto dur = time([&]{
+		for(size_t b = 0; b < nbuffers; b++){
+			std::fill(output.begin(), output.end(), 0.0f);
+			for(size_t s = 0; s < nsources; s++){
+				auto source = sources.data() + s * nframes * nchannels;
+				kernels.gain(source, nframes * nchannels, 1.0f);
+				kernels.blend(output.data(), source, nframes, nframes, nchannels);
+			}
+			kernels.clamp(output.data(), output.size(), -1.0f, 1.0f);
+		}
+	});
+	const double samples = double(nbuffers) * nsources * nframes * nchannels;
+	cout << StrFormat("{:<8} {} channels: {:.1f} M samples / s (output[0] = {})\n", kernels.name, nchannels, samples / dur.count(), output[0]);
+}
+
+constexpr size_t nImportFrames = 44'100 * 10;	// ten seconds of decoded audio
+constexpr size_t nImports = 20;
+
+// the conversion AudioAsset does after decoding, from interleaved samples to one plane per channel
+static inline void RunDeinterleaveBenchmark(uint8_t nchannels){
+	std::vector<float> interleaved(nImportFrames * nchannels), planar(nImportFrames * nchannels);
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> dist(-1, 1);
+	for(auto& sample : interleaved){
+		sample = dist(rng);
+	}
+	
+	// the loop ImportInterleavedData used before, one division and one modulo per sample
+	auto modulo = time([&]{
+		for(size_t n = 0; n < nImports; n++){
+			for(size_t i = 0; i < interleaved.size(); i++){
+				planar[(i % nchannels) * nImportFrames + i / nchannels] = interleaved[i];
+			}
+		}
+	});
+	const auto check = planar;
+	auto scalar = time([&]{
+		for(size_t n = 0; n < nImports; n++){
+			AudioMixing::Scalar::InterleavedToPlanar(planar.data(), nImportFrames, interleaved.data(), nImportFrames, nchannels);
+		}
+	});
+	auto vectorized = time([&]{
+		for(size_t n = 0; n < nImports; n++){
+			AudioMixing::InterleavedToPlanar(planar.data(), nImportFrames, interleaved.data(), nImportFrames, nchannels);
+		}
+	});
+	Debug::Assert(planar == check, "Deinterleaving kernels disagree");
+	const double samples = double(nImports) * interleaved.size();
+	cout << StrFormat("{} channels: modulo {:.1f}, Scalar {:.1f}, {} {:.1f} M samples / s\n", nchannels, samples / modulo.count(), samples / scalar.count(), AudioMixing::GetKernelName(), samples / vectorized.count());
+}
+
+constexpr size_t nVoiceSources = 2000;
+constexpr size_t nVoiceBuffers = 2000;		// about 23 seconds of audio
+constexpr uint32_t sampleRate = 44'100;
+
+// renders a scene of moving looping sources offline, one buffer at a time, the way AudioPlayer does on one thread
+static inline void RunVoiceBenchmark(uint32_t maxVoices){
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> noise(-0.2f, 0.2f), place(-100, 100);
+	
+	constexpr size_t assetFrames = sampleRate * 10;
+	auto samples = new float[assetFrames];
+	for(size_t i = 0; i < assetFrames; i++){
+		samples[i] = noise(rng);
+	}
+	auto asset = New<AudioAsset>(InterleavedSampleBufferView{samples, assetFrames}, 1);
+	
+	std::vector<Ref<SampledAudioDataProvider>> providers;
+	std::vector<vector3> positions, velocities;
+	for(size_t i = 0; i < nVoiceSources; i++){
+		auto provider = New<SampledAudioDataProvider>(asset);
+		provider->SetLoop(true);
+		provider->playhead_pos = rng() % assetFrames;
+		provider->SetPriority(i % 10 == 0 ? 4 : 1);	// a few important sources, like dialogue
+		provider->Play();
+		providers.push_back(provider);
+		positions.emplace_back(place(rng), 0, place(rng));
+		velocities.emplace_back(place(rng) / 50, 0, place(rng) / 50);	// up to 2 m/s
+	}
+	
+	AudioVoiceManager manager({.maxVoices = maxVoices});
+	std::vector<float> buffer(nframes), scratch(nframes), mix(nframes);
+	PlanarSampleBufferInlineView view(buffer.data(), nframes, nframes);
+	PlanarSampleBufferInlineView scratchView(scratch.data(), nframes, nframes);
+	const float dt = float(nframes) / sampleRate;
+	size_t rendered = 0, transitions = 0;
+	
+	auto dur = time([&]{
+		for(size_t b = 0; b < nVoiceBuffers; b++){
+			manager.SetListener(vector3(0, 0, 0));
+			for(size_t i = 0; i < nVoiceSources; i++){
+				positions[i] += velocities[i] * dt;
+				manager.AddPointSource(providers[i], positions[i]);
+			}
+			manager.Update();
+			
+			std::fill(mix.begin(), mix.end(), 0.0f);
+			for(const auto& voice : manager.GetRealVoices()){
+				manager.Render(voice, view, scratchView);
+				AudioMixing::AdditiveBlend(mix.data(), buffer.data(), nframes);
+			}
+			manager.AdvanceVirtualVoices(nframes);
+			
+			const auto& stats = manager.GetStatistics();
+			rendered += stats.nReal;
+			transitions += stats.nPromoted + stats.nDemoted;
+		}
+	});
+	const double perBuffer = double(dur.count()) / nVoiceBuffers;
+	const double deadline = 1e6 * nframes / sampleRate;
+	cout << StrFormat("{:>4} voices: {:.1f} us / buffer ({:.1f}% of the {:.0f} us deadline), {:.1f} rendered and {:.2f} promoted or demoted per buffer (mix[0] = {})\n", maxVoices, perBuffer, 100 * perBuffer / deadline, deadline, double(rendered) / nVoiceBuffers, double(transitions) / nVoiceBuffers, mix[0]);
+}
+
+constexpr size_t nGraphs = 512;
+constexpr size_t nGraphBuffers = 200;
+
+// one effect graph per source: two gains (fused when compiled), a low-pass, a compressor and a short echo
+static inline void RunGraphBenchmark(){
+	std::vector<Ref<AudioGraphAsset>> graphs;
+	for(size_t i = 0; i < nGraphs; i++){
+		auto graph = New<AudioGraphAsset>(1);
+		graph->filters.push_back(std::make_shared<AudioGainFilterLayer>(0.8f));
+		graph->filters.push_back(std::make_shared<AudioGainFilterLayer>(1.1f));
+		graph->filters.push_back(std::make_shared<AudioBiquadFilterLayer>(AudioBiquadFilterLayer::Mode::LowPass, 2000.0f + i, 0.70710678f, sampleRate));
+		auto compressor = std::make_shared<AudioCompressorFilterLayer>(0.5f, 4.0f);
+		compressor->sampleRate = sampleRate;
+		graph->filters.push_back(compressor);
+		auto echo = std::make_shared<AudioDelayFilterLayer>(0.05f, 0.4f, 0.3f);
+		echo->maxDelaySeconds = 0.1f;
+		echo->sampleRate = sampleRate;
+		graph->filters.push_back(echo);
+		graphs.push_back(graph);
+	}
+	
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> noise(-0.3f, 0.3f);
+	std::vector<float> input(nframes), buffer(nframes), scratch(nframes);
+	for(auto& sample : input){
+		sample = noise(rng);
+	}
+	
+	// what AudioGraphAsset::Render did before compiling: a virtual call per layer, swapping buffers in between
+	float checksum = 0;
+	auto layered = time([&]{
+		for(size_t b = 0; b < nGraphBuffers; b++){
+			for(auto& graph : graphs){
+				buffer = input;
+				PlanarSampleBufferInlineView in(buffer.data(), nframes, nframes), out(scratch.data(), nframes, nframes);
+				for(auto& filter : graph->filters){
+					filter->process(in, out);
+					std::swap(in, out);
+				}
+				checksum += in[0][0];
+			}
+		}
+	});
+	auto compiled = time([&]{
+		for(size_t b = 0; b < nGraphBuffers; b++){
+			for(auto& graph : graphs){
+				buffer = input;
+				PlanarSampleBufferInlineView view(buffer.data(), nframes, nframes), scratchView(scratch.data(), nframes, nframes);
+				graph->Render(view, scratchView, 1);
+				checksum += buffer[0];
+			}
+		}
+	});
+	cout << StrFormat("\n{} graphs of 5 filters, {} buffers of {} frames (checksum {})\n", nGraphs, nGraphBuffers, nframes, checksum);
+	cout << StrFormat("Per layer: {:.1f} us / buffer\nCompiled: {:.1f} us / buffer ({:.2f}x)\n", double(layered.count()) / nGraphBuffers, double(compiled.count()) / nGraphBuffers, double(layered.count()) / compiled.count());
+}
+
+// a 16-bit stereo WAV of tones plus noise
+static std::vector<uint8_t> GenerateWav(uint32_t rate, size_t nframes, uint32_t seed){
+	std::vector<uint8_t> wav;
+	auto put16 = [&](uint16_t v){ wav.push_back(v & 0xFF); wav.push_back(v >> 8); };
+	auto put32 = [&](uint32_t v){ put16(v & 0xFFFF); put16(v >> 16); };
+	const uint32_t dataBytes = nframes * 2 * sizeof(int16_t);
+	wav.insert(wav.end(), {'R','I','F','F'});
+	put32(36 + dataBytes);
+	wav.insert(wav.end(), {'W','A','V','E','f','m','t',' '});
+	put32(16);
+	put16(1);
+	put16(2);
+	put32(rate);
+	put32(rate * 2 * sizeof(int16_t));
+	put16(2 * sizeof(int16_t));
+	put16(16);
+	wav.insert(wav.end(), {'d','a','t','a'});
+	put32(dataBytes);
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> noise(-2000, 2000);
+	for(size_t i = 0; i < nframes * 2; i++){
+		put16(static_cast<uint16_t>(static_cast<int16_t>(std::sin(i * 0.01 * (seed + 1)) * 20000 + noise(rng))));
+	}
+	return wav;
+}
+
+// loads the same files with the decode cache disabled, empty, and populated
+static inline void RunDecodeCacheBenchmark(){
+	constexpr size_t nfiles = 8;
+	constexpr uint32_t fileRate = 48'000;
+	std::vector<std::vector<uint8_t>> files;
+	for(uint32_t i = 0; i < nfiles; i++){
+		files.push_back(GenerateWav(fileRate, fileRate * 20, i));
+	}
+	
+	auto& cache = AudioAsset::GetDecodeCache();
+	const auto dir = std::filesystem::temp_directory_path() / "rve_audioperf_cache";
+	std::filesystem::remove_all(dir);
+	
+	auto loadAll = [&]{
+		size_t nsamples = 0;
+		for(const auto& file : files){
+			nsamples += New<AudioAsset>(file, "wav", 1, sampleRate)->GetNumSamples();
+		}
+		return nsamples;
+	};
+	
+	cache.SetDirectory({});
+	size_t nsamples = 0;
+	const auto uncached = time([&]{ nsamples = loadAll(); });
+	cache.SetDirectory(dir);
+	const auto cold = time(loadAll);
+	const auto warm = time(loadAll);
+	const auto stats = cache.GetStatistics();
+	
+	cout << StrFormat("\n{} files of 20 s, 48 kHz stereo, loaded as 44.1 kHz mono ({} frames)\n", nfiles, nsamples);
+	cout << StrFormat("No cache: {} ms\nCold: {} ms\nWarm: {} ms ({:.1f}x faster than no cache, {} hits, {} KiB on disk)\n", uncached.count() / 1000, cold.count() / 1000, warm.count() / 1000, double(uncached.count()) / warm.count(), stats.hits, stats.totalBytes / 1024);
+	
+	cache.Clear();
+	cache.SetDirectory(DiskCache::TemporaryDirectory("AudioCache"));
+	std::filesystem::remove_all(dir);
+}
+
+constexpr size_t nRooms = 16;
+constexpr size_t nRoomSources = 32;
+constexpr size_t nRoomBuffers = 200;
+
+// the room pass of AudioPlayer::Tick: every room spatialises its sources, then the rooms are mixed
+static inline std::vector<float> RunRoomBenchmark(uint32_t nworkers, const std::vector<float>& serial){
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> noise(-0.2f, 0.2f), place(-8, 8);
+	
+	std::vector<Ref<AudioRoom::RoomData>> rooms;
+	std::vector<vector3> roomPositions;
+	for(size_t r = 0; r < nRooms; r++){
+		auto room = New<AudioRoom::RoomData>(2, nframes, sampleRate);
+		room->SetRoomDimensions(vector3(16, 4, 16));
+		rooms.push_back(room);
+		roomPositions.emplace_back((r % 4) * 20.0f, 0, (r / 4) * 20.0f);
+	}
+	std::vector<float> sources(nRoomSources * nframes);
+	for(auto& sample : sources){
+		sample = noise(rng);
+	}
+	std::vector<vector3> sourcePositions;
+	for(size_t s = 0; s < nRooms * nRoomSources; s++){
+		sourcePositions.push_back(roomPositions[s / nRoomSources] + vector3(place(rng), 0, place(rng)));
+	}
+	
+	const quaternion identity(1, 0, 0, 0);
+	auto renderRoom = [&](size_t r, PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratch){
+		auto& room = rooms[r];
+		room->SetListenerTransform(vector3(30, 0, 30), identity);
+		for(size_t s = 0; s < nRoomSources; s++){
+			room->AddEmitter(sources.data() + s * nframes, sourcePositions[r * nRoomSources + s], identity, roomPositions[r], identity, s, 1);
+		}
+		room->Simulate(buffer, scratch);
+	};
+	
+	AudioRoomRenderer renderer(nworkers);
+	std::vector<float> output(nRoomBuffers * nframes * 2, 0.0f);
+	float maxRoom = 0;
+	auto dur = time([&]{
+		for(size_t b = 0; b < nRoomBuffers; b++){
+			renderer.Render(nRooms, renderRoom, InterleavedSampleBufferView{output.data() + b * nframes * 2, nframes * 2}, 2);
+			maxRoom = std::max(maxRoom, renderer.GetStatistics().maxRoomMicroseconds);
+		}
+	});
+	
+	const double perBuffer = double(dur.count()) / nRoomBuffers;
+	const double deadline = 1e6 * nframes / sampleRate;
+	// each run has its own Resonance instances, whose internal summation order varies at rounding level, so this is not bit-exact. Test_AudioRoomRenderer checks that.
+	float maxDifference = 0;
+	for(size_t i = 0; i < serial.size(); i++){
+		maxDifference = std::max(maxDifference, std::fabs(serial[i] - output[i]));
+	}
+	cout << StrFormat("{} workers: {:.1f} us / buffer ({:.1f}% of the {:.0f} us deadline), slowest room {:.1f} us, max difference from serial {}\n", nworkers, perBuffer, 100 * perBuffer / deadline, deadline, maxRoom, maxDifference);
+	return output;
+}
+
+constexpr size_t nStaticSources = 10'000;
+constexpr size_t nMovingSources = 200;
+constexpr size_t nSnapshotTicks = 1000;
+
+// the world's audio tasks each tick: report every source, then hand the scene to the audio thread
+static inline void RunSnapshotBenchmark(){
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> place(-100, 100);
+	auto samples = new float[nframes]();
+	auto asset = New<AudioAsset>(InterleavedSampleBufferView{samples, nframes}, 1);
+	std::vector<Ref<AudioDataProvider>> providers;
+	std::vector<vector3> positions;
+	for(size_t i = 0; i < nStaticSources + nMovingSources; i++){
+		providers.push_back(New<SampledAudioDataProvider>(asset));
+		positions.emplace_back(place(rng), 0, place(rng));
+	}
+	const quaternion rot(1, 0, 0, 0);
+	auto move = [&]{
+		for(size_t i = nStaticSources; i < positions.size(); i++){
+			positions[i].x += 0.01f;
+		}
+	};
+	
+	// what the world did before: clear one of three snapshots and insert every source into a hash set
+	struct ProviderHash{
+		size_t operator()(const AudioSnapshot::PointSource& source) const{
+			return std::hash<AudioDataProvider*>()(source.data.get());
+		}
+	};
+	std::array<phmap::flat_hash_set<AudioSnapshot::PointSource, ProviderHash>, 3> rebuilt;
+	size_t checksum = 0;
+	auto rebuild = time([&]{
+		for(size_t t = 0; t < nSnapshotTicks; t++){
+			move();
+			auto& snapshot = rebuilt[t % rebuilt.size()];
+			snapshot.clear();
+			for(size_t i = 0; i < providers.size(); i++){
+				snapshot.emplace(providers[i], positions[i], rot);
+			}
+			checksum += snapshot.size();
+		}
+	});
+	
+	AudioSnapshotPublisher publisher;
+	size_t copied = 0;
+	auto incremental = time([&]{
+		for(size_t t = 0; t < nSnapshotTicks; t++){
+			move();
+			publisher.BeginUpdate();
+			for(size_t i = 0; i < providers.size(); i++){
+				publisher.UpdateSource(providers[i], positions[i], rot);
+			}
+			publisher.EndUpdate();
+			checksum += publisher.AcquireLatest()->sources.size();
+			copied += publisher.GetStatistics().nCopied;
+		}
+	});
+	
+	cout << StrFormat("\n{} static and {} moving sources, {} ticks\n", nStaticSources, nMovingSources, nSnapshotTicks);
+	cout << StrFormat("Rebuild: {:.1f} us / tick\nIncremental: {:.1f} us / tick ({:.1f}x faster, {:.0f} entries copied per publish, checksum {})\n", double(rebuild.count()) / nSnapshotTicks, double(incremental.count()) / nSnapshotTicks, double(rebuild.count()) / incremental.count(), double(copied) / nSnapshotTicks, checksum);
+}
+
+int main(int argc, const char** argv){
+	const MixKernels scalar{"Scalar", &AudioMixing::Scalar::BlendPlanarToInterleaved, &AudioMixing::Scalar::ApplyGain, &AudioMixing::Scalar::Clamp};
+	const MixKernels vectorized{AudioMixing::GetKernelName(), &AudioMixing::BlendPlanarToInterleaved, &AudioMixing::ApplyGain, &AudioMixing::Clamp};
+
+	cout << StrFormat("{} sources x {} frames per buffer, {} buffers\n", nsources, nframes, nbuffers);
+	for(uint8_t nchannels : {2, 6, 8}){
+		RunMixBenchmark(scalar, nchannels);
+		RunMixBenchmark(vectorized, nchannels);
+	}
+	
+	cout << StrFormat("\nDeinterleaving {} frames, {} times\n", nImportFrames, nImports);
+	for(uint8_t nchannels : {1, 2, 4, 6, 8}){
+		RunDeinterleaveBenchmark(nchannels);
+	}
+	
+	cout << StrFormat("\n{} moving sources, {} buffers\n", nVoiceSources, nVoiceBuffers);
+	RunVoiceBenchmark(nVoiceSources);	// no virtualisation
+	RunVoiceBenchmark(64);
+	
+	RunGraphBenchmark();
+	
+	RunDecodeCacheBenchmark();
+	
+	cout << StrFormat("\n{} rooms x {} sources, {} buffers\n", nRooms, nRoomSources, nRoomBuffers);
+	const auto serial = RunRoomBenchmark(0, {});
+	for(uint32_t nworkers : {1, 2, 4, 8}){
+		RunRoomBenchmark(nworkers, serial);
+	}
+	
+	RunSnapshotBenchmark();
+	return 0;
+}
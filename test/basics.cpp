@@ -9,7 +9,40 @@
 #include <RavEngine/Uuid.hpp>
 #include <string_view>
 #include <RavEngine/Debug.hpp>
+#include <RavEngine/FrameAllocator.hpp>
+#include <RavEngine/SpinLock.hpp>
+#include <RavEngine/TimerWheel.hpp>
+#include <RavEngine/MemoryTracker.hpp>
+#include <RavEngine/RenderEngine.hpp>
+#include <RavEngine/MeshAsset.hpp>
+#include <RavEngine/AudioSource.hpp>
+#include <RavEngine/AudioMixing.hpp>
+#include <RavEngine/AudioStreaming.hpp>
+#include <RavEngine/AudioVoiceManager.hpp>
+#include <RavEngine/DiskCache.hpp>
+#include <RavEngine/AudioGraphAsset.hpp>
+#include <RavEngine/AudioRoomRenderer.hpp>
+#include <RavEngine/AudioSnapshot.hpp>
+#include <RavEngine/GameObject.hpp>
+#include <RavEngine/PhysicsSolver.hpp>
+#include <RavEngine/PhysicsBodyComponent.hpp>
+#include <RavEngine/PhysicsCollider.hpp>
+#include <RavEngine/PhysicsMaterial.hpp>
+#include <RavEngine/CookedMeshCache.hpp>
+#include <RavEngine/PhysicsLinkSystem.hpp>
+#include <thread>
 #include <cassert>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 
 using namespace RavEngine;
 using namespace std;
@@ -216,13 +249,2195 @@ int Test_MoveBetweenWorlds(){
     return 0;
 }
 
+int Test_FrameArenaReset(){
+    FrameArena arena(1024);
+    FrameArena::EndFrame();     // arenas always start a frame on their first allocation
+    
+    auto first = arena.Allocate(100);
+    auto second = arena.Allocate(100);
+    assert(first != second);
+    assert(arena.Owns(first) && arena.Owns(second));
+    assert(arena.GetStatistics().used >= 200);
+    
+    // alignment must be honored
+    auto aligned = arena.Allocate(8, 64);
+    assert(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+    
+    // rolling back the most recent allocation reuses its space
+    arena.Deallocate(aligned, 8);
+    auto again = arena.Allocate(8, 64);
+    assert(again == aligned);
+    
+    // after the frame ends, the next allocation recycles the arena
+    FrameArena::EndFrame();
+    auto recycled = arena.Allocate(100);
+    assert(recycled == first);
+    auto stats = arena.GetStatistics();
+    cout << "After reset, arena reports " << stats.used << " bytes used with a high water mark of " << stats.highWaterMark << "\n";
+    assert(stats.used == 100);
+    assert(stats.highWaterMark >= 200);
+    
+    // STL adaptor
+    {
+        FrameVector<int> vec;
+        for(int i = 0; i < 1000; i++){
+            vec.push_back(i);
+        }
+        for(int i = 0; i < 1000; i++){
+            assert(vec[i] == i);
+        }
+    }
+    return 0;
+}
+
+int Test_FrameArenaOverflow(){
+    FrameArena arena(256);
+    FrameArena::EndFrame();
+    
+    auto inArena = arena.Allocate(200);
+    assert(arena.Owns(inArena));
+    
+    // this one does not fit, so it must come from the heap
+    auto overflow = static_cast<char*>(arena.Allocate(4096));
+    assert(!arena.Owns(overflow));
+    std::memset(overflow, 0xAB, 4096);  // must be writable
+    
+    auto stats = arena.GetStatistics();
+    cout << "Overflowed " << stats.overflowCount << " allocation(s) totalling " << stats.overflowBytes << " bytes\n";
+    assert(stats.overflowCount == 1);
+    assert(stats.overflowBytes >= 4096);
+    assert(stats.highWaterMark >= 4096 + 200);
+    
+    // overflow allocations are released on reset
+    FrameArena::EndFrame();
+    arena.Allocate(16);
+    stats = arena.GetStatistics();
+    assert(stats.overflowCount == 0);
+    assert(stats.overflowBytes == 0);
+    assert(stats.highWaterMark >= 4096 + 200);
+    assert(FrameArena::GetGlobalHighWaterMark() >= 4096 + 200);
+    return 0;
+}
+
+int Test_SpinLockContention(){
+    InstrumentedSpinLock lock;
+    constexpr int nthreads = 8;
+    constexpr int iterations = 50'000;
+    int counter = 0;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < nthreads; t++){
+        threads.emplace_back([&]{
+            for(int i = 0; i < iterations; i++){
+                lock.lock();
+                counter++;
+                lock.unlock();
+            }
+        });
+    }
+    for(auto& thread : threads){
+        thread.join();
+    }
+    auto& stats = lock.GetStatistics();
+    cout << "Counter = " << counter << ", " << stats.acquisitions << " acquisitions, " << stats.contendedAcquisitions << " contended, " << stats.sleeps << " sleeps\n";
+    assert(counter == nthreads * iterations);
+    assert(stats.acquisitions == nthreads * iterations);
+    assert(stats.contendedAcquisitions <= stats.acquisitions);
+    
+    // try_lock must fail while held and succeed once released
+    lock.lock();
+    assert(!lock.try_lock());
+    lock.unlock();
+    assert(lock.try_lock());
+    lock.unlock();
+    return 0;
+}
+
+struct IncrementIntSystem{
+    inline void operator()(IntComponent& ic) const{
+        ic.value++;
+    }
+};
+
+struct IncrementFloatSystem{
+    inline void operator()(FloatComponent& fc) const{
+        fc.value += 1;
+    }
+};
+
+struct ReadFloatSystem{
+    inline void operator()(const FloatComponent& fc) const{}
+};
+
+int Test_SystemScheduling(){
+    World w;
+    constexpr auto nInts = 10'000;
+    constexpr auto nFloats = 3;
+    constexpr auto nTicks = 30;
+    
+    for(int i = 0; i < nInts; i++){
+        w.CreatePrototype<Entity>().EmplaceComponent<IntComponent>().value = 0;
+    }
+    for(int i = 0; i < nFloats; i++){
+        w.CreatePrototype<Entity>().EmplaceComponent<FloatComponent>().value = 0;
+    }
+    w.EmplaceSystem<IncrementIntSystem>();
+    w.EmplaceSystem<IncrementFloatSystem>();
+    w.EmplaceSystem<ReadFloatSystem>();
+    w.CreateDependency<ReadFloatSystem, IncrementFloatSystem>();
+    
+    for(int i = 0; i < nTicks; i++){
+        w.Tick(1);
+    }
+    
+    // every entity must be processed exactly once per tick, regardless of how the work was split
+    int count = 0;
+    w.Filter([&](const IntComponent& ic){
+        assert(ic.value == nTicks);
+        count++;
+    });
+    assert(count == nInts);
+    w.Filter([&](const FloatComponent& fc){
+        assert(fc.value == nTicks);
+    });
+    
+    auto& intStats = w.GetSystemStatistics<IncrementIntSystem>();
+    auto& floatStats = w.GetSystemStatistics<IncrementFloatSystem>();
+    cout << StrFormat("IncrementIntSystem: {} µs avg, {} ns/entity, {} chunks\n", intStats.avgMicros, intStats.avgNanosPerEntity, intStats.lastChunkCount);
+    cout << StrFormat("IncrementFloatSystem: {} µs avg, {} chunks, fused = {}\n", floatStats.avgMicros, floatStats.lastChunkCount, floatStats.lastFused);
+    assert(intStats.lastEntityCount == nInts);
+    assert(floatStats.lastEntityCount == nFloats);
+    assert(floatStats.lastChunkCount == 1);     // far too small to be worth splitting
+    
+    // Systems with dependencies are never batched into another System's task
+    assert(!floatStats.lastFused);
+    assert(!w.GetSystemStatistics<ReadFloatSystem>().lastFused);
+    
+    // the legacy mode must produce the same result
+    w.systemSchedulingConfig.adaptive = false;
+    w.Tick(1);
+    w.Filter([&](const IntComponent& ic){
+        assert(ic.value == nTicks + 1);
+    });
+    
+    return 0;
+}
+
+int Test_TimerWheel(){
+    TimerWheel wheel(0.001);
+    Vector<TimerWheel::callback_t> expired;
+    int fired = 0;
+    auto increment = [&]{ fired++; };
+    
+    auto soon = wheel.Schedule(0.010, increment);
+    auto later = wheel.Schedule(0.500, increment);
+    auto farFuture = wheel.Schedule(100'000.0, increment);     // beyond the lower levels, must cascade
+    auto cancelled = wheel.Schedule(0.010, increment);
+    assert(wheel.size() == 4);
+    
+    assert(wheel.Cancel(cancelled));
+    assert(!wheel.Cancel(cancelled));       // second cancel is a no-op
+    assert(!wheel.IsPending(cancelled));
+    
+    // nothing is due yet
+    wheel.Advance(0.005, expired);
+    assert(expired.empty());
+    
+    wheel.Advance(0.010, expired);
+    assert(expired.size() == 1);
+    for(auto& func : expired){
+        func();
+    }
+    expired.clear();
+    assert(fired == 1);
+    assert(!wheel.IsPending(soon));
+    assert(!wheel.Cancel(soon));            // stale handle
+    
+    // a reused slab slot must not be cancellable through the old handle
+    auto reused = wheel.Schedule(1.0, increment);
+    assert(reused.index == soon.index || reused.index == cancelled.index);
+    assert(!wheel.Cancel(soon));
+    assert(wheel.IsPending(reused));
+    
+    // a large jump fires everything that became due, but nothing early
+    wheel.Advance(99'999.0, expired);
+    assert(expired.size() == 2);
+    assert(wheel.IsPending(farFuture));
+    assert(!wheel.IsPending(later));
+    expired.clear();
+    
+    wheel.Advance(100'001.0, expired);
+    assert(expired.size() == 1);
+    assert(wheel.size() == 0);
+    return 0;
+}
+
+int Test_MemoryTracking(){
+    // containers
+    {
+        auto before = MemoryTracker::GetStatistics(MemoryTag::Containers).currentBytes;
+        {
+            TrackedVector<int> vec;
+            vec.resize(1000);
+            assert(MemoryTracker::GetStatistics(MemoryTag::Containers).currentBytes >= before + 1000 * sizeof(int));
+            TrackedUnorderedMap<int, int> map;
+            for(int i = 0; i < 100; i++){
+                map[i] = i;
+            }
+        }
+        assert(MemoryTracker::GetStatistics(MemoryTag::Containers).currentBytes == before);
+    }
+    
+    // meshes in system memory, no GPU
+    {
+        MeshAsset::MeshPart part;
+        part.vertices.resize(1000);
+        part.indices.resize(3000);
+        auto before = MemoryTracker::GetStatistics(MemoryTag::Meshes).currentBytes;
+        for(int cycle = 0; cycle < 3; cycle++){
+            auto mesh = New<MeshAsset>(part, MeshAssetOptions{.keepInSystemRAM = true, .uploadToGPU = false});
+            auto loaded = MemoryTracker::GetStatistics(MemoryTag::Meshes).currentBytes;
+            assert(loaded >= before + 1000 * sizeof(MeshAsset::vertex_t) + 3000 * sizeof(uint32_t));
+            mesh->DeallocSystemCopy();
+            assert(MemoryTracker::GetStatistics(MemoryTag::Meshes).currentBytes == before);
+        }
+        assert(MemoryTracker::GetStatistics(MemoryTag::Meshes).peakBytes >= before + 1000 * sizeof(MeshAsset::vertex_t));
+    }
+    
+    // audio, with a budget
+    {
+        constexpr size_t nsamples = 48000;
+        auto before = MemoryTracker::GetStatistics(MemoryTag::Audio).currentBytes;
+        int budgetHits = 0;
+        MemoryTracker::SetBudget(MemoryTag::Audio, before + nsamples * sizeof(float) + 1, [&](MemoryTag tag, size_t current, size_t budget){
+            assert(tag == MemoryTag::Audio);
+            assert(current > budget);
+            budgetHits++;
+        });
+        for(int cycle = 0; cycle < 3; cycle++){
+            auto first = New<AudioAsset>(InterleavedSampleBufferView{new float[nsamples]{0}, nsamples}, 1);
+            assert(MemoryTracker::GetStatistics(MemoryTag::Audio).currentBytes == before + nsamples * sizeof(float));
+            auto second = New<AudioAsset>(InterleavedSampleBufferView{new float[nsamples]{0}, nsamples}, 1);
+        }
+        assert(MemoryTracker::GetStatistics(MemoryTag::Audio).currentBytes == before);
+        assert(budgetHits == 3);    // once per crossing, not once per allocation
+        MemoryTracker::SetBudget(MemoryTag::Audio, 0, nullptr);
+    }
+    
+    // GPU buffers and textures, created through the same path as RenderEngine's tagged overloads, on a stand-in device
+    {
+        struct FakeResource{};
+        struct FakeDevice{
+            int created = 0;
+            std::shared_ptr<FakeResource> CreateBuffer(const RGL::BufferConfig&){
+                created++;
+                return std::make_shared<FakeResource>();
+            }
+            std::shared_ptr<FakeResource> CreateTexture(const RGL::TextureConfig&){
+                created++;
+                return std::make_shared<FakeResource>();
+            }
+            std::shared_ptr<FakeResource> CreateTextureWithData(const RGL::TextureConfig&, RGL::untyped_span){
+                created++;
+                return std::make_shared<FakeResource>();
+            }
+        } device;
+        const auto buffersBefore = MemoryTracker::GetStatistics(MemoryTag::GPUBuffers).currentBytes;
+        const auto texturesBefore = MemoryTracker::GetStatistics(MemoryTag::Textures).currentBytes;
+        {
+            auto buffer = RenderEngine::CreateBuffer(device, RGL::BufferConfig(256, {.VertexBuffer = true}, 16, RGL::BufferAccess::Private), MemoryTag::GPUBuffers);
+            assert(buffer != nullptr);
+            assert(MemoryTracker::GetStatistics(MemoryTag::GPUBuffers).currentBytes == buffersBefore + 256 * 16);
+            
+            RGL::TextureConfig config{
+                .width = 64,
+                .height = 32,
+                .format = RGL::TextureFormat::RGBA8_Unorm,
+            };
+            auto texture = RenderEngine::CreateTexture(device, config, MemoryTag::Textures);
+            uint32_t pixels[64 * 32]{0};
+            auto filled = RenderEngine::CreateTextureWithData(device, config, {pixels, sizeof(pixels)}, MemoryTag::Textures);
+            assert(texture != nullptr && filled != nullptr);
+            assert(MemoryTracker::GetStatistics(MemoryTag::Textures).currentBytes == texturesBefore + 2 * RenderEngine::EstimateTextureSize(config));
+            assert(device.created == 3);
+        }
+        assert(MemoryTracker::GetStatistics(MemoryTag::GPUBuffers).currentBytes == buffersBefore);
+        assert(MemoryTracker::GetStatistics(MemoryTag::Textures).currentBytes == texturesBefore);
+    }
+    
+    auto report = MemoryTracker::Report();
+    cout << report;
+    assert(report.find("Meshes") != std::string::npos);
+    assert(report.find("Audio") != std::string::npos);
+    return 0;
+}
+
+int Test_AudioMixingKernels(){
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    auto fill = [&](std::vector<float>& buf){
+        for(auto& sample : buf){
+            sample = dist(rng);
+        }
+    };
+    auto same = [](const std::vector<float>& a, const std::vector<float>& b){
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+    };
+    
+    // odd lengths and a 1-float offset exercise the unaligned and tail paths
+    for(size_t count = 0; count < 70; count++){
+        std::vector<float> src(count + 1), dst(count + 1);
+        fill(src);
+        fill(dst);
+        
+        auto vec = dst, ref = dst;
+        AudioMixing::AdditiveBlend(vec.data() + 1, src.data() + 1, count);
+        AudioMixing::Scalar::AdditiveBlend(ref.data() + 1, src.data() + 1, count);
+        assert(same(vec, ref));
+        
+        vec = dst; ref = dst;
+        AudioMixing::ApplyGain(vec.data() + 1, count, 0.3f);
+        AudioMixing::Scalar::ApplyGain(ref.data() + 1, count, 0.3f);
+        assert(same(vec, ref));
+        
+        vec = dst; ref = dst;
+        AudioMixing::CopyWithGain(vec.data() + 1, src.data() + 1, count, -1.7f);
+        AudioMixing::Scalar::CopyWithGain(ref.data() + 1, src.data() + 1, count, -1.7f);
+        assert(same(vec, ref));
+        
+        // include values on and around the bounds, signed zeros, infinities and NaN
+        constexpr float specials[] = {-1.0f, 1.0f, -0.0f, 0.0f, std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(), std::nextafter(1.0f, 2.0f)};
+        for(size_t i = 0; i < count; i += 3){
+            dst[i + 1] = specials[i % std::size(specials)];
+        }
+        vec = dst; ref = dst;
+        AudioMixing::Clamp(vec.data() + 1, count);
+        AudioMixing::Scalar::Clamp(ref.data() + 1, count);
+        assert(same(vec, ref));
+        for(size_t i = 0; i < count; i++){
+            auto expected = std::clamp(dst[i + 1], -1.0f, 1.0f);
+            assert(std::memcmp(&vec[i + 1], &expected, sizeof(float)) == 0);
+        }
+    }
+    
+    // planar to interleaved, including a channel stride larger than the frame count
+    for(uint8_t nchannels = 1; nchannels <= 8; nchannels++){
+        for(size_t nframes = 0; nframes < 23; nframes++){
+            const size_t stride = nframes + (nframes % 3);
+            std::vector<float> planar(stride * nchannels + 1), dst(nframes * nchannels + 1);
+            fill(planar);
+            fill(dst);
+            
+            auto vec = dst, ref = dst;
+            AudioMixing::BlendPlanarToInterleaved(vec.data() + 1, planar.data() + 1, stride, nframes, nchannels);
+            AudioMixing::Scalar::BlendPlanarToInterleaved(ref.data() + 1, planar.data() + 1, stride, nframes, nchannels);
+            assert(same(vec, ref));
+            
+            // the expression the mixer used before the kernels existed
+            for(size_t i = 0; i < nframes * nchannels; i++){
+                auto expected = dst[i + 1] + planar[1 + (i % nchannels) * stride + i / nchannels];
+                assert(std::memcmp(&vec[i + 1], &expected, sizeof(float)) == 0);
+            }
+            
+            vec = dst; ref = dst;
+            AudioMixing::PlanarToInterleaved(vec.data() + 1, planar.data() + 1, stride, nframes, nchannels);
+            AudioMixing::Scalar::PlanarToInterleaved(ref.data() + 1, planar.data() + 1, stride, nframes, nchannels);
+            assert(same(vec, ref));
+            assert(vec[0] == dst[0]);   // nothing written before the destination
+        }
+    }
+    
+    // interleaved to planar, every channel count up to 8 and odd frame counts, with misaligned buffers
+    for(uint8_t nchannels = 1; nchannels <= 8; nchannels++){
+        for(size_t nframes = 0; nframes < 41; nframes++){
+            const size_t stride = nframes + (nframes % 3);
+            std::vector<float> src(nframes * nchannels + 1), planar(stride * nchannels + 2);
+            fill(src);
+            fill(planar);
+            
+            auto vec = planar, ref = planar;
+            AudioMixing::InterleavedToPlanar(vec.data() + 1, stride, src.data() + 1, nframes, nchannels);
+            AudioMixing::Scalar::InterleavedToPlanar(ref.data() + 1, stride, src.data() + 1, nframes, nchannels);
+            assert(same(vec, ref));
+            for(uint8_t c = 0; c < nchannels; c++){
+                for(size_t f = 0; f < nframes; f++){
+                    assert(vec[1 + c * stride + f] == src[1 + f * nchannels + c]);
+                }
+                // the gap between channels is left alone
+                for(size_t f = nframes; f < stride; f++){
+                    assert(vec[1 + c * stride + f] == planar[1 + c * stride + f]);
+                }
+            }
+            assert(vec[0] == planar[0] && vec.back() == planar.back());
+            
+            // and back again
+            std::vector<float> roundTrip(nframes * nchannels);
+            AudioMixing::PlanarToInterleaved(roundTrip.data(), vec.data() + 1, stride, nframes, nchannels);
+            assert(std::equal(roundTrip.begin(), roundTrip.end(), src.begin() + 1));
+            
+            // ImportInterleavedData, from a separate buffer and in place
+            std::vector<float> storage(nframes * nchannels);
+            PlanarSampleBufferInlineView view(storage.data(), storage.size(), 1);
+            view.ImportInterleavedData(InterleavedSampleBufferView{src.data() + 1, nframes * nchannels}, nchannels);
+            assert(view.sizeOneChannel() == nframes);
+            std::vector<float> inPlace(src.begin() + 1, src.end());
+            PlanarSampleBufferInlineView inPlaceView(inPlace.data(), inPlace.size(), 1);
+            inPlaceView.ImportInterleavedData(InterleavedSampleBufferView{inPlace.data(), inPlace.size()}, nchannels);
+            for(uint8_t c = 0; c < nchannels; c++){
+                for(size_t f = 0; f < nframes; f++){
+                    assert(view[c][f] == src[1 + f * nchannels + c]);
+                    assert(inPlaceView[c][f] == src[1 + f * nchannels + c]);
+                }
+            }
+        }
+    }
+    
+    // generated audio is converted in place by the AudioAsset
+    {
+        constexpr size_t nframes = 1001;
+        auto samples = new float[nframes * 3];
+        for(size_t f = 0; f < nframes; f++){
+            for(size_t c = 0; c < 3; c++){
+                samples[f * 3 + c] = c * 10000.0f + f;
+            }
+        }
+        AudioAsset asset(InterleavedSampleBufferView{samples, nframes * 3}, 3);
+        assert(asset.GetNumSamples() == nframes);
+        for(uint8_t c = 0; c < 3; c++){
+            for(size_t f = 0; f < nframes; f++){
+                assert(asset.data[c][f] == c * 10000.0f + f);
+            }
+        }
+    }
+    
+    cout << "Audio kernels: " << AudioMixing::GetKernelName() << endl;
+    return 0;
+}
+
+// writes a 16-bit PCM WAV of a chirp plus noise, so that every sample differs
+static std::vector<uint8_t> GenerateTestWav(uint32_t sampleRate, uint16_t nchannels, size_t nframes){
+    std::vector<uint8_t> wav;
+    auto put16 = [&](uint16_t v){ wav.push_back(v & 0xFF); wav.push_back(v >> 8); };
+    auto put32 = [&](uint32_t v){ put16(v & 0xFFFF); put16(v >> 16); };
+    const uint32_t dataBytes = nframes * nchannels * sizeof(int16_t);
+    wav.insert(wav.end(), {'R','I','F','F'});
+    put32(36 + dataBytes);
+    wav.insert(wav.end(), {'W','A','V','E','f','m','t',' '});
+    put32(16);
+    put16(1);
+    put16(nchannels);
+    put32(sampleRate);
+    put32(sampleRate * nchannels * sizeof(int16_t));
+    put16(nchannels * sizeof(int16_t));
+    put16(16);
+    wav.insert(wav.end(), {'d','a','t','a'});
+    put32(dataBytes);
+    wav.reserve(wav.size() + dataBytes);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> noise(-2000, 2000);
+    for(size_t i = 0; i < nframes; i++){
+        const double t = double(i) / sampleRate;
+        for(uint16_t c = 0; c < nchannels; c++){
+            const double tone = std::sin(2 * 3.14159265358979 * (220 + 40 * t + 110 * c) * t);
+            put16(static_cast<uint16_t>(static_cast<int16_t>(tone * 20000 + noise(rng))));
+        }
+    }
+    return wav;
+}
+
+// plays a stream offline, waiting for the worker instead of underrunning, and returns every channel
+static std::vector<std::vector<float>> StreamOffline(StreamingAudioDataProvider& provider, size_t bufferFrames){
+    const auto nchannels = provider.GetNChannels();
+    std::vector<float> buffer(bufferFrames * nchannels), scratch(bufferFrames * nchannels);
+    PlanarSampleBufferInlineView view(buffer.data(), buffer.size(), bufferFrames);
+    PlanarSampleBufferInlineView scratchView(scratch.data(), scratch.size(), bufferFrames);
+    std::vector<std::vector<float>> result(nchannels);
+    provider.Play();
+    for(size_t pos = 0; pos < provider.GetNumFrames(); pos += bufferFrames){
+        const auto needed = std::min(bufferFrames, provider.GetNumFrames() - pos);
+        while(provider.GetBufferedFrames() < needed){
+            std::this_thread::yield();
+        }
+        provider.ProvideBufferData(view, scratchView);
+        for(uint8_t c = 0; c < nchannels; c++){
+            result[c].insert(result[c].end(), view[c].begin(), view[c].begin() + needed);
+        }
+    }
+    return result;
+}
+
+int Test_AudioStreaming(){
+    const auto dir = std::filesystem::temp_directory_path();
+    
+    // three minutes of stereo at 48 kHz, streamed at 44.1 kHz and mixed down to mono, against a full decode
+    {
+        constexpr uint32_t fileRate = 48000, outputRate = 44100;
+        constexpr size_t nframes = fileRate * 180;
+        const auto path = dir / "rve_test_stream_long.wav";
+        {
+            auto wav = GenerateTestWav(fileRate, 2, nframes);
+            std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(wav.data()), wav.size());
+            
+            auto reference = New<AudioAsset>(wav, "wav", 1, outputRate);
+            const auto fullDecodeBytes = reference->data.size() * sizeof(float);
+            
+            MemoryTracker::ResetPeaks();
+            const auto before = MemoryTracker::GetStatistics(MemoryTag::Audio).currentBytes;
+            std::vector<std::vector<float>> streamed;
+            size_t underruns = 0;
+            {
+                StreamingAudioDataProvider provider(path, 1, {.sampleRate = outputRate});
+                assert(provider.GetNumFrames() == reference->GetNumSamples());
+                streamed = StreamOffline(provider, 512);
+                underruns = provider.GetUnderrunCount();
+            }
+            const auto streamingPeak = MemoryTracker::GetStatistics(MemoryTag::Audio).peakBytes - before;
+            
+            assert(streamed[0].size() == reference->GetNumSamples());
+            assert(std::memcmp(streamed[0].data(), reference->data[0].data(), streamed[0].size() * sizeof(float)) == 0);
+            assert(underruns == 0);
+            cout << StrFormat("Streamed {} frames. Peak memory: {} KiB streaming, {} KiB fully decoded\n", streamed[0].size(), streamingPeak / 1024, fullDecodeBytes / 1024);
+            assert(streamingPeak * 50 < fullDecodeBytes);
+        }
+        std::filesystem::remove(path);
+    }
+    
+    // stereo without conversion, with an odd frame count, against a full decode
+    {
+        constexpr uint32_t rate = 44100;
+        constexpr size_t nframes = rate * 2 + 77;
+        const auto path = dir / "rve_test_stream_stereo.wav";
+        auto wav = GenerateTestWav(rate, 2, nframes);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(wav.data()), wav.size());
+        auto reference = New<AudioAsset>(wav, "wav", 2, rate);
+        assert(reference->GetNumSamples() == nframes);
+        {
+            StreamingAudioDataProvider provider(path, 2, {.sampleRate = rate});
+            auto streamed = StreamOffline(provider, 512);
+            for(uint8_t c = 0; c < 2; c++){
+                assert(streamed[c].size() == nframes);
+                assert(std::memcmp(streamed[c].data(), reference->data[c].data(), nframes * sizeof(float)) == 0);
+            }
+            // the channels are different signals, so a mix-up between them would show
+            assert(std::memcmp(streamed[0].data(), streamed[1].data(), nframes * sizeof(float)) != 0);
+        }
+        std::filesystem::remove(path);
+    }
+    
+    // mono to stereo without resampling, looping twice and then restarting
+    {
+        constexpr uint32_t rate = 44100;
+        constexpr size_t nframes = rate * 3 + 123;
+        const auto path = dir / "rve_test_stream_short.wav";
+        auto wav = GenerateTestWav(rate, 1, nframes);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(wav.data()), wav.size());
+        auto reference = New<AudioAsset>(wav, "wav", 1, rate);
+        {
+            StreamingAudioDataProvider provider(path, 2, {.bufferFrames = 8192, .chunkFrames = 1000, .sampleRate = rate});
+            assert(provider.GetNumFrames() == nframes);
+            auto streamed = StreamOffline(provider, 480);
+            for(uint8_t c = 0; c < 2; c++){
+                assert(std::memcmp(streamed[c].data(), reference->data[0].data(), nframes * sizeof(float)) == 0);
+            }
+            
+            provider.Restart();
+            provider.SetLoop(true);
+            while(provider.GetBufferedFrames() < 8192){
+                std::this_thread::yield();
+            }
+            // the second pass starts over from the beginning of the file
+            std::vector<float> buffer(nframes * 2 * 2), scratch(buffer.size());
+            size_t pos = 0;
+            while(pos < nframes * 2){
+                const size_t n = std::min<size_t>(480, nframes * 2 - pos);
+                while(provider.GetBufferedFrames() < n){
+                    std::this_thread::yield();
+                }
+                PlanarSampleBufferInlineView view(buffer.data() + pos * 2, n * 2, n);
+                PlanarSampleBufferInlineView scratchView(scratch.data(), n * 2, n);
+                provider.ProvideBufferData(view, scratchView);
+                assert(std::memcmp(view[0].data(), reference->data[0].data() + (pos % nframes), std::min(n, nframes - pos % nframes) * sizeof(float)) == 0);
+                pos += n;
+            }
+            assert(provider.GetUnderrunCount() == 0);
+        }
+        
+        // a ring smaller than the request can never satisfy it
+        {
+            StreamingAudioDataProvider provider(path, 1, {.bufferFrames = 256, .chunkFrames = 128, .sampleRate = rate});
+            std::vector<float> buffer(512), scratch(512);
+            PlanarSampleBufferInlineView view(buffer.data(), 512, 512);
+            PlanarSampleBufferInlineView scratchView(scratch.data(), 512, 512);
+            provider.Play();
+            for(int i = 0; i < 4; i++){
+                while(provider.GetBufferedFrames() < 256){
+                    std::this_thread::yield();
+                }
+                provider.ProvideBufferData(view, scratchView);
+                assert(buffer[511] == 0);
+            }
+            assert(provider.GetUnderrunCount() == 4);
+            assert(provider.GetUnderrunFrames() == 4 * 256);
+            assert(provider.IsPlaying());
+        }
+        std::filesystem::remove(path);
+    }
+    return 0;
+}
+
+int Test_AudioVoiceManager(){
+    constexpr size_t nframes = 512, assetFrames = 5000;
+    // a ramp, so that a sample's value is its position
+    auto makeAsset = []{
+        auto samples = new float[assetFrames];
+        for(size_t i = 0; i < assetFrames; i++){
+            samples[i] = float(i) / assetFrames;
+        }
+        return New<AudioAsset>(InterleavedSampleBufferView{samples, assetFrames}, 1);
+    };
+    auto asset = makeAsset();
+    std::vector<float> buffer(nframes), scratch(nframes);
+    PlanarSampleBufferInlineView view(buffer.data(), nframes, nframes);
+    PlanarSampleBufferInlineView scratchView(scratch.data(), nframes, nframes);
+    
+    // Advance leaves a sampled provider where ProvideBufferData would have
+    for(bool loops : {false, true}){
+        for(size_t start : {size_t(0), size_t(1), assetFrames - 512, assetFrames - 1, assetFrames, assetFrames + 7}){
+            for(size_t n : {size_t(1), size_t(511), size_t(512), assetFrames, assetFrames * 2 + 3}){
+                std::vector<float> big(n), bigScratch(n);
+                PlanarSampleBufferInlineView bigView(big.data(), n, n);
+                PlanarSampleBufferInlineView bigScratchView(bigScratch.data(), n, n);
+                SampledAudioDataProvider rendered(asset), skipped(asset);
+                for(auto p : {&rendered, &skipped}){
+                    p->SetLoop(loops);
+                    p->playhead_pos = start;
+                    p->Play();
+                }
+                rendered.ProvideBufferData(bigView, bigScratchView);
+                skipped.Advance(n);
+                assert(rendered.playhead_pos == skipped.playhead_pos);
+                assert(rendered.IsPlaying() == skipped.IsPlaying());
+            }
+        }
+    }
+    
+    // 10 looping sources in a line, 1m apart, with room for 4
+    constexpr size_t nsources = 10;
+    std::vector<Ref<SampledAudioDataProvider>> providers;
+    for(size_t i = 0; i < nsources; i++){
+        auto p = New<SampledAudioDataProvider>(asset);
+        p->SetLoop(true);
+        p->Play();
+        providers.push_back(p);
+    }
+    AudioVoiceManager manager({.maxVoices = 4, .fadeFrames = 128, .referenceDistance = 1, .hysteresis = 1.25f});
+    auto update = [&]{
+        manager.SetListener(vector3(0, 0, 0));
+        for(size_t i = 0; i < nsources; i++){
+            manager.AddPointSource(providers[i], vector3(i + 1, 0, 0));
+        }
+        manager.AddPointSource(providers[0], vector3(1, 0, 0));     // duplicates are ignored
+        manager.Update();
+    };
+    auto render = [&](const AudioVoiceManager::Voice& voice){
+        manager.Render(voice, view, scratchView);
+    };
+    auto isReal = [&](const Ref<SampledAudioDataProvider>& p, AudioVoiceManager::Fade fade){
+        for(const auto& voice : manager.GetRealVoices()){
+            if (voice.provider == p){
+                return voice.fade == fade;
+            }
+        }
+        return false;
+    };
+    
+    update();
+    assert(manager.GetStatistics().nSources == nsources);
+    assert(manager.GetRealVoices().size() == 4);
+    assert(manager.GetVirtualVoices().size() == nsources - 4);
+    for(size_t i = 0; i < 4; i++){
+        // nearest first, and new sources start unfaded
+        assert(manager.GetRealVoices()[i].provider == providers[i]);
+        assert(manager.GetRealVoices()[i].fade == AudioVoiceManager::Fade::None);
+    }
+    for(int b = 0; b < 3; b++){
+        if (b > 0){
+            update();
+        }
+        for(const auto& voice : manager.GetRealVoices()){
+            render(voice);
+        }
+        manager.AdvanceVirtualVoices(nframes);
+    }
+    // real and virtual voices stay in step
+    for(const auto& p : providers){
+        assert(p->playhead_pos == 3 * nframes);
+    }
+    
+    // raising the priority of the farthest source promotes it, and the 4th nearest fades out
+    providers[nsources - 1]->SetPriority(100);
+    update();
+    assert(manager.GetStatistics().nPromoted == 1);
+    assert(manager.GetStatistics().nDemoted == 1);
+    assert(manager.GetRealVoices().size() == 5);
+    assert(isReal(providers[nsources - 1], AudioVoiceManager::Fade::In));
+    assert(isReal(providers[3], AudioVoiceManager::Fade::Out));
+    for(const auto& voice : manager.GetRealVoices()){
+        const auto pos = static_cast<SampledAudioDataProvider*>(voice.provider.get())->playhead_pos;
+        render(voice);
+        if (voice.fade == AudioVoiceManager::Fade::In){
+            // resumes where it would have been, ramping up from silence
+            assert(buffer[0] == 0);
+            assert(buffer[64] == asset->data[0][pos + 64] * 0.5f);
+            assert(buffer[200] == asset->data[0][pos + 200]);
+        }
+        else if (voice.fade == AudioVoiceManager::Fade::Out){
+            assert(buffer[0] == asset->data[0][pos]);
+            assert(buffer[64] == asset->data[0][pos + 64] * 0.5f);
+            assert(buffer[128] == 0 && buffer[nframes - 1] == 0);
+        }
+    }
+    manager.AdvanceVirtualVoices(nframes);
+    update();
+    assert(manager.GetRealVoices().size() == 4);
+    assert(manager.GetStatistics().nPromoted == 0 && manager.GetStatistics().nDemoted == 0);
+    
+    // a virtual source that outscores a real one by less than the hysteresis margin does not replace it
+    providers[4]->SetPriority(2);       // 2/5 against 1/3 for the 3rd nearest
+    update();
+    assert(isReal(providers[2], AudioVoiceManager::Fade::None));
+    assert(!isReal(providers[4], AudioVoiceManager::Fade::In));
+    providers[4]->SetPriority(2.2f);    // now above 1.25/3
+    update();
+    assert(isReal(providers[2], AudioVoiceManager::Fade::Out));
+    assert(isReal(providers[4], AudioVoiceManager::Fade::In));
+    
+    // a one-shot that is virtual the whole time still stops at its end
+    {
+        AudioVoiceManager small({.maxVoices = 1});
+        auto loud = New<SampledAudioDataProvider>(asset), quiet = New<SampledAudioDataProvider>(asset);
+        loud->SetLoop(true);
+        quiet->SetVolume(0.1f);
+        quiet->Play();
+        for(size_t pos = 0; pos < assetFrames + nframes; pos += nframes){
+            small.SetListener(vector3(0, 0, 0));
+            small.AddAmbientSource(loud);
+            small.AddAmbientSource(quiet);
+            small.Update();
+            assert(small.GetVirtualVoices().size() == 1 && small.GetVirtualVoices()[0].provider == quiet);
+            small.AdvanceVirtualVoices(nframes);
+        }
+        assert(!quiet->IsPlaying());
+        assert(quiet->playhead_pos == assetFrames);
+        
+        // sources that leave the scene are forgotten, so they start unfaded when they return
+        small.SetListener(vector3(0, 0, 0));
+        small.Update();
+        assert(small.GetStatistics().nSources == 0);
+        small.SetListener(vector3(0, 0, 0));
+        small.AddAmbientSource(quiet);
+        small.Update();
+        assert(small.GetRealVoices().size() == 1 && small.GetRealVoices()[0].fade == AudioVoiceManager::Fade::None);
+    }
+    return 0;
+}
+
+int Test_AudioDecodeCache(){
+    // the hash is XXH64, so it is stable across versions and platforms
+    assert(DiskCache::Hash("", 0) == 0xEF46DB3751D8E999ULL);
+    assert(DiskCache::Hash("abc", 3) == 0x44BC2CF5AD770999ULL);
+    
+    auto& cache = AudioAsset::GetDecodeCache();
+    const auto previousDirectory = cache.GetDirectory();
+    const auto previousMax = cache.GetMaxBytes();
+    const auto dir = std::filesystem::temp_directory_path() / "rve_test_audio_cache";
+    std::filesystem::remove_all(dir);
+    cache.SetDirectory(dir);
+    cache.SetMaxBytes(64 * 1024 * 1024);
+    
+    constexpr uint32_t fileRate = 48000, outputRate = 44100;
+    auto wavA = GenerateTestWav(fileRate, 2, fileRate * 2);
+    auto same = [](const Ref<AudioAsset>& a, const Ref<AudioAsset>& b){
+        return a->GetNumSamples() == b->GetNumSamples() && a->GetNChanels() == b->GetNChanels() && a->GetLength() == b->GetLength() && std::memcmp(a->GetData(), b->GetData(), a->data.size() * sizeof(float)) == 0;
+    };
+    auto uncached = [&](const std::vector<uint8_t>& wav, uint32_t rate){
+        cache.SetDirectory({});
+        auto asset = New<AudioAsset>(wav, "wav", 1, rate);
+        cache.SetDirectory(dir);
+        return asset;
+    };
+    
+    // cold, then warm
+    auto cold = New<AudioAsset>(wavA, "wav", 1, outputRate);
+    auto stats = cache.GetStatistics();
+    assert(stats.misses == 1 && stats.hits == 0 && stats.stores == 1);
+    auto warm = New<AudioAsset>(wavA, "wav", 1, outputRate);
+    stats = cache.GetStatistics();
+    assert(stats.hits == 1 && stats.stores == 1);
+    assert(same(cold, warm));
+    assert(same(warm, uncached(wavA, outputRate)));
+    
+    // changing one sample of the source invalidates the entry
+    auto wavB = wavA;
+    wavB[wavB.size() / 2] ^= 0x40;
+    auto changed = New<AudioAsset>(wavB, "wav", 1, outputRate);
+    stats = cache.GetStatistics();
+    assert(stats.misses == 2 && stats.stores == 2);
+    assert(!same(changed, warm));
+    assert(same(changed, uncached(wavB, outputRate)));
+    
+    // as does changing the target rate
+    New<AudioAsset>(wavA, "wav", 1, fileRate);
+    assert(cache.GetStatistics().misses == 3);
+    
+    // a damaged entry is a miss, and is replaced
+    std::vector<std::filesystem::path> entries;
+    for(const auto& entry : std::filesystem::directory_iterator(dir)){
+        entries.push_back(entry.path());
+    }
+    assert(entries.size() == 3);
+    for(const auto& entry : entries){
+        std::filesystem::resize_file(entry, std::filesystem::file_size(entry) - 1);
+    }
+    auto repaired = New<AudioAsset>(wavA, "wav", 1, outputRate);
+    stats = cache.GetStatistics();
+    assert(stats.misses == 4 && stats.stores == 4);
+    assert(same(repaired, warm));
+    New<AudioAsset>(wavA, "wav", 1, outputRate);
+    assert(cache.GetStatistics().hits == stats.hits + 1);
+    
+    // least recently used entries are evicted first
+    cache.Clear();
+    const size_t entrySize = warm->data.size() * sizeof(float) + 16;
+    cache.SetMaxBytes(entrySize * 2 + entrySize / 2);
+    auto wavC = wavB;
+    wavC[wavC.size() / 3] ^= 0x40;
+    New<AudioAsset>(wavA, "wav", 1, outputRate);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));     // modification times order the entries
+    New<AudioAsset>(wavB, "wav", 1, outputRate);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    New<AudioAsset>(wavA, "wav", 1, outputRate);                    // A is now newer than B
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto evictionsBefore = cache.GetStatistics().evictions;
+    New<AudioAsset>(wavC, "wav", 1, outputRate);                    // over the limit: B goes
+    stats = cache.GetStatistics();
+    assert(stats.evictions == evictionsBefore + 1);
+    assert(stats.totalBytes <= cache.GetMaxBytes());
+    const auto hitsBefore = stats.hits;
+    New<AudioAsset>(wavA, "wav", 1, outputRate);
+    New<AudioAsset>(wavC, "wav", 1, outputRate);
+    assert(cache.GetStatistics().hits == hitsBefore + 2);
+    New<AudioAsset>(wavB, "wav", 1, outputRate);
+    assert(cache.GetStatistics().hits == hitsBefore + 2);
+    
+    cache.Clear();
+    cache.SetDirectory(previousDirectory);
+    cache.SetMaxBytes(previousMax);
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+// a filter the graph cannot compile, so it runs through process() between compiled ones
+struct InvertFilterLayer : public AudioFilterLayer{
+    void process(const PlanarSampleBufferInlineView& in, PlanarSampleBufferInlineView& out) final{
+        for(uint8_t c = 0; c < in.GetNChannels(); c++){
+            for(size_t i = 0; i < in.sizeOneChannel(); i++){
+                out[c][i] = -in[c][i];
+            }
+        }
+    }
+};
+
+int Test_AudioGraphFilters(){
+    constexpr uint32_t rate = 44100;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> noise(-0.3f, 0.3f);
+    size_t t = 0;
+    auto makeInput = [&](std::vector<float>& buffer){
+        for(auto& sample : buffer){
+            sample = 0.6f * std::sin(t++ * 0.05f) + noise(rng);
+        }
+    };
+    
+    // the compiled graph keeps its own filter state, so running each layer's process() on a copy of the input is an independent reference
+    auto renderReference = [](AudioGraphAsset& graph, PlanarSampleBufferInlineView buffer, PlanarSampleBufferInlineView scratch){
+        for(auto& filter : graph.filters){
+            filter->process(buffer, scratch);
+            std::swap(buffer, scratch);
+        }
+        return buffer;
+    };
+    
+    auto compare = [&](AudioGraphAsset& graph, uint8_t nchannels, size_t nbuffers){
+        const size_t sizes[] = {512, 333, 1, 64, 1024, 7};
+        for(size_t b = 0; b < nbuffers; b++){
+            const auto nframes = sizes[b % std::size(sizes)];
+            std::vector<float> input(nframes * nchannels), compiled, reference, scratchA(input.size()), scratchB(input.size());
+            makeInput(input);
+            compiled = reference = input;
+            PlanarSampleBufferInlineView compiledView(compiled.data(), compiled.size(), nframes), compiledScratch(scratchA.data(), scratchA.size(), nframes);
+            PlanarSampleBufferInlineView referenceView(reference.data(), reference.size(), nframes), referenceScratch(scratchB.data(), scratchB.size(), nframes);
+            graph.Render(compiledView, compiledScratch, nchannels);
+            auto result = renderReference(graph, referenceView, referenceScratch);
+            // the output is always in the buffer that was passed in
+            assert(compiledView.data() == compiled.data());
+            for(size_t i = 0; i < input.size(); i++){
+                const float expected = result.data()[i];
+                assert(std::fabs(compiled[i] - expected) <= 1e-5f * (1 + std::fabs(expected)));
+            }
+        }
+    };
+    
+    auto lowpass = [&]{ return std::make_shared<AudioBiquadFilterLayer>(AudioBiquadFilterLayer::Mode::LowPass, 800.0f, 0.70710678f, rate); };
+    auto highpass = [&]{ return std::make_shared<AudioBiquadFilterLayer>(AudioBiquadFilterLayer::Mode::HighPass, 2000.0f, 2.0f, rate); };
+    auto compressor = [&]{
+        auto layer = std::make_shared<AudioCompressorFilterLayer>(0.3f, 6.0f, 1.5f);
+        layer->sampleRate = rate;
+        return layer;
+    };
+    auto delay = [&](float seconds){
+        auto layer = std::make_shared<AudioDelayFilterLayer>(seconds, 0.5f, 0.4f);
+        layer->maxDelaySeconds = 0.6f;
+        layer->sampleRate = rate;
+        return layer;
+    };
+    
+    for(uint8_t nchannels : {1, 2}){
+        // a fused gain chain
+        {
+            AudioGraphAsset graph(nchannels);
+            for(float gain : {0.5f, 1.5f, 0.8f}){
+                graph.filters.push_back(std::make_shared<AudioGainFilterLayer>(gain));
+            }
+            compare(graph, nchannels, 6);
+        }
+        // each built-in alone, with a delay both shorter and longer than a buffer
+        for(int kind = 0; kind < 5; kind++){
+            AudioGraphAsset graph(nchannels);
+            switch(kind){
+                case 0: graph.filters.push_back(lowpass()); break;
+                case 1: graph.filters.push_back(highpass()); break;
+                case 2: graph.filters.push_back(compressor()); break;
+                case 3: graph.filters.push_back(delay(0.002f)); break;
+                case 4: graph.filters.push_back(delay(0.5f)); break;
+            }
+            compare(graph, nchannels, 60);
+        }
+        // a mix, with custom layers that force the buffers to swap an odd number of times
+        {
+            AudioGraphAsset graph(nchannels);
+            auto lp = lowpass();
+            graph.filters.push_back(std::make_shared<AudioGainFilterLayer>(0.9f));
+            graph.filters.push_back(lp);
+            graph.filters.push_back(compressor());
+            graph.filters.push_back(std::make_shared<InvertFilterLayer>());
+            graph.filters.push_back(delay(0.01f));
+            graph.filters.push_back(highpass());
+            compare(graph, nchannels, 30);
+            // parameters may change between buffers
+            lp->cutoff = 3000;
+            lp->mode = AudioBiquadFilterLayer::Mode::HighPass;
+            compare(graph, nchannels, 30);
+        }
+    }
+    
+    // the filters do what they say: a 10 kHz tone through each biquad
+    {
+        constexpr size_t nframes = 4096;
+        auto rms = [](const std::vector<float>& v, size_t from){
+            double sum = 0;
+            for(size_t i = from; i < v.size(); i++){
+                sum += v[i] * v[i];
+            }
+            return std::sqrt(sum / (v.size() - from));
+        };
+        std::vector<float> tone(nframes), scratch(nframes);
+        for(size_t i = 0; i < nframes; i++){
+            tone[i] = std::sin(2 * 3.14159265f * 10000 * i / rate);
+        }
+        for(auto mode : {AudioBiquadFilterLayer::Mode::LowPass, AudioBiquadFilterLayer::Mode::HighPass}){
+            AudioGraphAsset graph(1);
+            graph.filters.push_back(std::make_shared<AudioBiquadFilterLayer>(mode, 500.0f, 0.70710678f, rate));
+            auto buffer = tone;
+            PlanarSampleBufferInlineView view(buffer.data(), nframes, nframes), scratchView(scratch.data(), nframes, nframes);
+            graph.Render(view, scratchView, 1);
+            const auto ratio = rms(buffer, 512) / rms(tone, 512);
+            if (mode == AudioBiquadFilterLayer::Mode::LowPass){
+                assert(ratio < 0.01);
+            }
+            else{
+                assert(ratio > 0.99 && ratio < 1.01);
+            }
+        }
+    }
+    
+    // an impulse through the delay echoes at the delay time, scaled by wet and then by feedback
+    {
+        constexpr size_t nframes = 1000;
+        AudioGraphAsset graph(1);
+        auto echo = delay(0.005f);     // 220.5 samples, rounded to 221
+        graph.filters.push_back(echo);
+        std::vector<float> buffer(nframes, 0.0f), scratch(nframes);
+        buffer[0] = 1;
+        PlanarSampleBufferInlineView view(buffer.data(), nframes, nframes), scratchView(scratch.data(), nframes, nframes);
+        graph.Render(view, scratchView, 1);
+        assert(buffer[0] == 1);
+        assert(buffer[221] == 0.4f);
+        assert(buffer[442] == 0.4f * 0.5f);
+        assert(buffer[220] == 0 && buffer[222] == 0);
+        
+        // changing the list recompiles it, which starts the delay line over
+        graph.filters.push_front(std::make_shared<AudioGainFilterLayer>(0.25f));
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+        buffer[0] = 1;
+        graph.Render(view, scratchView, 1);
+        assert(buffer[0] == 0.25f);
+        assert(buffer[221] == 0.25f * 0.4f);
+        assert(buffer[999] == 0);
+    }
+    
+    // a compressor leaves quiet input alone and turns loud input down
+    {
+        constexpr size_t nframes = 8192;
+        AudioGraphAsset graph(1);
+        graph.filters.push_back(compressor());
+        std::vector<float> buffer(nframes), scratch(nframes);
+        for(size_t i = 0; i < nframes; i++){
+            buffer[i] = (i < nframes / 2 ? 0.1f : 0.9f) * (i % 2 ? 1 : -1);
+        }
+        PlanarSampleBufferInlineView view(buffer.data(), nframes, nframes), scratchView(scratch.data(), nframes, nframes);
+        graph.Render(view, scratchView, 1);
+        assert(std::fabs(buffer[nframes / 2 - 1]) == 0.1f * 1.5f);
+        // 0.9 is 9.5 dB over 0.3, so at 6:1 the output settles 1.6 dB over it
+        const float settled = 0.3f * std::pow(3.0f, 1.0f / 6) * 1.5f;
+        assert(std::fabs(std::fabs(buffer[nframes - 1]) - settled) < 1e-3f);
+    }
+
+    // one graph shared by several voices rendering at once, as sources do from the audio tasks. Each voice keeps its
+    // own state, so every voice hears exactly what a voice rendering alone would.
+    {
+        constexpr size_t nframes = 256, nbuffers = 40, nvoices = 4;
+        AudioGraphAsset graph(1);
+        graph.filters.push_back(std::make_shared<AudioGainFilterLayer>(0.8f));
+        graph.filters.push_back(lowpass());
+        graph.filters.push_back(delay(0.003f));
+        graph.filters.push_back(compressor());
+        auto renderVoice = [&](std::vector<float>& output){
+            AudioGraphState state;
+            std::vector<float> buffer(nframes), scratch(nframes);
+            for(size_t b = 0; b < nbuffers; b++){
+                for(size_t i = 0; i < nframes; i++){
+                    buffer[i] = std::sin(0.05f * float(b * nframes + i));
+                }
+                PlanarSampleBufferInlineView view(buffer.data(), nframes, nframes), scratchView(scratch.data(), nframes, nframes);
+                graph.Render(view, scratchView, 1, state);
+                output.insert(output.end(), buffer.begin(), buffer.end());
+            }
+        };
+        std::vector<float> alone;
+        renderVoice(alone);
+        std::vector<std::vector<float>> outputs(nvoices);
+        std::vector<std::thread> voices;
+        for(auto& output : outputs){
+            voices.emplace_back([&]{ renderVoice(output); });
+        }
+        for(auto& voice : voices){
+            voice.join();
+        }
+        for(const auto& output : outputs){
+            assert(output == alone);
+        }
+    }
+    return 0;
+}
+
+int Test_AudioRoomRenderer(){
+    constexpr size_t nframes = 512, nrooms = 12;
+    constexpr uint8_t nchannels = 2;
+    
+    // each room produces a distinct signal and runs a little effect processing in its scratch buffer.
+    // Early rooms take longest, so with several workers the rooms finish out of order.
+    std::atomic<size_t> dirtyScratch = 0;
+    auto renderRoom = [&](size_t room, PlanarSampleBufferInlineView& buffer, PlanarSampleBufferInlineView& scratch){
+        for(size_t i = 0; i < scratch.size(); i++){
+            dirtyScratch += scratch.data()[i] != 0;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds((nrooms - room) * 200));
+        for(uint8_t c = 0; c < buffer.GetNChannels(); c++){
+            for(size_t i = 0; i < buffer.sizeOneChannel(); i++){
+                buffer[c][i] = 0.01f * std::sin(0.001f * (room + 1) * i + c) + 1e-7f * room;
+                scratch[c][i] = buffer[c][i] * 0.5f;
+                buffer[c][i] += scratch[c][i] * 0.3f;
+            }
+        }
+    };
+    
+    // the serial reference: each room rendered and blended in order, the way AudioPlayer used to
+    std::vector<float> reference(nframes * nchannels, 0.25f);
+    {
+        std::vector<float> room(reference.size()), scratch(reference.size());
+        for(size_t r = 0; r < nrooms; r++){
+            std::fill(room.begin(), room.end(), 0.0f);
+            std::fill(scratch.begin(), scratch.end(), 0.0f);
+            PlanarSampleBufferInlineView roomView(room.data(), room.size(), nframes), scratchView(scratch.data(), scratch.size(), nframes);
+            renderRoom(r, roomView, scratchView);
+            AudioMixing::Scalar::BlendPlanarToInterleaved(reference.data(), room.data(), nframes, nframes, nchannels);
+        }
+    }
+    
+    AudioRoomRenderer renderer(0);
+    for(uint32_t nworkers : {0, 1, 4, 8, 3}){
+        renderer.SetWorkerCount(nworkers);
+        assert(renderer.GetWorkerCount() == nworkers);
+        // run twice, so the second pass reuses buffers the first left dirty
+        for(int pass = 0; pass < 2; pass++){
+            std::vector<float> output(reference.size(), 0.25f);
+            renderer.Render(nrooms, renderRoom, output, nchannels);
+            // the reduction is in room order, so the result is bit-identical to the serial one
+            assert(std::memcmp(output.data(), reference.data(), output.size() * sizeof(float)) == 0);
+            
+            const auto& times = renderer.GetRoomMicroseconds();
+            assert(times.size() == nrooms);
+            for(size_t r = 0; r < nrooms; r++){
+                assert(times[r] >= (nrooms - r) * 200);
+            }
+            const auto& stats = renderer.GetStatistics();
+            assert(stats.nRooms == nrooms);
+            assert(stats.nWorkers == nworkers);
+            assert(stats.maxRoomMicroseconds >= times[0]);
+            assert(stats.totalRoomMicroseconds >= stats.maxRoomMicroseconds);
+            assert(stats.wallMicroseconds >= stats.maxRoomMicroseconds);
+            if (nworkers == 0){
+                assert(stats.wallMicroseconds >= stats.totalRoomMicroseconds);
+            }
+        }
+    }
+    assert(dirtyScratch == 0);
+    
+    // fewer rooms than before, and none at all
+    std::vector<float> output(reference.size(), 0);
+    renderer.Render(1, renderRoom, output, nchannels);
+    assert(renderer.GetRoomMicroseconds().size() == 1);
+    std::fill(output.begin(), output.end(), 0.5f);
+    renderer.Render(0, renderRoom, output, nchannels);
+    assert(renderer.GetStatistics().nRooms == 0);
+    assert(std::all_of(output.begin(), output.end(), [](float s){ return s == 0.5f; }));
+    
+    return 0;
+}
+
+int Test_AudioSnapshotPublisher(){
+    constexpr size_t nframes = 512, assetFrames = 20000, nsources = 60, nambient = 8, nrooms = 3;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f), place(-30, 30), chance(0, 1);
+    auto samples = new float[assetFrames];
+    for(size_t i = 0; i < assetFrames; i++){
+        samples[i] = noise(rng);
+    }
+    auto asset = New<AudioAsset>(InterleavedSampleBufferView{samples, assetFrames}, 1);
+    
+    // the scene is rendered twice, from a snapshot rebuilt every tick and from the published one, with identical sources
+    struct Path{
+        std::vector<Ref<SampledAudioDataProvider>> sources, ambient;
+        AudioVoiceManager manager{{.maxVoices = 12}};
+        std::vector<float> mix = std::vector<float>(nframes), buffer = std::vector<float>(nframes), scratch = std::vector<float>(nframes);
+    } rebuilt, published;
+    for(auto path : {&rebuilt, &published}){
+        for(size_t i = 0; i < nsources + nambient; i++){
+            auto p = New<SampledAudioDataProvider>(asset);
+            p->SetLoop(true);
+            p->playhead_pos = (i * 997) % assetFrames;
+            p->SetVolume(0.5f + i * 0.001f);     // no two ambient sources tie when ranked
+            p->Play();
+            (i < nsources ? path->sources : path->ambient).push_back(p);
+        }
+    }
+    std::vector<Ref<AudioRoom::RoomData>> rooms;
+    for(size_t i = 0; i < nrooms; i++){
+        rooms.push_back(New<AudioRoom::RoomData>(2, nframes, 44100));
+    }
+    
+    struct Placed{
+        bool present = false, moving = false;
+        vector3 pos{0, 0, 0};
+    };
+    std::vector<Placed> sourceState(nsources), ambientState(nambient), roomState(nrooms);
+    bool frozen = false;
+    auto step = [&]{
+        if (frozen){
+            return;
+        }
+        for(auto& s : sourceState){
+            if (chance(rng) < 0.05f){
+                s.present = !s.present;
+                s.pos = vector3(place(rng), 0, place(rng));
+                s.moving = chance(rng) < 0.3f;
+            }
+            if (s.moving){
+                s.pos.x += 0.1f;
+            }
+        }
+        for(auto& s : ambientState){
+            if (chance(rng) < 0.05f){
+                s.present = !s.present;
+            }
+        }
+        for(auto& r : roomState){
+            r.present = true;
+            if (chance(rng) < 0.02f){
+                r.pos = vector3(place(rng), 0, place(rng));
+            }
+        }
+    };
+    
+    AudioSnapshotPublisher publisher;
+    AudioSnapshot reference;
+    const vector3 listenerPos(1, 2, 3);
+    const quaternion listenerRot(1, 0, 0, 0);
+    auto update = [&]{
+        // the rebuilt snapshot lists everything in a different order every tick
+        reference.Clear();
+        reference.listenerPos = listenerPos;
+        reference.listenerRot = listenerRot;
+        std::vector<size_t> order(nsources);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        for(auto i : order){
+            if (sourceState[i].present){
+                reference.sources.emplace_back(rebuilt.sources[i], sourceState[i].pos, quaternion(1, 0, 0, 0));
+            }
+        }
+        for(size_t i = 0; i < nambient; i++){
+            if (ambientState[i].present){
+                reference.ambientSources.push_back(rebuilt.ambient[i]);
+            }
+        }
+        
+        publisher.BeginUpdate();
+        publisher.SetListener(listenerPos, listenerRot, nullptr);
+        for(size_t i = 0; i < nsources; i++){
+            if (sourceState[i].present){
+                publisher.UpdateSource(published.sources[i], sourceState[i].pos, quaternion(1, 0, 0, 0));
+            }
+        }
+        for(size_t i = 0; i < nambient; i++){
+            if (ambientState[i].present){
+                publisher.UpdateAmbientSource(published.ambient[i]);
+            }
+        }
+        for(size_t i = 0; i < nrooms; i++){
+            publisher.UpdateRoom(rooms[i], roomState[i].pos, quaternion(1, 0, 0, 0));
+        }
+        publisher.EndUpdate();
+    };
+    
+    // the published snapshot holds exactly the scene of the last update, in any order
+    auto checkSnapshot = [&](const AudioSnapshot& snapshot){
+        assert(snapshot.listenerPos == listenerPos);
+        assert(snapshot.sources.size() == reference.sources.size());
+        assert(snapshot.ambientSources.size() == reference.ambientSources.size());
+        for(const auto& source : snapshot.sources){
+            auto index = std::find(published.sources.begin(), published.sources.end(), source.data) - published.sources.begin();
+            assert(index < nsources);
+            assert(sourceState[index].present && source.worldpos == sourceState[index].pos);
+        }
+        for(const auto& source : snapshot.ambientSources){
+            auto index = std::find(published.ambient.begin(), published.ambient.end(), source) - published.ambient.begin();
+            assert(index < nambient && ambientState[index].present);
+        }
+        assert(snapshot.rooms.size() == nrooms);
+        for(const auto& room : snapshot.rooms){
+            auto index = std::find(rooms.begin(), rooms.end(), room.room) - rooms.begin();
+            assert(index < nrooms && room.worldpos == roomState[index].pos);
+        }
+    };
+    
+    auto render = [&](Path& path, const AudioSnapshot& snapshot){
+        PlanarSampleBufferInlineView view(path.buffer.data(), nframes, nframes), scratchView(path.scratch.data(), nframes, nframes);
+        path.manager.Update(snapshot);
+        std::fill(path.mix.begin(), path.mix.end(), 0.0f);
+        // voices fading out are listed in the order they were found, so sort to make the mix order-independent
+        auto voices = path.manager.GetRealVoices();
+        std::sort(voices.begin(), voices.end(), [](const auto& a, const auto& b){ return a.score > b.score; });
+        for(const auto& voice : voices){
+            path.manager.Render(voice, view, scratchView);
+            AudioMixing::AdditiveBlend(path.mix.data(), path.buffer.data(), nframes);
+        }
+        path.manager.AdvanceVirtualVoices(nframes);
+    };
+    
+    // before the first update, the audio thread sees an empty scene
+    assert(publisher.AcquireLatest()->sources.empty());
+    
+    for(size_t tick = 0; tick < 400; tick++){
+        step();
+        update();
+        const auto& snapshot = *publisher.AcquireLatest();
+        checkSnapshot(snapshot);
+        assert(publisher.AcquireLatest() == &snapshot);     // nothing new was published
+        render(rebuilt, reference);
+        render(published, snapshot);
+        // identical audio, because ranking does not depend on the order sources are listed in
+        assert(std::memcmp(rebuilt.mix.data(), published.mix.data(), nframes * sizeof(float)) == 0);
+    }
+    
+    // a still scene costs nothing once every snapshot has caught up
+    frozen = true;
+    for(int i = 0; i < 4; i++){
+        update();
+        publisher.AcquireLatest();
+    }
+    assert(publisher.GetStatistics().nChanged == 0);
+    assert(publisher.GetStatistics().nRemoved == 0);
+    assert(publisher.GetStatistics().nCopied == 0);
+    frozen = false;
+    
+    // a reader that holds on to a snapshot for a long time gets a complete scene when it comes back
+    auto held = publisher.AcquireLatest();
+    const auto heldGeneration = held->generation;
+    for(size_t tick = 0; tick < 100; tick++){
+        step();
+        update();
+        assert(held->generation == heldGeneration);     // never written while the reader has it
+    }
+    for(size_t tick = 0; tick < 5; tick++){
+        checkSnapshot(*publisher.AcquireLatest());
+        step();
+        update();
+    }
+    checkSnapshot(*publisher.AcquireLatest());
+    
+    return 0;
+}
+
+// exposes the solver, so tests can step physics without running the rest of the tick
+struct PhysicsTestWorld : public World{
+    PhysicsSolver& GetSolver(){
+        return *Solver;
+    }
+};
+
+int Test_PhysicsInterpolation(){
+    PhysicsTestWorld w;
+    auto& solver = w.GetSolver();
+    assert(solver.GetInterpolationFactor() == 1);     // variable step by default
+    
+    // a tick is 1/30 s and a step 1/45 s, so ticks alternate between one and two steps
+    constexpr float fixedStep = 1.0f / 45, speed = 3;
+    const float tickTime = 1 / (App::evalNormal / 2);
+    solver.SetFixedStep(fixedStep);
+    
+    auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+    auto mover = w.CreatePrototype<GameObject>();
+    auto& moverBody = mover.EmplaceComponent<RigidBodyDynamicComponent>();
+    moverBody.EmplaceCollider<SphereCollider>(0.5, material);
+    moverBody.SetGravityEnabled(false);
+    moverBody.SetLinearVelocity(vector3(speed, 0, 0), true);
+    
+    auto sleeper = w.CreatePrototype<GameObject>();
+    sleeper.GetTransform().SetWorldPosition(vector3(0, 10, 0));
+    auto& sleeperBody = sleeper.EmplaceComponent<RigidBodyDynamicComponent>();
+    sleeperBody.EmplaceCollider<SphereCollider>(0.5, material);
+    sleeperBody.SetGravityEnabled(false);
+    sleeperBody.Sleep();
+    
+    auto tick = [&]{
+        solver.Tick(1);
+        solver.SyncActiveActors();
+    };
+    
+    // the blended pose trails real time by exactly one step, while the Transform jumps a whole step at a time
+    float elapsed = 0;
+    int nsteps = 0;
+    for(int t = 0; t < 12; t++){
+        tick();
+        elapsed += tickTime;
+        nsteps = int((elapsed + 1e-4f) / fixedStep);
+        const auto alpha = solver.GetInterpolationFactor();
+        assert(alpha >= 0 && alpha < 1);
+        assert(std::abs(alpha - (elapsed - nsteps * fixedStep) / fixedStep) < 1e-3);
+        assert(std::abs(mover.GetTransform().GetWorldPosition().x - speed * nsteps * fixedStep) < 1e-3);
+        if (nsteps >= 2){
+            vector3 pos;
+            quaternion rot;
+            assert(solver.GetInterpolatedPose(mover.id, pos, rot));
+            assert(std::abs(pos.x - speed * (elapsed - fixedStep)) < 1e-3);
+        }
+    }
+    const auto& moving = solver.GetInterpolatingBodies();
+    assert(std::find(moving.begin(), moving.end(), mover.id) != moving.end());
+    
+    // a body that never moved is never blended
+    {
+        vector3 pos;
+        quaternion rot;
+        assert(!solver.GetInterpolatedPose(sleeper.id, pos, rot));
+        assert(std::find(moving.begin(), moving.end(), sleeper.id) == moving.end());
+    }
+    
+    // the solver's bookkeeping does not allocate once it has grown to the scene
+    const auto before = MemoryTracker::GetStatistics(MemoryTag::Containers).allocations;
+    for(int t = 0; t < 100; t++){
+        tick();
+    }
+    assert(MemoryTracker::GetStatistics(MemoryTag::Containers).allocations == before);
+    
+    // a body that stops rests at its final pose, and leaves the list after one more step
+    moverBody.Sleep();
+    for(int t = 0; t < 4; t++){
+        tick();
+    }
+    {
+        vector3 pos;
+        quaternion rot;
+        assert(solver.GetInterpolatedPose(mover.id, pos, rot));
+        assert(pos == mover.GetTransform().GetWorldPosition());
+        assert(std::find(moving.begin(), moving.end(), mover.id) == moving.end());
+    }
+    
+    // going back to a variable step simulates the whole tick and stops blending
+    solver.SetFixedStep(0);
+    tick();
+    assert(solver.GetInterpolationFactor() == 1);
+    
+    return 0;
+}
+
+int Test_PhysicsBatchQueries(){
+    PhysicsTestWorld w;
+    auto& solver = w.GetSolver();
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> place(-20, 20), unit(-1, 1), extent(0.2, 2);
+    
+    // a cloud of boxes and spheres in two layers, half of them static
+    auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+    for(int i = 0; i < 400; i++){
+        auto e = w.CreatePrototype<GameObject>();
+        e.GetTransform().SetWorldPosition(vector3(place(rng), place(rng), place(rng)));
+        const physx::PxU32 group = (i % 3 == 0) ? FilterLayers::L1 : FilterLayers::L0;
+        if (i % 2 == 0){
+            auto& body = e.EmplaceComponent<RigidBodyStaticComponent>(group, group);
+            body.EmplaceCollider<BoxCollider>(vector3(extent(rng), extent(rng), extent(rng)), material);
+            body.setDynamicsWorldPose(e.GetTransform().GetWorldPosition(), e.GetTransform().GetWorldRotation());     // PhysicsLinkSystemWrite does this in a full tick
+        }
+        else{
+            auto& body = e.EmplaceComponent<RigidBodyDynamicComponent>(group, group);
+            body.EmplaceCollider<SphereCollider>(extent(rng), material);
+            body.SetGravityEnabled(false);
+        }
+    }
+    // a box far from the cloud, to test positions exactly
+    auto lone = w.CreatePrototype<GameObject>();
+    lone.GetTransform().SetWorldPosition(vector3(0, 0, 200));
+    auto& loneBody = lone.EmplaceComponent<RigidBodyStaticComponent>();
+    loneBody.EmplaceCollider<BoxCollider>(vector3(1, 1, 1), material);
+    loneBody.setDynamicsWorldPose(vector3(0, 0, 200), quaternion(1, 0, 0, 0));
+    solver.FlushActorChanges();     // new bodies join the scene before the next step, which this test does not take
+    
+    constexpr size_t nqueries = 2000, maxHits = 4, allHits = 64;
+    std::vector<PhysicsSolver::RayQuery> rays(nqueries);
+    for(auto& ray : rays){
+        ray = {vector3(place(rng), place(rng), place(rng)) * decimalType(2), glm::normalize(vector3(unit(rng), unit(rng), unit(rng)) + vector3(0, 0, 1e-3)), 100};
+    }
+    std::vector<PhysicsSolver::RaycastHit> nearest(nqueries), few(nqueries * maxHits), all(nqueries * allHits);
+    std::vector<PhysicsSolver::BatchResult> nearestResults(nqueries), fewResults(nqueries), allResults(nqueries);
+    
+    // one hit per ray finds the same hit as a single raycast
+    auto total = solver.RaycastBatch(rays, nearest, nearestResults);
+    size_t nhit = 0;
+    for(size_t i = 0; i < nqueries; i++){
+        PhysicsSolver::RaycastHit single;
+        const bool hit = solver.Raycast(rays[i].origin, rays[i].direction, rays[i].maxDistance, single);
+        assert(hit == (nearestResults[i].nHits == 1));
+        if (hit){
+            assert(nearest[i].getEntity().id == single.getEntity().id);
+            assert(nearest[i].hitDistance == single.hitDistance);
+            nhit++;
+        }
+    }
+    assert(total == nhit);
+    assert(nhit > nqueries / 10 && nhit < nqueries);      // the scene is neither empty nor solid
+    
+    // several hits per ray are the nearest ones, in order, and the nearest of them is the single hit
+    solver.RaycastBatch(rays, few, fewResults, maxHits);
+    solver.RaycastBatch(rays, all, allResults, allHits);
+    for(size_t i = 0; i < nqueries; i++){
+        assert(!allResults[i].overflowed);
+        assert(fewResults[i].nHits == std::min<uint32_t>(allResults[i].nHits, maxHits));
+        assert(fewResults[i].overflowed == (allResults[i].nHits > maxHits));
+        for(uint32_t h = 0; h < fewResults[i].nHits; h++){
+            assert(std::abs(few[i * maxHits + h].hitDistance - all[i * allHits + h].hitDistance) < 1e-4);
+            if (h > 0){
+                assert(few[i * maxHits + h].hitDistance >= few[i * maxHits + h - 1].hitDistance);
+            }
+        }
+        if (fewResults[i].nHits > 0){
+            assert(std::abs(few[i * maxHits].hitDistance - nearest[i].hitDistance) < 1e-4);
+        }
+    }
+    
+    // filtered queries only hit what they select
+    PhysicsSolver::QueryFilter layerOne;
+    layerOne.layers = FilterLayers::L1;
+    PhysicsSolver::QueryFilter dynamicOnly;
+    dynamicOnly.statics = false;
+    for(const auto& filter : {layerOne, dynamicOnly}){
+        total = solver.RaycastBatch(rays, all, allResults, allHits, filter);
+        assert(total > 0);
+        for(size_t i = 0; i < nqueries; i++){
+            for(uint32_t h = 0; h < allResults[i].nHits; h++){
+                auto e = all[i * allHits + h].getEntity();
+                auto& body = e.GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0];
+                assert(body.filterGroup & filter.layers);
+                assert(filter.statics || body.rigidActor->is<physx::PxRigidDynamic>());
+            }
+        }
+    }
+    
+    // overlaps agree with single overlaps, and report whether there were more than fit
+    std::vector<PhysicsSolver::QueryShape> shapes(nqueries);
+    for(size_t i = 0; i < nqueries; i++){
+        const vector3 pos(place(rng), place(rng), place(rng));
+        const auto rot = glm::normalize(quaternion(unit(rng), unit(rng), unit(rng), unit(rng)));
+        switch(i % 3){
+            case 0: shapes[i] = PhysicsSolver::QueryShape::Sphere(pos, extent(rng)); break;
+            case 1: shapes[i] = PhysicsSolver::QueryShape::Box(pos, rot, vector3(extent(rng), extent(rng), extent(rng))); break;
+            default: shapes[i] = PhysicsSolver::QueryShape::Capsule(pos, rot, extent(rng), extent(rng)); break;
+        }
+    }
+    std::vector<PhysicsSolver::OverlapHit> overlaps(nqueries * allHits), fewOverlaps(nqueries * 2);
+    solver.OverlapBatch(shapes, overlaps, allResults, allHits);
+    solver.OverlapBatch(shapes, fewOverlaps, fewResults, 2);
+    for(size_t i = 0; i < nqueries; i++){
+        const auto& shape = shapes[i];
+        PhysicsSolver::OverlapHit single;
+        bool hit;
+        switch(shape.type){
+            case PhysicsSolver::QueryShape::Type::Sphere: hit = solver.SphereOverlap(shape.origin, shape.size.x, single); break;
+            case PhysicsSolver::QueryShape::Type::Box: hit = solver.BoxOverlap(shape.origin, shape.rotation, shape.size, single); break;
+            default: hit = solver.CapsuleOverlap(shape.origin, shape.rotation, shape.size.x, shape.size.y, single); break;
+        }
+        assert(hit == (allResults[i].nHits > 0));
+        if (hit){
+            auto begin = overlaps.begin() + i * allHits, end = begin + allResults[i].nHits;
+            assert(std::find_if(begin, end, [&](const auto& h){ return h.getEntity().id == single.getEntity().id; }) != end);
+        }
+        assert(fewResults[i].nHits == std::min<uint32_t>(allResults[i].nHits, 2));
+        assert(fewResults[i].overflowed == (allResults[i].nHits > 2));
+    }
+    
+    // overlaps use the z coordinate they are given
+    {
+        PhysicsSolver::OverlapHit single;
+        assert(solver.SphereOverlap(vector3(0, 0, 200), 0.5, single));
+        assert(single.getEntity().id == lone.id);
+        assert(!solver.SphereOverlap(vector3(0, 200, 0), 0.5, single));
+    }
+    
+    // a sphere swept down onto the lone box stops when it touches the top face
+    {
+        const PhysicsSolver::SweepQuery sweeps[] = {
+            {PhysicsSolver::QueryShape::Sphere(vector3(0, 10, 200), 0.5), vector3(0, -1, 0), 100},
+            {PhysicsSolver::QueryShape::Box(vector3(0, 10, 200), quaternion(1, 0, 0, 0), vector3(0.5, 0.5, 0.5)), vector3(0, -1, 0), 100},
+            {PhysicsSolver::QueryShape::Sphere(vector3(0, 10, 200), 0.5), vector3(0, 1, 0), 100},
+        };
+        PhysicsSolver::RaycastHit sweepHits[std::size(sweeps) * maxHits];
+        PhysicsSolver::BatchResult sweepResults[std::size(sweeps)];
+        for(uint32_t max : {uint32_t(1), uint32_t(maxHits)}){
+            total = solver.SweepBatch(sweeps, std::span(sweepHits, std::size(sweeps) * max), sweepResults, max);
+            assert(total == 2);
+            for(int s = 0; s < 2; s++){
+                const auto& hit = sweepHits[s * max];
+                assert(sweepResults[s].nHits == 1);
+                assert(hit.getEntity().id == lone.id);
+                assert(std::abs(hit.hitDistance - 8.5) < 1e-3);
+                assert(std::abs(hit.hitNormal.y - 1) < 1e-3);
+            }
+            assert(sweepResults[2].nHits == 0);
+        }
+    }
+    
+    // batches issued from workers while a step is in flight. A worker waiting for its chunks may pick up the fetch,
+    // which takes the write lock, so no chunk's read lock may be held while it waits.
+    for(int t = 0; t < 10; t++){
+        std::vector<PhysicsSolver::RaycastHit> duringHits(nqueries);
+        std::vector<PhysicsSolver::BatchResult> duringResults(nqueries);
+        uint32_t duringTotal = 0;
+        tf::Taskflow flow;
+        auto begin = flow.emplace([&]{ solver.BeginTick(1); });
+        auto query = flow.emplace([&]{ duringTotal = solver.RaycastBatch(rays, duringHits, duringResults); });
+        auto fetch = flow.emplace([&]{ solver.FinishTick(); });
+        begin.precede(query, fetch);
+        GetApp()->executor.run(flow).wait();
+        // the overlapping spheres push apart as the cloud steps, so the hits change a little from the ones above
+        assert(duringTotal > nqueries / 10 && duringTotal < nqueries);
+    }
+    
+    return 0;
+}
+
+int Test_PhysicsContactEvents(){
+    PhysicsTestWorld w;
+    auto& solver = w.GetSolver();
+    auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+    
+    // the ground's top face is at y = 1
+    auto ground = w.CreatePrototype<GameObject>();
+    ground.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(50, 1, 50), material);
+    
+    // a trigger volume that the first box falls through
+    auto zone = w.CreatePrototype<GameObject>();
+    auto& zoneBody = zone.EmplaceComponent<RigidBodyStaticComponent>();
+    auto zoneCollider = zoneBody.EmplaceCollider<BoxCollider>(vector3(1, 0.5, 1), material);
+    zoneBody.GetColliderForHandle(zoneCollider).SetType(PhysicsCollider::CollisionType::Trigger);
+    zoneBody.setDynamicsWorldPose(vector3(0, 4, 0), quaternion(1, 0, 0, 0));
+    
+    auto makeBox = [&](const vector3& pos){
+        auto e = w.CreatePrototype<GameObject>();
+        e.GetTransform().SetWorldPosition(pos);
+        e.EmplaceComponent<RigidBodyDynamicComponent>().EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+        return e;
+    };
+    auto box = makeBox(vector3(0, 7, 0));
+    auto doomed = makeBox(vector3(10, 3, 0));
+    box.GetComponent<RigidBodyDynamicComponent>().SetWantsContactData(true);
+    
+    // every call each receiver gets, and where each dispatch starts
+    struct Call{
+        entity_t receiver, other;
+        char kind;
+        size_t npoints;
+    };
+    std::vector<Call> calls;
+    std::vector<size_t> dispatchStarts;
+    std::vector<std::shared_ptr<PhysicsCallback>> callbacks;
+    auto listen = [&](Entity e){
+        auto cb = std::make_shared<PhysicsCallback>();
+        const auto id = e.id;
+        cb->OnColliderEnter = [&calls, id](PhysicsBodyComponent& other, const ContactPairPoint*, size_t n){ calls.push_back({id, other.GetOwner().id, 'E', n}); };
+        cb->OnColliderPersist = [&calls, id](PhysicsBodyComponent& other, const ContactPairPoint*, size_t n){ calls.push_back({id, other.GetOwner().id, 'P', n}); };
+        cb->OnColliderExit = [&calls, id](PhysicsBodyComponent& other, const ContactPairPoint*, size_t n){ calls.push_back({id, other.GetOwner().id, 'X', n}); };
+        cb->OnTriggerEnter = [&calls, id](PhysicsBodyComponent& other){ calls.push_back({id, other.GetOwner().id, 'T', 0}); };
+        cb->OnTriggerExit = [&calls, id](PhysicsBodyComponent& other){ calls.push_back({id, other.GetOwner().id, 't', 0}); };
+        e.GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0].AddReceiver(cb);
+        callbacks.push_back(cb);
+        return cb;
+    };
+    auto groundListener = listen(ground);
+    listen(zone);
+    listen(box);
+    listen(doomed);
+    
+    // the ground destroys the second box as soon as it lands, which drops the rest of that contact's deliveries
+    bool destroyed = false;
+    groundListener->OnColliderEnter = [&](PhysicsBodyComponent& other, const ContactPairPoint*, size_t n){
+        calls.push_back({ground.id, other.GetOwner().id, 'E', n});
+        if (other.GetOwner().id == doomed.id){
+            Entity(doomed.id).Destroy();
+            destroyed = true;
+        }
+    };
+    
+    bool sawLanding = false;
+    for(int t = 0; t < 90; t++){
+        const auto before = calls.size();
+        solver.Tick(1);
+        assert(calls.size() == before);     // nothing is delivered from inside the step
+        for(const auto& event : solver.GetEvents()){
+            if (event.a == ground.id && event.b == box.id && (event.flags & PhysicsSolver::ContactEvent::Begin) && !(event.flags & PhysicsSolver::ContactEvent::Trigger)){
+                sawLanding = true;
+                assert(std::abs(event.point.y - 1) < 0.05);
+                assert(std::abs(std::abs(event.normal.y) - 1) < 1e-3);
+                assert(std::abs(event.impulse.y) > 0);
+                assert(event.nPoints > 0);
+                assert(event.firstPoint + event.nPoints <= solver.GetEventPoints().size());
+                assert(solver.GetEventPoints()[event.firstPoint].position == event.point);
+            }
+        }
+        dispatchStarts.push_back(calls.size());
+        solver.DispatchEvents();
+        assert(solver.GetEvents().empty());
+    }
+    assert(sawLanding);
+    assert(destroyed);
+    
+    auto find = [&](entity_t receiver, entity_t other, char kind){
+        return std::find_if(calls.begin(), calls.end(), [&](const Call& c){
+            return c.receiver == receiver && c.other == other && c.kind == kind;
+        });
+    };
+    // the box passes through the trigger, then lands and rests, and every callback sees the same events from its side
+    auto enterZone = find(box.id, zone.id, 'T'), leaveZone = find(box.id, zone.id, 't'), land = find(box.id, ground.id, 'E'), rest = find(box.id, ground.id, 'P');
+    assert(enterZone < leaveZone && leaveZone < land && land < rest && rest != calls.end());
+    assert(find(zone.id, box.id, 'T') != calls.end());
+    assert(land->npoints > 0);      // the box wants contact data
+    assert(find(ground.id, box.id, 'E')->npoints == land->npoints);
+    assert(find(ground.id, doomed.id, 'E')->npoints == 0);
+    
+    // the destroyed box never heard about its own landing
+    assert(std::none_of(calls.begin(), calls.end(), [&](const Call& c){ return c.receiver == doomed.id; }));
+    
+    // within a dispatch, each receiver's calls are contiguous
+    dispatchStarts.push_back(calls.size());
+    for(size_t d = 0; d + 1 < dispatchStarts.size(); d++){
+        std::vector<entity_t> seen;
+        for(auto c = dispatchStarts[d]; c < dispatchStarts[d + 1]; c++){
+            if (seen.empty() || seen.back() != calls[c].receiver){
+                assert(std::find(seen.begin(), seen.end(), calls[c].receiver) == seen.end());
+                seen.push_back(calls[c].receiver);
+            }
+        }
+    }
+    
+    return 0;
+}
+
+int Test_PhysicsMeshCache(){
+    auto& cache = CookedMeshCache::GetDiskCache();
+    const auto previousDirectory = cache.GetDirectory();
+    const auto dir = std::filesystem::temp_directory_path() / "rve_test_mesh_cache";
+    std::filesystem::remove_all(dir);
+    cache.SetDirectory(dir);
+    CookedMeshCache::ReleaseAll();
+    
+    // a bumpy grid, so that rays measure the cooked surface
+    auto makeGrid = [](uint32_t side, float bump){
+        MeshAsset::MeshPart part;
+        for(uint32_t z = 0; z <= side; z++){
+            for(uint32_t x = 0; x <= side; x++){
+                MeshAsset::vertex_t v{};
+                v.position[0] = x;
+                v.position[1] = std::sin(x * bump) * std::cos(z * bump);
+                v.position[2] = z;
+                part.vertices.push_back(v);
+            }
+        }
+        for(uint32_t z = 0; z < side; z++){
+            for(uint32_t x = 0; x < side; x++){
+                const uint32_t i = z * (side + 1) + x;
+                for(auto index : {i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2}){
+                    part.indices.push_back(index);
+                }
+            }
+        }
+        return New<MeshAsset>(part, MeshAssetOptions{.keepInSystemRAM = true, .uploadToGPU = false});
+    };
+    auto grid = makeGrid(64, 0.3);
+    auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+    
+    const auto base = CookedMeshCache::GetStatistics();
+    auto counted = [&](size_t memoryHits, size_t diskHits, size_t cooked){
+        auto stats = CookedMeshCache::GetStatistics();
+        return stats.memoryHits - base.memoryHits == memoryHits && stats.diskHits - base.diskHits == diskHits && stats.cooked - base.cooked == cooked;
+    };
+    auto triangleMeshOf = [&](PhysicsTestWorld& w, const Ref<MeshAsset>& mesh){
+        auto handle = w.CreatePrototype<GameObject>().EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<MeshCollider>(mesh, material);
+        return static_cast<const physx::PxTriangleMeshGeometry&>(static_cast<physx::PxShape*>(handle.id)->getGeometry()).triangleMesh;
+    };
+    auto convexMeshOf = [&](PhysicsTestWorld& w, const Ref<MeshAsset>& mesh){
+        auto handle = w.CreatePrototype<GameObject>().EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<ConvexMeshCollider>(mesh, material);
+        return static_cast<const physx::PxConvexMeshGeometry&>(static_cast<physx::PxShape*>(handle.id)->getGeometry()).convexMesh;
+    };
+    // rays straight down onto the grid, between its vertices
+    auto castDown = [](PhysicsTestWorld& w){
+        w.GetSolver().FlushActorChanges();
+        std::vector<decimalType> distances;
+        for(int i = 0; i < 100; i++){
+            PhysicsSolver::RaycastHit hit;
+            const bool found = w.GetSolver().Raycast(vector3(0.37 + i * 0.61, 10, 0.71 + i * 0.59), vector3(0, -1, 0), 20, hit);
+            assert(found);
+            distances.push_back(hit.hitDistance);
+        }
+        return distances;
+    };
+    
+    // the first use cooks, and every later use in the process shares the result
+    PhysicsTestWorld cooked, shared;
+    auto cookedMesh = triangleMeshOf(cooked, grid);
+    assert(counted(0, 0, 1));
+    auto sharedMesh = triangleMeshOf(shared, grid);
+    assert(counted(1, 0, 1));
+    assert(sharedMesh == cookedMesh);
+    assert(cookedMesh->getNbTriangles() == 64 * 64 * 2);
+    
+    // once the process forgets it, the mesh comes from disk, and collides the same
+    CookedMeshCache::ReleaseAll();
+    PhysicsTestWorld loaded;
+    auto loadedMesh = triangleMeshOf(loaded, grid);
+    assert(counted(1, 1, 1));
+    assert(loadedMesh != cookedMesh);
+    assert(loadedMesh->getNbTriangles() == cookedMesh->getNbTriangles() && loadedMesh->getNbVertices() == cookedMesh->getNbVertices());
+    assert(castDown(loaded) == castDown(cooked));
+    
+    // moving one vertex makes a different mesh
+    auto changed = makeGrid(64, 0.3);
+    changed->GetSystemCopy().vertices[100].position[1] += 0.5;
+    PhysicsTestWorld other;
+    assert(triangleMeshOf(other, changed) != loadedMesh);
+    assert(counted(1, 1, 2));
+    
+    // convex hulls are cached separately from triangle meshes of the same data
+    auto hull = convexMeshOf(other, grid);
+    assert(counted(1, 1, 3));
+    assert(convexMeshOf(loaded, grid) == hull);
+    assert(counted(2, 1, 3));
+    CookedMeshCache::ReleaseAll();
+    auto loadedHull = convexMeshOf(shared, grid);
+    assert(counted(2, 2, 3));
+    assert(loadedHull->getNbVertices() == hull->getNbVertices() && loadedHull->getNbPolygons() == hull->getNbPolygons());
+    
+    // with the disk cache disabled, forgotten meshes are cooked again
+    CookedMeshCache::ReleaseAll();
+    cache.SetDirectory({});
+    triangleMeshOf(other, grid);
+    assert(counted(2, 2, 4));
+    
+    CookedMeshCache::ReleaseAll();
+    cache.SetDirectory(previousDirectory);
+    std::filesystem::remove_all(dir);
+    return 0;
+}
+
+int Test_PhysicsPoseWrites(){
+    PhysicsTestWorld w;
+    auto& solver = w.GetSolver();
+    auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+    PhysicsLinkSystemWrite write;
+    auto near = [](const std::pair<vector3, quaternion>& pose, const vector3& pos){
+        return glm::distance(pose.first, pos) < 1e-4;
+    };
+    
+    // statics start where their entity is, so a new one needs no write
+    auto wall = w.CreatePrototype<GameObject>();
+    wall.GetTransform().SetWorldPosition(vector3(10, 0, 0));
+    auto& wallBody = wall.EmplaceComponent<RigidBodyStaticComponent>();
+    wallBody.EmplaceCollider<BoxCollider>(vector3(1, 1, 1), material);
+    assert(near(wallBody.getDynamicsWorldPose(), vector3(10, 0, 0)));
+    write(w);
+    assert(write(w) == 0);
+    
+    // a moved static is teleported once
+    wall.GetTransform().SetWorldPosition(vector3(20, 0, 0));
+    assert(write(w) == 1);
+    assert(near(wallBody.getDynamicsWorldPose(), vector3(20, 0, 0)));
+    assert(write(w) == 0);
+    
+    // moving a parent moves the statics under it
+    auto root = w.CreatePrototype<GameObject>();
+    auto child = w.CreatePrototype<GameObject>();
+    root.GetTransform().AddChild(ComponentHandle<Transform>(child.id));
+    child.GetTransform().SetLocalPosition(vector3(0, 5, 0));
+    child.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<SphereCollider>(0.5, material);
+    write(w);
+    root.GetTransform().SetWorldPosition(vector3(0, 0, -30));
+    assert(write(w) == 1);      // the root has no body
+    assert(near(child.GetComponent<RigidBodyStaticComponent>().getDynamicsWorldPose(), vector3(0, 5, -30)));
+    
+    // dynamic bodies are moved by the simulation, not by their Transforms, unless they are kinematic
+    auto mover = w.CreatePrototype<GameObject>();
+    auto& moverBody = mover.EmplaceComponent<RigidBodyDynamicComponent>();
+    moverBody.EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+    moverBody.SetGravityEnabled(false);
+    write(w);
+    mover.GetTransform().SetWorldPosition(vector3(0, 3, 0));
+    assert(write(w) == 0);
+    assert(near(moverBody.getDynamicsWorldPose(), vector3(0, 0, 0)));
+    
+    moverBody.SetKinematic(true);
+    assert(moverBody.IsKinematic());
+    mover.GetTransform().SetWorldPosition(vector3(0, 4, 0));
+    assert(write(w) == 1);
+    assert(near(moverBody.GetKinematicTarget(), vector3(0, 4, 0)));
+    solver.Tick(1);
+    assert(near(moverBody.getDynamicsWorldPose(), vector3(0, 4, 0)));
+    // copying the reached pose back does not count as a change to write
+    solver.SyncActiveActors();
+    assert(glm::distance(mover.GetTransform().GetWorldPosition(), vector3(0, 4, 0)) < 1e-4);
+    assert(write(w) == 0);
+    
+    // the batch setters
+    std::vector<PhysicsBodyComponent::PoseWrite> poses;
+    std::vector<Entity> boxes;
+    for(int i = 0; i < 10; i++){
+        auto e = w.CreatePrototype<GameObject>();
+        e.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+        boxes.push_back(e);
+    }
+    for(int i = 0; i < 10; i++){
+        poses.push_back({&boxes[i].GetComponent<RigidBodyStaticComponent>(), vector3(i, 50, 0), quaternion(1, 0, 0, 0)});
+    }
+    PhysicsBodyComponent::SetDynamicsWorldPoses(poses);
+    for(int i = 0; i < 10; i++){
+        assert(near(boxes[i].GetComponent<RigidBodyStaticComponent>().getDynamicsWorldPose(), vector3(i, 50, 0)));
+    }
+    RigidBodyDynamicComponent::SetKinematicTargets(std::vector<PhysicsBodyComponent::PoseWrite>{{&moverBody, vector3(1, 2, 3), quaternion(1, 0, 0, 0)}});
+    assert(near(moverBody.GetKinematicTarget(), vector3(1, 2, 3)));
+    
+    return 0;
+}
+
+int Test_PhysicsDeferredActors(){
+    PhysicsTestWorld w;
+    auto& solver = w.GetSolver();
+    auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+    auto inScene = [&]{
+        return solver.scene->getNbActors(physx::PxActorTypeFlag::eRIGID_STATIC | physx::PxActorTypeFlag::eRIGID_DYNAMIC);
+    };
+    auto makeWall = [&](decimalType x){
+        auto e = w.CreatePrototype<GameObject>();
+        e.GetTransform().SetWorldPosition(vector3(x, 0, 0));
+        e.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(1, 1, 1), material);
+        return e;
+    };
+    // the entity hit by a ray straight down onto x, with the single and the batched queries
+    auto hitAt = [&](decimalType x){
+        PhysicsSolver::RaycastHit single;
+        const auto found = solver.Raycast(vector3(x, 10, 0), vector3(0, -1, 0), 20, single);
+        PhysicsSolver::RayQuery ray{vector3(x, 10, 0), vector3(0, -1, 0), 20};
+        PhysicsSolver::RaycastHit batched[4];
+        PhysicsSolver::BatchResult results[2];
+        solver.RaycastBatch(std::span(&ray, 1), std::span(batched, 1), std::span(results, 1));
+        solver.RaycastBatch(std::span(&ray, 1), std::span(batched + 1, 3), std::span(results + 1, 1), 3);
+        assert(results[0].nHits == (found ? 1 : 0) && results[1].nHits == results[0].nHits);
+        if (!found){
+            return INVALID_ENTITY;
+        }
+        assert(batched[0].getEntity().id == single.getEntity().id && batched[1].getEntity().id == single.getEntity().id);
+        return single.getEntity().id;
+    };
+    
+    // spawned bodies wait for the next flush
+    auto first = makeWall(0);
+    assert(inScene() == 0);
+    assert(hitAt(0) == INVALID_ENTITY);
+    assert(solver.FlushActorChanges() == 1);
+    assert(inScene() == 1);
+    assert(hitAt(0) == first.id);
+    assert(solver.FlushActorChanges() == 0);
+    
+    // and join the scene in the order they were spawned
+    std::vector<Entity> walls;
+    for(int i = 0; i < 5; i++){
+        walls.push_back(makeWall(10 + i * 5));
+    }
+    assert(solver.FlushActorChanges() == 5);
+    std::vector<physx::PxActor*> actors(inScene());
+    solver.scene->getActors(physx::PxActorTypeFlag::eRIGID_STATIC, actors.data(), physx::PxU32(actors.size()));
+    for(size_t i = 0; i < walls.size(); i++){
+        assert(entity_t(uintptr_t(actors[i + 1]->userData)) == walls[i].id);
+    }
+    
+    // a destroyed body is skipped by queries right away, and leaves the scene at the flush
+    walls[0].Destroy();
+    assert(inScene() == 6);
+    assert(hitAt(10) == INVALID_ENTITY);
+    assert(hitAt(15) == walls[1].id);
+    PhysicsSolver::OverlapHit overlap;
+    assert(!solver.SphereOverlap(vector3(10, 0, 0), 0.5, overlap));
+    assert(solver.FlushActorChanges() == 1);
+    assert(inScene() == 5);
+    
+    // removals apply before additions, so a body replaced in one tick is never doubled
+    walls[1].Destroy();
+    auto replacement = makeWall(15);
+    assert(hitAt(15) == INVALID_ENTITY);
+    assert(solver.FlushActorChanges() == 2);
+    assert(inScene() == 5);
+    assert(hitAt(15) == replacement.id);
+    
+    // a body spawned and destroyed between flushes never enters the scene
+    auto brief = makeWall(100);
+    brief.Destroy();
+    assert(solver.FlushActorChanges() == 0);
+    assert(inScene() == 5);
+    
+    // calls that need the body in the scene bring the pending bodies in early
+    auto ball = w.CreatePrototype<GameObject>();
+    ball.GetTransform().SetWorldPosition(vector3(0, 20, 0));
+    auto& ballBody = ball.EmplaceComponent<RigidBodyDynamicComponent>();
+    ballBody.EmplaceCollider<SphereCollider>(0.5, material);
+    ballBody.Sleep();
+    assert(ballBody.IsSleeping());
+    assert(inScene() == 6);
+    
+    // and the tick flushes before it simulates
+    makeWall(200);
+    solver.Tick(1);
+    assert(inScene() == 7);
+    assert(hitAt(200) != INVALID_ENTITY);
+    
+    // PhysX would ignore changes made while a step is in flight, so they stay queued until it has been fetched
+    auto faller = w.CreatePrototype<GameObject>();
+    faller.GetTransform().SetWorldPosition(vector3(-50, 20, 0));
+    faller.EmplaceComponent<RigidBodyDynamicComponent>().EmplaceCollider<SphereCollider>(0.5, material);
+    solver.Tick(1);
+    assert(inScene() == 8);
+    solver.BeginTick(1);
+    auto late = makeWall(300);
+    assert(solver.FlushActorChanges() == 0);
+    // a body destroyed during the step is still in it, and must not be reported as having moved
+    faller.Destroy();
+    solver.FinishTick();
+    assert(solver.SyncActiveActors() == 0);
+    assert(inScene() == 8);
+    assert(solver.FlushActorChanges() == 2);
+    assert(inScene() == 8);
+    assert(hitAt(300) == late.id);
+    
+    return 0;
+}
+
+int Test_PhysicsDeterminism(){
+    // two identical worlds stepped on the same workers must end with bitwise identical poses
+    auto run = [](bool extraBox){
+        PhysicsTestWorld w;
+        auto& solver = w.GetSolver();
+        auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+        w.CreatePrototype<GameObject>().EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(20, 1, 20), material);
+        std::vector<Entity> bodies;
+        for(int i = 0; i < 60; i++){
+            auto e = w.CreatePrototype<GameObject>();
+            e.GetTransform().SetWorldPosition(vector3(decimalType(i % 4) * decimalType(0.9), 2 + decimalType(i / 4) * decimalType(1.05), decimalType(i % 3) * decimalType(0.3)));
+            auto& body = e.EmplaceComponent<RigidBodyDynamicComponent>();
+            if (i % 2 == 0){
+                body.EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+            }
+            else{
+                body.EmplaceCollider<SphereCollider>(0.5, material);
+            }
+            bodies.push_back(e);
+        }
+        if (extraBox){
+            auto e = w.CreatePrototype<GameObject>();
+            e.GetTransform().SetWorldPosition(vector3(1, 4, 0.5));
+            e.EmplaceComponent<RigidBodyDynamicComponent>().EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+        }
+        for(int t = 0; t < 120; t++){
+            solver.Tick(1);
+            solver.SyncActiveActors();
+        }
+        std::vector<std::pair<vector3, quaternion>> poses;
+        for(auto& e : bodies){
+            poses.push_back(e.GetComponent<RigidBodyDynamicComponent>().getDynamicsWorldPose());
+        }
+        return poses;
+    };
+    const auto first = run(false), second = run(false);
+    assert(memcmp(first.data(), second.data(), first.size() * sizeof(first[0])) == 0);
+    
+    // and the comparison is sensitive enough to notice a different scene
+    const auto disturbed = run(true);
+    assert(memcmp(first.data(), disturbed.data(), first.size() * sizeof(first[0])) != 0);
+    
+    return 0;
+}
+
+int Test_PhysicsSolverStartup(){
+    // match servers create a World per match, so a solver must not connect to PVD or set up cooking again
+    constexpr int nsolvers = 100;
+    assert(!PhysicsSolver::config.connectPVD);
+    std::vector<std::unique_ptr<PhysicsSolver>> solvers;
+    const auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < nsolvers; i++){
+        solvers.push_back(std::make_unique<PhysicsSolver>());
+    }
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    cout << "Creating " << nsolvers << " solvers took " << elapsed << " ms (" << elapsed / nsolvers << " ms each)\n";
+    assert(PhysicsSolver::pvd == nullptr);
+    for(auto& solver : solvers){
+        assert(solver->scene != nullptr);
+    }
+    
+    // cooking is created once, on first use, and shared by later solvers
+    auto cooking = PhysicsSolver::GetCooking();
+    assert(cooking != nullptr);
+    solvers.push_back(std::make_unique<PhysicsSolver>());
+    assert(PhysicsSolver::GetCooking() == cooking);
+    solvers.clear();
+    assert(PhysicsSolver::GetCooking() == cooking);
+    
+    return 0;
+}
+
+// reads and writes a body from a System that is not ordered against physics, so it may run while a step is in flight
+struct PhysicsBodyTouchSystem{
+    inline void operator()(IntComponent& writes, RigidBodyDynamicComponent& body) const{
+        // the pose written last tick, never the identity PhysX reports mid-step
+        const auto pose = body.getDynamicsWorldPose();
+        assert(pose.first.x == writes.value && pose.first.y == 5);
+        writes.value++;
+        body.setDynamicsWorldPose(vector3(writes.value, 5, 0), quaternion(1, 0, 0, 0));
+    }
+};
+
+int Test_PhysicsBodiesDuringStep(){
+    PhysicsTestWorld w;
+    auto& solver = w.GetSolver();
+    auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+    auto e = w.CreatePrototype<GameObject>();
+    e.GetTransform().SetWorldPosition(vector3(0, 5, 0));
+    e.EmplaceComponent<IntComponent>().value = 0;
+    auto& body = e.EmplaceComponent<RigidBodyDynamicComponent>();
+    body.EmplaceCollider<SphereCollider>(0.5, material);
+    body.SetGravityEnabled(false);
+    
+    // every write lands, whether the System ran before, during or after the step
+    w.EmplaceSystem<PhysicsBodyTouchSystem>();
+    constexpr int nTicks = 30;
+    for(int t = 0; t < nTicks; t++){
+        w.Tick(1);
+    }
+    assert(e.GetComponent<IntComponent>().value == nTicks);
+    assert(body.getDynamicsWorldPose().first.x == nTicks);
+    
+    // a body call made while a step is in flight waits for the step to be fetched
+    solver.BeginTick(1);
+    std::atomic<bool> started = false, finished = false;
+    std::thread reader([&]{
+        started = true;
+        body.setDynamicsWorldPose(vector3(-1, 5, 0), quaternion(1, 0, 0, 0));
+        finished = true;
+    });
+    while(!started){
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(!finished);
+    solver.FinishTick();
+    reader.join();
+    assert(body.getDynamicsWorldPose().first.x == -1);
+    
+    return 0;
+}
+
 int main(int argc, char** argv) {
     const unordered_map<std::string_view, std::function<int(void)>> tests{
 		{"CTTI",&Test_CTTI},
         {"Test_UUID",&Test_UUID},
         {"Test_AddDel",&Test_AddDel},
         {"Test_SpawnDestroy",&Test_SpawnDestroy},
-        {"Test_MoveBetweenWorlds",&Test_MoveBetweenWorlds}
+        {"Test_MoveBetweenWorlds",&Test_MoveBetweenWorlds},
+        {"Test_FrameArenaReset",&Test_FrameArenaReset},
+        {"Test_FrameArenaOverflow",&Test_FrameArenaOverflow},
+        {"Test_SpinLockContention",&Test_SpinLockContention},
+        {"Test_SystemScheduling",&Test_SystemScheduling},
+        {"Test_TimerWheel",&Test_TimerWheel},
+        {"Test_MemoryTracking",&Test_MemoryTracking},
+        {"Test_AudioMixingKernels",&Test_AudioMixingKernels},
+        {"Test_AudioStreaming",&Test_AudioStreaming},
+        {"Test_AudioVoiceManager",&Test_AudioVoiceManager},
+        {"Test_AudioDecodeCache",&Test_AudioDecodeCache},
+        {"Test_AudioGraphFilters",&Test_AudioGraphFilters},
+        {"Test_AudioRoomRenderer",&Test_AudioRoomRenderer},
+        {"Test_AudioSnapshotPublisher",&Test_AudioSnapshotPublisher},
+        {"Test_PhysicsInterpolation",&Test_PhysicsInterpolation},
+        {"Test_PhysicsBatchQueries",&Test_PhysicsBatchQueries},
+        {"Test_PhysicsContactEvents",&Test_PhysicsContactEvents},
+        {"Test_PhysicsMeshCache",&Test_PhysicsMeshCache},
+        {"Test_PhysicsPoseWrites",&Test_PhysicsPoseWrites},
+        {"Test_PhysicsDeferredActors",&Test_PhysicsDeferredActors},
+        {"Test_PhysicsDeterminism",&Test_PhysicsDeterminism},
+        {"Test_PhysicsSolverStartup",&Test_PhysicsSolverStartup},
+        {"Test_PhysicsBodiesDuringStep",&Test_PhysicsBodiesDuringStep}
     };
 	    
 	if (argc < 2){
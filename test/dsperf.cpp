@@ -6,6 +6,10 @@
 #include <RavEngine/AnimatorComponent.hpp>
 #include <RavEngine/unordered_vector.hpp>
 #include <boost/container/vector.hpp>
+#include <RavEngine/FrameAllocator.hpp>
+#include <RavEngine/SpinLock.hpp>
+#include <thread>
+#include <mutex>
 
 using namespace RavEngine;
 using namespace std;
@@ -54,6 +58,41 @@ static inline void do_test(const T& ds, const is_fn& insert_func, const es_fn& e
 }
 
 
+// the original test-and-set spinlock, kept for comparison
+struct NaiveSpinLock{
+	std::atomic_flag flag = ATOMIC_FLAG_INIT;
+	inline void lock(){
+		while(flag.test_and_set());
+	}
+	inline void unlock(){
+		flag.clear();
+	}
+};
+
+template<typename lock_t>
+static inline void lock_stress(const char* name, int nthreads){
+	constexpr auto total_iterations = 2'000'000;
+	lock_t lock;
+	uint64_t counter = 0;
+	auto dur = time([&]{
+		std::vector<std::thread> threads;
+		for(int t = 0; t < nthreads; t++){
+			threads.emplace_back([&]{
+				for(int i = 0; i < total_iterations / nthreads; i++){
+					lock.lock();
+					counter++;		// short critical section, like most engine uses
+					lock.unlock();
+				}
+			});
+		}
+		for(auto& thread : threads){
+			thread.join();
+		}
+	});
+	cout << StrFormat("{} threads, {}: {} µs (counter = {})\n", nthreads, name, dur.count(), counter);
+}
+
+
 int main(int argc, const char** argv){
 	
 	// STL vector
@@ -182,5 +221,65 @@ int main(int argc, const char** argv){
 		});
 	}
 	
+	// transient allocations: frame arena vs malloc
+	{
+		cout << ("\nFrameArena vs malloc (1000 frames of 1000 transient allocations)\n");
+		constexpr auto nframes = 1000;
+		constexpr auto nallocs = 1000;
+		uint64_t sum = 0;
+		auto dur = time([&]{
+			for (int f = 0; f < nframes; f++){
+				for (int i = 0; i < nallocs; i++){
+					auto ptr = static_cast<int*>(malloc(sizeof(int) * ((i % 64) + 1)));
+					ptr[0] = i;
+					sum += ptr[0];
+					free(ptr);
+				}
+			}
+		});
+		cout << StrFormat("malloc/free: {} µs (sum = {})\n", dur.count(), sum);
+		
+		sum = 0;
+		dur = time([&]{
+			for (int f = 0; f < nframes; f++){
+				auto& arena = FrameArena::GetThreadArena();
+				for (int i = 0; i < nallocs; i++){
+					auto ptr = arena.Allocate<int>((i % 64) + 1);
+					ptr[0] = i;
+					sum += ptr[0];
+				}
+				FrameArena::EndFrame();
+			}
+		});
+		cout << StrFormat("FrameArena: {} µs (sum = {})\n", dur.count(), sum);
+		auto stats = FrameArena::GetThreadArena().GetStatistics();
+		cout << StrFormat("FrameArena high water mark: {} bytes of {} capacity\n", stats.highWaterMark, stats.capacity);
+	}
+	
+	// lock contention under increasing oversubscription
+	{
+		cout << ("\nLock stress (2M total acquisitions)\n");
+		for (int nthreads = 2; nthreads <= 64; nthreads *= 2){
+			lock_stress<NaiveSpinLock>("naive spinlock", nthreads);
+			lock_stress<SpinLock>("SpinLock", nthreads);
+			lock_stress<std::mutex>("std::mutex", nthreads);
+		}
+		InstrumentedSpinLock lock;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 16; t++){
+			threads.emplace_back([&]{
+				for (int i = 0; i < 100'000; i++){
+					lock.lock();
+					lock.unlock();
+				}
+			});
+		}
+		for (auto& thread : threads){
+			thread.join();
+		}
+		auto& stats = lock.GetStatistics();
+		cout << StrFormat("InstrumentedSpinLock, 16 threads: {} acquisitions, {} contended, {} spins, {} sleeps, max wait {} ns\n", stats.acquisitions.load(), stats.contendedAcquisitions.load(), stats.spins.load(), stats.sleeps.load(), stats.maxWaitNanoseconds.load());
+	}
+	
 	return 0;
 }
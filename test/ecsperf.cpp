@@ -0,0 +1,185 @@
+#include <RavEngine/World.hpp>
+#include <RavEngine/Entity.hpp>
+#include <RavEngine/App.hpp>
+#include <RavEngine/Debug.hpp>
+#include <RavEngine/TimerWheel.hpp>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+using namespace RavEngine;
+using namespace std;
+
+static std::chrono::steady_clock timer;
+
+template<typename T>
+static inline std::chrono::microseconds time(const T& func){
+	auto begin_time = timer.now();
+	func();
+	auto end_time = timer.now();
+	return chrono::duration_cast<std::chrono::microseconds>(end_time - begin_time);
+}
+
+constexpr size_t nSystems = 200;
+constexpr size_t nTicks = 200;
+
+template<size_t N>
+struct BenchComponent{
+	float value = N;
+};
+
+template<size_t N>
+struct BenchSystem{
+	inline void operator()(BenchComponent<N>& c) const{
+		// a little math so the per-entity cost is not zero
+		c.value = std::sqrt(c.value * c.value + 1.0f);
+	}
+};
+
+// skewed distribution: a few Systems touch most of the entities, most touch very few
+static inline size_t EntityCountForSystem(size_t n){
+	return std::max<size_t>(1, 200'000 / std::pow(n + 1, 1.5));
+}
+
+template<size_t N>
+static inline void SetupSystem(World& w){
+	for(size_t i = 0; i < EntityCountForSystem(N); i++){
+		w.CreatePrototype<Entity>().EmplaceComponent<BenchComponent<N>>();
+	}
+	w.EmplaceSystem<BenchSystem<N>>();
+}
+
+template<size_t ... Ns>
+static inline void SetupSystems(World& w, std::index_sequence<Ns...>){
+	(SetupSystem<Ns>(w), ...);
+}
+
+struct ModeSummary{
+	size_t serial = 0, parallel = 0, fused = 0, empty = 0;
+};
+
+template<size_t ... Ns>
+static inline ModeSummary Summarize(World& w, std::index_sequence<Ns...>){
+	ModeSummary summary;
+	auto add = [&](const World::SystemStatistics& stats){
+		if (stats.lastFused){
+			summary.fused++;
+		}
+		else if (stats.lastChunkCount == 0){
+			summary.empty++;
+		}
+		else if (stats.lastChunkCount == 1){
+			summary.serial++;
+		}
+		else{
+			summary.parallel++;
+		}
+	};
+	(add(w.GetSystemStatistics<BenchSystem<Ns>>()), ...);
+	return summary;
+}
+
+static inline void RunSchedulingBenchmark(const char* name, bool adaptive){
+	World w;
+	w.systemSchedulingConfig.adaptive = adaptive;
+	SetupSystems(w, std::make_index_sequence<nSystems>{});
+
+	// let the moving averages settle
+	for(int i = 0; i < 20; i++){
+		w.Tick(1);
+	}
+
+	auto dur = time([&]{
+		for(size_t i = 0; i < nTicks; i++){
+			w.Tick(1);
+		}
+	});
+	auto summary = Summarize(w, std::make_index_sequence<nSystems>{});
+	cout << StrFormat("{}: {} µs / tick ({} serial, {} parallel, {} fused)\n", name, dur.count() / nTicks, summary.serial, summary.parallel, summary.fused);
+}
+
+constexpr size_t nTimers = 1'000'000;
+constexpr size_t nTimerTicks = 100;
+constexpr double timerTickSeconds = 1.0 / 60;
+constexpr double timerPeriod = timerTickSeconds * 100;	// 1% of the timers expire each tick
+
+// the previous DispatchAsync storage: every pending timer is visited every tick
+static inline void RunScanTimerBenchmark(){
+	struct dispatched_func{
+		double runAtTime = 0;
+		Function<void(void)> func;
+		dispatched_func(double rt, const Function<void(void)>& func) : runAtTime(rt), func(func){}
+	};
+	UnorderedContiguousSet<std::shared_ptr<dispatched_func>> timers;
+	Vector<size_t> ran;
+	size_t nfired = 0;
+	for(size_t i = 0; i < nTimers; i++){
+		timers.insert(std::make_shared<dispatched_func>(timerPeriod * i / nTimers, [&nfired]{ nfired++; }));
+	}
+	double now = 0;
+	auto dur = time([&]{
+		for(size_t t = 0; t < nTimerTicks; t++){
+			now += timerTickSeconds;
+			Vector<std::shared_ptr<dispatched_func>> reschedule;
+			for(const auto& item : timers){
+				if (now >= item->runAtTime){
+					item->func();
+					ran.push_back(timers.hash_for(item));
+					reschedule.push_back(item);
+				}
+			}
+			for(const auto hash : ran){
+				timers.erase_by_hash(hash);
+			}
+			ran.clear();
+			// keep the number of pending timers constant
+			for(auto& item : reschedule){
+				timers.insert(std::make_shared<dispatched_func>(item->runAtTime + timerPeriod, item->func));
+			}
+		}
+	});
+	cout << StrFormat("Scanned set: {} µs / tick ({} fired)\n", dur.count() / nTimerTicks, nfired);
+}
+
+static inline void RunTimerWheelBenchmark(){
+	TimerWheel wheel;
+	Vector<TimerWheel::callback_t> expired;
+	size_t nfired = 0;
+	for(size_t i = 0; i < nTimers; i++){
+		wheel.Schedule(timerPeriod * i / nTimers, [&nfired]{ nfired++; });
+	}
+	double now = 0;
+	auto dur = time([&]{
+		for(size_t t = 0; t < nTimerTicks; t++){
+			now += timerTickSeconds;
+			wheel.Advance(now, expired);
+			for(auto& func : expired){
+				func();
+				// keep the number of pending timers constant
+				wheel.Schedule(now + timerPeriod, func);
+			}
+			expired.clear();
+		}
+	});
+	cout << StrFormat("TimerWheel: {} µs / tick ({} fired, {} pending)\n", dur.count() / nTimerTicks, nfired, wheel.size());
+}
+
+int main(int argc, const char** argv){
+	App app;
+
+	size_t totalEntities = 0;
+	for(size_t i = 0; i < nSystems; i++){
+		totalEntities += EntityCountForSystem(i);
+	}
+	cout << StrFormat("{} Systems, {} entities (largest System: {}, smallest: {}), {} workers\n", nSystems, totalEntities, EntityCountForSystem(0), EntityCountForSystem(nSystems - 1), app.executor.num_workers());
+
+	RunSchedulingBenchmark("Per-entity parallel for (legacy)", false);
+	RunSchedulingBenchmark("Cost-aware scheduling", true);
+
+	cout << StrFormat("\n{} pending timers, ~1% expiring per tick\n", nTimers);
+	RunScanTimerBenchmark();
+	RunTimerWheelBenchmark();
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+#include <RavEngine/App.hpp>
+#include <RavEngine/RPCComponent.hpp>
+#include <RavEngine/RPCSystem.hpp>
+#include <RavEngine/NetworkServer.hpp>
+#include <RavEngine/DataStructures.hpp>
+#include <RavEngine/Debug.hpp>
+#include <steam/steamnetworkingsockets.h>
+#include <steam/isteamnetworkingutils.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <ctime>
+
+using namespace RavEngine;
+using namespace std;
+
+static std::chrono::steady_clock timer;
+
+template<typename T>
+static inline std::chrono::microseconds time(const T& func){
+	auto begin_time = timer.now();
+	func();
+	auto end_time = timer.now();
+	return chrono::duration_cast<std::chrono::microseconds>(end_time - begin_time);
+}
+
+constexpr size_t nRPCs = 1'000'000;
+constexpr size_t nRPCsPerTick = 10'000;
+constexpr uint16_t benchRPC = 1;
+
+// the bytes RPCComponent::SerializeRPC produces for an RPC with a single int argument
+static inline std::string SerializeIntRPC(uint16_t id, int value){
+	RPCComponent::RPCMessage<int> msg;
+	msg[0] = NetworkBase::CommandCode::RPC;
+	std::memcpy(msg.data() + RPCMsgUnpacker::code_offset, &id, sizeof(id));
+	const auto type = CTTI<int>();
+	std::memcpy(msg.data() + RPCMsgUnpacker::header_size, &type, sizeof(type));
+	std::memcpy(msg.data() + RPCMsgUnpacker::header_size + sizeof(type), &value, sizeof(value));
+	return std::string(msg.toView());
+}
+
+// a connection pair that hands messages across in memory, without sockets
+struct Loopback{
+	ISteamNetworkingSockets* net = SteamNetworkingSockets();
+	HSteamNetConnection sender = k_HSteamNetConnection_Invalid, receiver = k_HSteamNetConnection_Invalid;
+	Loopback(){
+		Debug::Assert(net->CreateSocketPair(&sender, &receiver, false, nullptr, nullptr), "Could not create a loopback connection pair");
+	}
+	~Loopback(){
+		net->CloseConnection(sender, 0, nullptr, false);
+		net->CloseConnection(receiver, 0, nullptr, false);
+	}
+	void Send(const std::vector<std::string>& messages, size_t count){
+		for(size_t i = 0; i < count; i++){
+			net->SendMessageToConnection(sender, messages[i].data(), uint32_t(messages[i].size()), NetworkBase::Reliability::Reliable, nullptr);
+		}
+	}
+	// receive exactly count messages, handing each to func, which takes ownership
+	template<typename T>
+	void Receive(size_t count, const T& func){
+		SteamNetworkingMessage_t* batch[256];
+		while(count > 0){
+			const auto n = net->ReceiveMessagesOnConnection(receiver, batch, int(std::min(count, std::size(batch))));
+			Debug::Assert(n >= 0, "Error checking for messages");
+			for(int i = 0; i < n; i++){
+				func(batch[i]);
+			}
+			count -= n;
+		}
+	}
+};
+
+// one tick's worth of RPCs sent, received and run, ten thousand at a time. The previous receive path copied each
+// message into a std::string to queue it, and RPCMsgUnpacker copied it again, so both copies are timed against
+// the current path, which queues the received message itself and unpacks it in place.
+static inline void RunRPCReceiveBenchmark(){
+	std::vector<std::string> messages;
+	for(size_t i = 0; i < nRPCsPerTick; i++){
+		messages.push_back(SerializeIntRPC(benchRPC, int(i)));
+	}
+	const int64_t expected = int64_t(nRPCsPerTick - 1) * nRPCsPerTick / 2 * (nRPCs / nRPCsPerTick);
+
+	Loopback loopback;
+	int64_t sum = 0;
+	auto handler = [&sum](RPCMsgUnpacker& upk, HSteamNetConnection){
+		sum += upk.Get<int>().value();
+	};
+
+	// the previous path
+	struct copied_rpc{
+		std::string msg;
+		bool isOwner;
+		HSteamNetConnection origin;
+	};
+	ConcurrentQueue<copied_rpc> copies;
+	std::chrono::microseconds copyTime{0};
+	for(size_t sent = 0; sent < nRPCs; sent += nRPCsPerTick){
+		loopback.Send(messages, nRPCsPerTick);
+		copyTime += time([&]{
+			loopback.Receive(nRPCsPerTick, [&](SteamNetworkingMessage_t* msg){
+				copies.enqueue({std::string(static_cast<const char*>(msg->m_pData), msg->m_cbSize), true, loopback.receiver});
+				msg->Release();
+			});
+			copied_rpc cmd;
+			while(copies.try_dequeue(cmd)){
+				std::string copy(cmd.msg);
+				RPCMsgUnpacker upk{copy};
+				handler(upk, cmd.origin);
+			}
+		});
+	}
+	Debug::Assert(sum == expected, "Copying path ran {} instead of {}", sum, expected);
+
+	// the current path, through RPCComponent and RPCSystem
+	sum = 0;
+	RPCComponent rpc(INVALID_ENTITY);
+	rpc.RegisterServerRPC(benchRPC, handler);
+	RPCSystem system;
+	std::chrono::microseconds viewTime{0};
+	for(size_t sent = 0; sent < nRPCs; sent += nRPCsPerTick){
+		loopback.Send(messages, nRPCsPerTick);
+		viewTime += time([&]{
+			loopback.Receive(nRPCsPerTick, [&](SteamNetworkingMessage_t* msg){
+				rpc.CacheServerRPC(msg, true, loopback.receiver);
+			});
+			system(rpc);
+		});
+	}
+	Debug::Assert(sum == expected, "Zero-copy path ran {} instead of {}", sum, expected);
+
+	cout << StrFormat("{} RPCs over an in-process loopback, {} per tick\n", nRPCs, nRPCsPerTick);
+	cout << StrFormat("Copy to queue, copy to unpack: {:.1f} ms ({:.0f} ns / RPC)\n", copyTime.count() / 1000.0, copyTime.count() * 1000.0 / nRPCs);
+	cout << StrFormat("Received buffer, unpacked in place: {:.1f} ms ({:.0f} ns / RPC)\n", viewTime.count() / 1000.0, viewTime.count() * 1000.0 / nRPCs);
+}
+
+constexpr uint16_t loopbackPort = 27031;
+constexpr size_t nLoopbackMessages = 500'000;
+constexpr auto idleSampleTime = std::chrono::seconds(2);
+
+// a client on localhost streaming small messages at a NetworkServer, which receives them in batches
+static inline void RunServerLoopbackBenchmark(){
+	NetworkServer server;
+	server.Start(loopbackPort);
+
+	auto net = SteamNetworkingSockets();
+	SteamNetworkingIPAddr addr;
+	addr.SetIPv4(0x7f000001, loopbackPort);
+	// localhost needs no pacing, so lift the default send rate limit
+	SteamNetworkingConfigValue_t opts[2];
+	opts[0].SetInt32(k_ESteamNetworkingConfig_SendRateMin, 256 * 1024 * 1024);
+	opts[1].SetInt32(k_ESteamNetworkingConfig_SendRateMax, 256 * 1024 * 1024);
+	const auto client = net->ConnectByIPAddress(addr, int(std::size(opts)), opts);
+	SteamNetConnectionInfo_t info;
+	do{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		net->GetConnectionInfo(client, &info);
+		Debug::Assert(info.m_eState != k_ESteamNetworkingConnectionState_ClosedByPeer && info.m_eState != k_ESteamNetworkingConnectionState_ProblemDetectedLocally, "Could not connect to the server on localhost");
+	} while(info.m_eState != k_ESteamNetworkingConnectionState_Connected);
+
+	// a world synchronization request for a world that does not exist, which the server handles without replying
+	const char message[] = {char(NetworkBase::CommandCode::ClientRequestingWorldSynchronization), 'n', 'o', 'n', 'e'};
+	auto stream = [&]{
+		const auto before = server.GetStatistics();
+		const auto elapsed = time([&]{
+			for(size_t i = 0; i < nLoopbackMessages;){
+				const auto result = net->SendMessageToConnection(client, message, sizeof(message), NetworkBase::Reliability::Reliable, nullptr);
+				if (result == k_EResultOK){
+					i++;
+				}
+				else{
+					Debug::Assert(result == k_EResultLimitExceeded, "Sending failed with {}", int(result));
+					std::this_thread::yield();		// the send buffer is full, wait for the server to catch up
+				}
+			}
+			net->FlushMessagesOnConnection(client);
+			while(server.GetStatistics().messagesReceived - before.messagesReceived < nLoopbackMessages){
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		});
+		const auto after = server.GetStatistics();
+		const auto received = after.messagesReceived - before.messagesReceived;
+		cout << StrFormat("{:.0f} messages / s, {:.1f} messages per receive call, mean latency {:.1f} us\n", received / (elapsed.count() / 1e6), double(received) / (after.receiveCalls - before.receiveCalls), double(after.totalLatencyMicroseconds - before.totalLatencyMicroseconds) / received);
+	};
+	// CPU time used by the whole process, including the networking library's own thread, while nothing is sent
+	auto idle = [&]{
+		const auto before = server.GetStatistics();
+		const auto cpuBegin = std::clock();
+		const auto wall = time([&]{
+			std::this_thread::sleep_for(idleSampleTime);
+		});
+		const auto cpu = double(std::clock() - cpuBegin) / CLOCKS_PER_SEC;
+		cout << StrFormat("Idle: {:.1f}% of a core, {} idle waits\n", cpu / (wall.count() / 1e6) * 100, server.GetStatistics().idleWaits - before.idleWaits);
+	};
+
+	cout << StrFormat("\n{} messages from a client on localhost\n", nLoopbackMessages);
+	for(auto interval : {std::chrono::microseconds(0), std::chrono::microseconds(1000)}){
+		server.idlePollInterval = interval;
+		cout << (interval.count() == 0 ? "Polling continuously (the previous loop):\n" : StrFormat("Sleeping {} us when idle:\n", interval.count()));
+		stream();
+		idle();
+	}
+	cout << StrFormat("Worst latency: {} us\n", server.GetStatistics().maxLatencyMicroseconds);
+
+	net->CloseConnection(client, 0, nullptr, false);
+}
+
+int main(int argc, const char** argv){
+	App app;
+	SteamDatagramErrMsg errMsg;
+	if (!GameNetworkingSockets_Init(nullptr, errMsg)) {
+		Debug::Fatal("Networking initialization failed: {}", errMsg);
+	}
+
+	RunRPCReceiveBenchmark();
+	RunServerLoopbackBenchmark();
+
+	GameNetworkingSockets_Kill();
+	return 0;
+}
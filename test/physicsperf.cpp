@@ -0,0 +1,593 @@
+#include <RavEngine/World.hpp>
+#include <RavEngine/GameObject.hpp>
+#include <RavEngine/App.hpp>
+#include <RavEngine/PhysicsSolver.hpp>
+#include <RavEngine/PhysicsBodyComponent.hpp>
+#include <RavEngine/PhysicsCollider.hpp>
+#include <RavEngine/PhysicsMaterial.hpp>
+#include <RavEngine/PhysicsLinkSystem.hpp>
+#include <RavEngine/Debug.hpp>
+#include <RavEngine/MeshAsset.hpp>
+#include <RavEngine/CookedMeshCache.hpp>
+#include <RavEngine/DiskCache.hpp>
+#include <RavEngine/AudioSource.hpp>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <filesystem>
+#include <functional>
+
+using namespace RavEngine;
+using namespace std;
+
+static std::chrono::steady_clock timer;
+
+template<typename T>
+static inline std::chrono::microseconds time(const T& func){
+	auto begin_time = timer.now();
+	func();
+	auto end_time = timer.now();
+	return chrono::duration_cast<std::chrono::microseconds>(end_time - begin_time);
+}
+
+// exposes the solver, so the benchmarks can step physics without running the rest of the tick
+struct PhysicsBenchWorld : public World{
+	PhysicsSolver& GetSolver(){
+		return *Solver;
+	}
+};
+
+constexpr size_t nSyncBodies = 50'000;
+constexpr size_t nSyncAwakeEvery = 50;		// 2% of the bodies are moving
+constexpr size_t nSyncTicks = 100;
+
+// a grid of bodies that never touch, most asleep and the rest drifting, so that only the cost of copying poses varies
+static inline void RunSyncBenchmark(){
+	PhysicsBenchWorld w;
+	auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+	const auto side = size_t(std::ceil(std::cbrt(nSyncBodies)));
+	Vector<Entity> awake;
+	for(size_t i = 0; i < nSyncBodies; i++){
+		auto e = w.CreatePrototype<GameObject>();
+		e.GetTransform().SetWorldPosition(vector3(i % side, (i / side) % side, i / (side * side)) * decimalType(4));
+		auto& body = e.EmplaceComponent<RigidBodyDynamicComponent>();
+		body.EmplaceCollider<SphereCollider>(0.5, material);
+		body.SetGravityEnabled(false);
+		if (i % nSyncAwakeEvery == 0){
+			body.SetLinearVelocity(vector3(0, 1, 0), true);
+			awake.push_back(e);
+		}
+		else{
+			body.Sleep();
+		}
+	}
+	auto& solver = w.GetSolver();
+
+	// the previous PhysicsLinkSystemRead: lock the scene and read the pose of every dynamic body
+	auto pollAll = [&]{
+		w.Filter([](const RigidBodyDynamicComponent& rigid, Transform& transform){
+			auto pose = rigid.getDynamicsWorldPose();
+			transform.SetWorldPosition(pose.first);
+			transform.SetWorldRotation(pose.second);
+		});
+	};
+
+	std::chrono::microseconds poll{0}, active{0};
+	uint64_t nsynced = 0;
+	for(size_t t = 0; t < nSyncTicks; t++){
+		solver.Tick(1);
+		poll += time(pollAll);
+		active += time([&]{
+			nsynced += solver.SyncActiveActors();
+		});
+	}
+
+	// the transforms of the moving bodies must match the simulation
+	for(auto& e : awake){
+		auto pose = e.GetComponent<RigidBodyDynamicComponent>().getDynamicsWorldPose();
+		Debug::Assert(e.GetTransform().GetWorldPosition() == pose.first, "Active actor sync missed a moving body");
+	}
+	cout << StrFormat("{} bodies, {} moving, {} ticks\n", nSyncBodies, awake.size(), nSyncTicks);
+	cout << StrFormat("Poll every body: {:.1f} us / tick\nActive actors: {:.1f} us / tick ({:.1f}x faster, {:.0f} poses per tick)\n", double(poll.count()) / nSyncTicks, double(active.count()) / nSyncTicks, double(poll.count()) / active.count(), double(nsynced) / nSyncTicks);
+}
+
+constexpr size_t nMixedBoxes = 4'000;
+constexpr size_t nMixedWorkers = 20'000;
+constexpr size_t nMixedSources = 20'000;
+constexpr size_t nMixedTicks = 120;
+
+// game logic that does not touch physics, so the World may run it while PhysX steps
+struct BusyComponent{
+	float value = 1;
+};
+
+struct BusySystem{
+	inline void operator()(BusyComponent& c) const{
+		for(int i = 0; i < 100; i++){
+			c.value = std::sqrt(c.value * c.value + 1.0f);
+		}
+	}
+};
+
+// a pile of boxes falling onto the ground
+static inline void CreateBoxPile(World& w, size_t nboxes){
+	auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+	auto ground = w.CreatePrototype<GameObject>();
+	ground.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(100, 1, 100), material);
+	for(size_t i = 0; i < nboxes; i++){
+		auto e = w.CreatePrototype<GameObject>();
+		e.GetTransform().SetWorldPosition(vector3(decimalType(i % 20) * decimalType(1.1), 2 + decimalType(i / 400) * decimalType(1.1), decimalType((i / 20) % 20) * decimalType(1.1)));
+		e.EmplaceComponent<RigidBodyDynamicComponent>().EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+	}
+}
+
+static inline double TimeWorld(bool physics, bool logic, bool audio){
+	World w;
+	if (physics){
+		CreateBoxPile(w, nMixedBoxes);
+	}
+	if (logic){
+		for(size_t i = 0; i < nMixedWorkers; i++){
+			w.CreatePrototype<Entity>().EmplaceComponent<BusyComponent>();
+		}
+	}
+	if (audio){
+		// the World's own audio snapshot tasks visit every source each tick
+		constexpr size_t assetFrames = 64;
+		auto asset = New<AudioAsset>(InterleavedSampleBufferView{new float[assetFrames]{0}, assetFrames}, 1);
+		for(size_t i = 0; i < nMixedSources; i++){
+			auto e = w.CreatePrototype<GameObject>();
+			e.GetTransform().SetWorldPosition(vector3(decimalType(i % 100), 0, decimalType(i / 100)));
+			e.EmplaceComponent<AudioSourceComponent>(New<SampledAudioDataProvider>(asset));
+		}
+	}
+	w.EmplaceSystem<BusySystem>();
+	auto dur = time([&]{
+		for(size_t t = 0; t < nMixedTicks; t++){
+			w.Tick(1);
+		}
+	});
+	return double(dur.count()) / nMixedTicks;
+}
+
+// the World steps PhysX without blocking a worker. The engine's audio snapshot is ordered to run during the step,
+// and independent Systems may too. Scripts and animation stay ordered around it, so they are not measured here.
+static inline void RunMixedSceneBenchmark(){
+	const auto physicsOnly = TimeWorld(true, false, false);
+	const auto logicOnly = TimeWorld(false, true, false);
+	const auto audioOnly = TimeWorld(false, false, true);
+	const auto withAudio = TimeWorld(true, false, true);
+	const auto withLogic = TimeWorld(true, true, false);
+	cout << StrFormat("\n{} falling boxes, {} audio sources, {} entities of independent game logic, {} ticks, {} workers\n", nMixedBoxes, nMixedSources, nMixedWorkers, nMixedTicks, GetApp()->executor.num_workers());
+	cout << StrFormat("Physics only: {:.1f} us / tick\nAudio snapshot only: {:.1f} us / tick\nLogic only: {:.1f} us / tick\n", physicsOnly, audioOnly, logicOnly);
+	cout << StrFormat("Physics + audio snapshot (engine tasks): {:.1f} us / tick ({:.1f} us overlapped)\n", withAudio, physicsOnly + audioOnly - withAudio);
+	cout << StrFormat("Physics + independent logic: {:.1f} us / tick ({:.1f} us overlapped)\n", withLogic, physicsOnly + logicOnly - withLogic);
+}
+
+constexpr size_t nRayBodies = 10'000;
+constexpr size_t nRays = 100'000;
+constexpr size_t nRayTicks = 10;
+constexpr uint32_t nRayMultiHits = 4;
+
+// AI and weapon code casting many rays per tick, one call each versus one batch
+static inline void RunRaycastBenchmark(){
+	PhysicsBenchWorld w;
+	auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> place(-100, 100), unit(-1, 1);
+	for(size_t i = 0; i < nRayBodies; i++){
+		auto e = w.CreatePrototype<GameObject>();
+		e.GetTransform().SetWorldPosition(vector3(place(rng), place(rng) * decimalType(0.1), place(rng)));
+		auto& body = e.EmplaceComponent<RigidBodyStaticComponent>();
+		body.EmplaceCollider<BoxCollider>(vector3(1, 1, 1), material);
+		body.setDynamicsWorldPose(e.GetTransform().GetWorldPosition(), e.GetTransform().GetWorldRotation());		// PhysicsLinkSystemWrite does this in a full tick
+	}
+	std::vector<PhysicsSolver::RayQuery> rays(nRays);
+	for(auto& ray : rays){
+		ray = {vector3(place(rng), place(rng) * decimalType(0.1), place(rng)), glm::normalize(vector3(unit(rng), unit(rng) * decimalType(0.1), unit(rng)) + vector3(1e-3, 0, 0)), 50};
+	}
+	auto& solver = w.GetSolver();
+	solver.FlushActorChanges();
+	std::vector<PhysicsSolver::RaycastHit> hits(nRays * nRayMultiHits);
+	std::vector<PhysicsSolver::BatchResult> results(nRays);
+
+	std::chrono::microseconds single{0}, batch{0}, multi{0};
+	size_t nsingle = 0, nbatch = 0, nmulti = 0;
+	for(size_t t = 0; t < nRayTicks; t++){
+		single += time([&]{
+			for(size_t i = 0; i < nRays; i++){
+				PhysicsSolver::RaycastHit hit;
+				nsingle += solver.Raycast(rays[i].origin, rays[i].direction, rays[i].maxDistance, hit);
+			}
+		});
+		batch += time([&]{
+			nbatch += solver.RaycastBatch(rays, hits, results);
+		});
+		multi += time([&]{
+			nmulti += solver.RaycastBatch(rays, hits, results, nRayMultiHits);
+		});
+	}
+	Debug::Assert(nsingle == nbatch, "Batched raycasts found {} hits, single raycasts found {}", nbatch, nsingle);
+	cout << StrFormat("\n{} rays into {} boxes, {} ticks, {} workers\n", nRays, nRayBodies, nRayTicks, GetApp()->executor.num_workers());
+	cout << StrFormat("Single raycasts: {:.1f} us / tick\nBatched, nearest hit: {:.1f} us / tick ({:.1f}x faster)\nBatched, {} nearest hits: {:.1f} us / tick ({:.1f} hits per ray)\n", double(single.count()) / nRayTicks, double(batch.count()) / nRayTicks, double(single.count()) / batch.count(), nRayMultiHits, double(multi.count()) / nRayTicks, double(nmulti) / (nRays * nRayTicks));
+}
+
+constexpr size_t nContactBoxes = 10'000;		// one resting contact each, on the box or ground below
+constexpr size_t nContactTicks = 60;
+
+// a settled pile keeps thousands of contacts persisting every step. Events are recorded during the step and delivered afterwards, grouped by body.
+static inline void RunContactEventBenchmark(){
+	PhysicsBenchWorld w;
+	CreateBoxPile(w, nContactBoxes);
+	auto& solver = w.GetSolver();
+	for(size_t t = 0; t < 20; t++){
+		solver.Tick(1);
+		solver.DispatchEvents();
+	}
+
+	// nContactTicks with nobody listening, then the same with a receiver on every box
+	size_t ncalls = 0;
+	auto listener = std::make_shared<PhysicsCallback>();
+	listener->OnColliderEnter = listener->OnColliderPersist = listener->OnColliderExit = [&ncalls](PhysicsBodyComponent&, const ContactPairPoint*, size_t){
+		ncalls++;
+	};
+	listener->OnTriggerEnter = listener->OnTriggerExit = [&ncalls](PhysicsBodyComponent&){
+		ncalls++;
+	};
+	std::chrono::microseconds step[2]{}, lookup[2]{}, dispatch[2]{};
+	uint64_t nevents[2]{};
+	for(int listening = 0; listening < 2; listening++){
+		if (listening){
+			w.Filter([&](RigidBodyDynamicComponent& body){
+				body.AddReceiver(listener);
+			});
+		}
+		for(size_t t = 0; t < nContactTicks; t++){
+			step[listening] += time([&]{
+				solver.Tick(1);
+			});
+			nevents[listening] += solver.GetEvents().size();
+			// what the old synchronous callbacks paid per pair before calling anyone: looking up both bodies
+			lookup[listening] += time([&]{
+				size_t nwanting = 0;
+				for(const auto& event : solver.GetEvents()){
+					nwanting += Entity(event.a).GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0].GetWantsContactData();
+					nwanting += Entity(event.b).GetAllComponentsPolymorphic<PhysicsBodyComponent>()[0].GetWantsContactData();
+				}
+				Debug::Assert(nwanting == 0, "No box wants contact data");
+			});
+			dispatch[listening] += time([&]{
+				solver.DispatchEvents();
+			});
+		}
+	}
+	cout << StrFormat("\n{} boxes in a pile, {} ticks, {:.0f} contact events per tick\n", nContactBoxes, nContactTicks, double(nevents[0]) / nContactTicks);
+	for(int listening = 0; listening < 2; listening++){
+		cout << StrFormat("{}: step (records events) {:.1f} us / tick, per-pair body lookup {:.1f} us / tick, dispatch {:.1f} us / tick\n", listening ? "Receiver on every box" : "No receivers", double(step[listening].count()) / nContactTicks, double(lookup[listening].count()) / nContactTicks, double(dispatch[listening].count()) / nContactTicks);
+	}
+	cout << StrFormat("{:.0f} receiver calls per tick\n", double(ncalls) / nContactTicks);
+}
+
+// rolling terrain of side * side quads, kept in system memory so that it can be cooked
+static inline Ref<MeshAsset> CreateTerrainMesh(uint32_t side){
+	MeshAsset::MeshPart part;
+	for(uint32_t z = 0; z <= side; z++){
+		for(uint32_t x = 0; x <= side; x++){
+			MeshAsset::vertex_t v{};
+			v.position[0] = x;
+			v.position[1] = std::sin(x * 0.05f) * std::cos(z * 0.05f) * 4;
+			v.position[2] = z;
+			part.vertices.push_back(v);
+		}
+	}
+	for(uint32_t z = 0; z < side; z++){
+		for(uint32_t x = 0; x < side; x++){
+			const uint32_t i = z * (side + 1) + x;
+			for(auto index : {i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2}){
+				part.indices.push_back(index);
+			}
+		}
+	}
+	return New<MeshAsset>(part, MeshAssetOptions{.keepInSystemRAM = true, .uploadToGPU = false});
+}
+
+constexpr uint32_t nCookedSide = 708;		// 708 * 708 * 2 ~ 1M triangles
+
+// the same large static mesh cooked from scratch, loaded from the disk cache, and shared from memory
+static inline void RunMeshCacheBenchmark(){
+	auto mesh = CreateTerrainMesh(nCookedSide);
+	auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+
+	auto& cache = CookedMeshCache::GetDiskCache();
+	const auto previousDirectory = cache.GetDirectory();
+	const auto dir = std::filesystem::temp_directory_path() / "rve_bench_mesh_cache";
+	std::filesystem::remove_all(dir);
+	cache.SetDirectory(dir);
+	CookedMeshCache::ReleaseAll();
+
+	PhysicsBenchWorld w;
+	auto load = [&]{
+		return time([&]{
+			w.CreatePrototype<GameObject>().EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<MeshCollider>(mesh, material);
+		});
+	};
+	auto cold = load();
+	CookedMeshCache::ReleaseAll();
+	auto warm = load();
+	auto shared = load();
+	auto stats = CookedMeshCache::GetStatistics();
+	Debug::Assert(stats.cooked == 1 && stats.diskHits == 1 && stats.memoryHits == 1, "Each load took the path it was meant to");
+
+	cout << StrFormat("\n{} triangle mesh collider, {:.1f} MiB on disk\n", nCookedSide * nCookedSide * 2, double(std::filesystem::file_size(std::filesystem::directory_iterator(dir)->path())) / (1024 * 1024));
+	cout << StrFormat("Cold (cook): {:.1f} ms, warm (disk cache): {:.1f} ms, shared (memory): {:.1f} ms\n", cold.count() / 1000.0, warm.count() / 1000.0, shared.count() / 1000.0);
+
+	CookedMeshCache::ReleaseAll();
+	cache.SetDirectory(previousDirectory);
+	std::filesystem::remove_all(dir);
+}
+
+constexpr size_t nKinematicMovers = 20'000;
+constexpr size_t nIdleStatics = 20'000;
+constexpr size_t nKinematicTicks = 50;
+
+// platforms and doors driven by game code: every kinematic body moves each tick, while a level's worth of statics stays put
+static inline void RunPoseWriteBenchmark(){
+	PhysicsBenchWorld w;
+	auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+	const auto side = size_t(std::sqrt(nKinematicMovers)) + 1;
+	Vector<Entity> movers;
+	for(size_t i = 0; i < nKinematicMovers; i++){
+		auto e = w.CreatePrototype<GameObject>();
+		e.GetTransform().SetWorldPosition(vector3(i % side, 0, i / side) * decimalType(3));
+		auto& body = e.EmplaceComponent<RigidBodyDynamicComponent>();
+		body.EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+		body.SetKinematic(true);
+		movers.push_back(e);
+	}
+	for(size_t i = 0; i < nIdleStatics; i++){
+		auto e = w.CreatePrototype<GameObject>();
+		e.GetTransform().SetWorldPosition(vector3(i % side, -10, i / side) * decimalType(3));
+		e.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(1, 0.5, 1), material);
+	}
+	auto& solver = w.GetSolver();
+	PhysicsLinkSystemWrite write;
+	write(w);
+
+	auto moveAll = [&](size_t t){
+		for(size_t i = 0; i < movers.size(); i++){
+			auto& transform = movers[i].GetTransform();
+			transform.SetWorldPosition(vector3(i % side, std::sin((t + i) * 0.1f), i / side) * decimalType(3));
+		}
+	};
+	// the previous PhysicsLinkSystemWrite: teleport every static every tick, and set each kinematic target under its own lock
+	std::chrono::microseconds perBody{}, batched{};
+	for(size_t t = 0; t < nKinematicTicks; t++){
+		moveAll(t);
+		perBody += time([&]{
+			w.Filter([](RigidBodyStaticComponent& rigid, const Transform& transform){
+				rigid.setDynamicsWorldPose(transform.GetWorldPosition(), transform.GetWorldRotation());
+			});
+			w.Filter([](RigidBodyDynamicComponent& rigid, const Transform& transform){
+				rigid.SetKinematicTarget(transform.GetWorldPosition(), transform.GetWorldRotation());
+			});
+		});
+		solver.Tick(1);
+		solver.SyncActiveActors();
+	}
+	size_t nwritten = 0;
+	for(size_t t = 0; t < nKinematicTicks; t++){
+		moveAll(t);
+		batched += time([&]{
+			nwritten += write(w);
+		});
+		solver.Tick(1);
+		solver.SyncActiveActors();
+	}
+	Debug::Assert(nwritten == nKinematicMovers * nKinematicTicks, "Only the movers are written");
+
+	cout << StrFormat("\n{} kinematic movers and {} idle statics, {} ticks\n", nKinematicMovers, nIdleStatics, nKinematicTicks);
+	cout << StrFormat("Every body, one lock each: {:.1f} us / tick\nChanged bodies, one lock: {:.1f} us / tick\n", double(perBody.count()) / nKinematicTicks, double(batched.count()) / nKinematicTicks);
+}
+
+constexpr size_t nSpawnBodies = 50'000;
+
+// a level load or a debris burst: many bodies created in one tick, then all destroyed in another
+static inline void RunSpawnBenchmark(){
+	auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+	const auto side = size_t(std::ceil(std::cbrt(nSpawnBodies)));
+	std::chrono::microseconds spawn[2]{}, destroy[2]{};
+	for(int batched = 0; batched < 2; batched++){
+		PhysicsBenchWorld w;
+		auto& solver = w.GetSolver();
+		Vector<Entity> bodies;
+		spawn[batched] = time([&]{
+			for(size_t i = 0; i < nSpawnBodies; i++){
+				auto e = w.CreatePrototype<GameObject>();
+				e.GetTransform().SetWorldPosition(vector3(i % side, (i / side) % side, i / (side * side)) * decimalType(2));
+				if (i % 2 == 0){
+					e.EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+				}
+				else{
+					e.EmplaceComponent<RigidBodyDynamicComponent>().EmplaceCollider<SphereCollider>(0.5, material);
+				}
+				if (!batched){
+					solver.FlushActorChanges();		// what each spawn used to do: add its actor under its own lock
+				}
+				bodies.push_back(e);
+			}
+			solver.FlushActorChanges();
+		});
+		destroy[batched] = time([&]{
+			for(auto& e : bodies){
+				e.Destroy();
+				if (!batched){
+					solver.FlushActorChanges();
+				}
+			}
+			solver.FlushActorChanges();
+		});
+	}
+	cout << StrFormat("\n{} bodies spawned, then destroyed\n", nSpawnBodies);
+	for(int batched = 0; batched < 2; batched++){
+		cout << StrFormat("{}: spawn {:.1f} ms, destroy {:.1f} ms\n", batched ? "One batch at the sync point" : "One scene change per body", spawn[batched].count() / 1000.0, destroy[batched].count() / 1000.0);
+	}
+}
+
+constexpr size_t nSceneTicks = 300;
+constexpr size_t nStackColumns = 100;
+constexpr size_t nStackHeight = 20;
+constexpr size_t nRagdolls = 1'000;
+constexpr uint32_t nTerrainSide = 256;
+constexpr size_t nTerrainBodies = 2'000;
+constexpr size_t nStormBoxes = 4'000;
+constexpr size_t nStormRays = 50'000;
+
+// a standard scene: how to build it, and any queries it runs against the scene after each step
+struct StandardScene{
+	const char* name;
+	std::function<void(World&)> create;
+	std::function<size_t(PhysicsSolver&)> query;
+};
+
+struct SceneTimings{
+	std::chrono::microseconds simulate{}, fetch{}, sync{}, query{}, worst{};
+};
+
+// steps the scene like World::Tick does, and returns a hash of every dynamic body's final pose
+static inline uint64_t RunStandardScene(const StandardScene& scene, SceneTimings& timings){
+	PhysicsBenchWorld w;
+	scene.create(w);
+	auto& solver = w.GetSolver();
+	uint64_t hash = 0;
+	for(size_t t = 0; t < nSceneTicks; t++){
+		size_t nhits = 0;
+		const auto simulate = time([&]{
+			solver.BeginTick(1);
+		});
+		const auto fetch = time([&]{
+			solver.FinishTick();
+		});
+		const auto sync = time([&]{
+			solver.SyncActiveActors();
+		});
+		const auto query = time([&]{
+			if (scene.query){
+				nhits = scene.query(solver);
+			}
+		});
+		hash = DiskCache::Hash(&nhits, sizeof(nhits), hash);
+		timings.simulate += simulate;
+		timings.fetch += fetch;
+		timings.sync += sync;
+		timings.query += query;
+		timings.worst = std::max(timings.worst, simulate + fetch + sync + query);
+	}
+	w.Filter([&](const RigidBodyDynamicComponent& body){
+		const auto pose = body.getDynamicsWorldPose();
+		hash = DiskCache::Hash(&pose.first, sizeof(pose.first), hash);
+		hash = DiskCache::Hash(&pose.second, sizeof(pose.second), hash);
+	});
+	return hash;
+}
+
+// the scenes a physics change is checked against. Each runs twice on the same workers, and must end bitwise identical.
+static inline void RunStandardScenes(){
+	auto material = New<PhysicsMaterial>(0.5, 0.5, 0);
+	auto createGround = [material](World& w){
+		w.CreatePrototype<GameObject>().EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<BoxCollider>(vector3(200, 1, 200), material);
+	};
+	auto terrain = CreateTerrainMesh(nTerrainSide);
+
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> place(0, 60), unit(-1, 1);
+	std::vector<PhysicsSolver::RayQuery> rays(nStormRays);
+	for(auto& ray : rays){
+		ray = {vector3(place(rng) - 10, 10, place(rng) - 10), glm::normalize(vector3(unit(rng), -1, unit(rng))), 100};
+	}
+	std::vector<PhysicsSolver::RaycastHit> hits(nStormRays);
+	std::vector<PhysicsSolver::BatchResult> results(nStormRays);
+
+	const StandardScene scenes[] = {
+		{"Box stack", [&](World& w){
+			// columns of boxes resting exactly on each other, the hardest case for the solver to keep still
+			createGround(w);
+			const auto side = size_t(std::sqrt(nStackColumns));
+			for(size_t c = 0; c < nStackColumns; c++){
+				for(size_t h = 0; h < nStackHeight; h++){
+					auto e = w.CreatePrototype<GameObject>();
+					e.GetTransform().SetWorldPosition(vector3(decimalType(c % side) * 3, decimalType(1.5) + h, decimalType(c / side) * 3));
+					e.EmplaceComponent<RigidBodyDynamicComponent>().EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+				}
+			}
+		}, nullptr},
+		{"Ragdoll pile", [&](World& w){
+			// there is no joint component, so each ragdoll is a single body of a torso, head and limbs, dropped tumbling into a heap
+			createGround(w);
+			std::mt19937 rng(3);
+			std::uniform_real_distribution<float> angle(0, 6.283f), jitter(-0.2f, 0.2f), axis(-1, 1);
+			const auto vertical = glm::angleAxis(glm::radians(decimalType(90)), vector3(0, 0, 1));
+			for(size_t i = 0; i < nRagdolls; i++){
+				auto e = w.CreatePrototype<GameObject>();
+				e.GetTransform().SetWorldPosition(vector3(decimalType(i % 10) * decimalType(1.5) + jitter(rng), 3 + decimalType(i / 100) * 2, decimalType((i / 10) % 10) * decimalType(1.5) + jitter(rng)));
+				e.GetTransform().SetWorldRotation(glm::angleAxis(decimalType(angle(rng)), glm::normalize(vector3(axis(rng), axis(rng), axis(rng)) + vector3(0, 0, 1e-3))));
+				auto& body = e.EmplaceComponent<RigidBodyDynamicComponent>();
+				body.EmplaceCollider<BoxCollider>(vector3(0.2, 0.3, 0.1), material);
+				body.EmplaceCollider<SphereCollider>(0.15, material, vector3(0, 0.45, 0));
+				body.EmplaceCollider<CapsuleCollider>(0.06, 0.2, material, vector3(-0.35, 0.2, 0));
+				body.EmplaceCollider<CapsuleCollider>(0.06, 0.2, material, vector3(0.35, 0.2, 0));
+				body.EmplaceCollider<CapsuleCollider>(0.08, 0.25, material, vector3(-0.1, -0.6, 0), vertical);
+				body.EmplaceCollider<CapsuleCollider>(0.08, 0.25, material, vector3(0.1, -0.6, 0), vertical);
+			}
+		}, nullptr},
+		{"Large static mesh", [&](World& w){
+			// debris landing on a terrain mesh, so that contact generation runs against many triangles
+			w.CreatePrototype<GameObject>().EmplaceComponent<RigidBodyStaticComponent>().EmplaceCollider<MeshCollider>(terrain, material);
+			const auto side = size_t(std::sqrt(nTerrainBodies)) + 1;
+			const auto spacing = decimalType(nTerrainSide) / side;
+			for(size_t i = 0; i < nTerrainBodies; i++){
+				auto e = w.CreatePrototype<GameObject>();
+				e.GetTransform().SetWorldPosition(vector3(decimalType(i % side) + decimalType(0.5), 8, decimalType(i / side) + decimalType(0.5)) * spacing);
+				auto& body = e.EmplaceComponent<RigidBodyDynamicComponent>();
+				if (i % 2 == 0){
+					body.EmplaceCollider<SphereCollider>(0.5, material);
+				}
+				else{
+					body.EmplaceCollider<BoxCollider>(vector3(0.5, 0.5, 0.5), material);
+				}
+			}
+		}, nullptr},
+		{"Raycast storm", [&](World& w){
+			// a pile settling while every ray is cast into it each tick
+			CreateBoxPile(w, nStormBoxes);
+		}, [&](PhysicsSolver& solver){
+			return size_t(solver.RaycastBatch(rays, hits, results));
+		}},
+	};
+
+	cout << StrFormat("\n{} ticks per scene, {} workers, PVD {}\n", nSceneTicks, GetApp()->executor.num_workers(), PhysicsSolver::pvd ? "connected" : "off");
+	for(const auto& scene : scenes){
+		SceneTimings timings[2];
+		const auto first = RunStandardScene(scene, timings[0]);
+		const auto second = RunStandardScene(scene, timings[1]);
+		Debug::Assert(first == second, "{} is not deterministic: runs ended with hashes {:016x} and {:016x}", scene.name, first, second);
+		const auto& t = timings[0];
+		cout << StrFormat("{}: simulate {:.1f} us, fetch {:.1f} us, sync {:.1f} us, queries {:.1f} us / tick, worst tick {:.1f} ms, deterministic ({:016x})\n", scene.name, double(t.simulate.count()) / nSceneTicks, double(t.fetch.count()) / nSceneTicks, double(t.sync.count()) / nSceneTicks, double(t.query.count()) / nSceneTicks, t.worst.count() / 1000.0, first);
+	}
+}
+
+int main(int argc, const char** argv){
+	App app;
+
+	RunStandardScenes();
+	RunSyncBenchmark();
+	RunMixedSceneBenchmark();
+	RunRaycastBenchmark();
+	RunContactEventBenchmark();
+	RunMeshCacheBenchmark();
+	RunPoseWriteBenchmark();
+	RunSpawnBenchmark();
+
+	return 0;
+}